@@ -0,0 +1,241 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Actuator.h"
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<algorithm>
+#include<chrono>
+#include<climits>
+#include<cmath>
+#include<cctype>
+#include<cstring>
+#include<cerrno>
+#include<exception>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/stat.h>
+
+// First line of a sysfs file, without the newline. False if it cannot be read.
+static bool readValue(const string &path, string &value){
+	ifstream file(path);
+	if (!file.is_open() || !getline(file, value)){
+		return false;
+	}
+	value.erase(value.find_last_not_of(" \t\r\n") + 1);
+	return true;
+}
+
+static int readKHz(const string &path){
+	string value;
+	if (!readValue(path, value)){
+		cerr << "Cannot read " << path << "!" << endl;
+		terminate();
+	}
+	return stoi(value);
+}
+
+// Deepest C-state number a cpuidle state stands for. POLL is 0, "C1E" and "C1-HSW" are 1. Names without a number take the index.
+static int cstateDepth(const string &name, const int index){
+	if (name == "POLL"){
+		return 0;
+	}
+	if (name.size() > 1 && (name[0] == 'C' || name[0] == 'c') && isdigit(static_cast<unsigned char>(name[1]))){
+		return stoi(name.substr(1));
+	}
+	return index;
+}
+
+// Deepest cpuidle depth a policy allows
+static int allowedDepth(const IdleState idle){
+	switch (idle){
+	case IDLE_C0I:
+	case IDLE_DVFS_ONLY:
+		return 0;
+	case IDLE_C1:
+		return 1;
+	case IDLE_C3:
+		return 3;
+	case IDLE_C6:
+		return 6;
+	default:
+		return INT_MAX; // The baseline races to halt into whatever the platform has
+	}
+}
+
+Actuator::Actuator(const string root, const int cores){
+
+	this->root = root;
+	this->freqFile.resize(cores);
+	this->frequencies.resize(cores);
+	this->idleFile.resize(cores);
+	this->idleDepth.resize(cores);
+
+	for (int core = 0; core < cores; core++){
+		string cpu = root + "/devices/system/cpu/cpu" + to_string(core);
+		string cpufreq = cpu + "/cpufreq/";
+
+		// Frequencies the core offers, or the range if it does not list them
+		auto &available = this->frequencies.at(core);
+		string list;
+		if (readValue(cpufreq + "scaling_available_frequencies", list)){
+			istringstream values(list);
+			int kHz;
+			while (values >> kHz){
+				available.push_back(kHz);
+			}
+		}
+		if (available.empty()){
+			available.push_back(readKHz(cpufreq + "cpuinfo_min_freq"));
+			available.push_back(readKHz(cpufreq + "cpuinfo_max_freq"));
+		}
+		sort(available.begin(), available.end());
+
+		string governor;
+		readValue(cpufreq + "scaling_governor", governor);
+		this->freqFile.at(core) = openFile(cpufreq + (governor == "userspace" ? "scaling_setspeed" : "scaling_max_freq"));
+
+		for (int state = 0; ; state++){
+			string dir = cpu + "/cpuidle/state" + to_string(state) + "/";
+			string name;
+			if (!readValue(dir + "name", name)){
+				break;
+			}
+			this->idleFile.at(core).push_back(openFile(dir + "disable"));
+			this->idleDepth.at(core).push_back(cstateDepth(name, state));
+		}
+	}
+}
+
+Actuator::~Actuator(){
+	for (auto &file : this->files){
+		close(file.fd);
+	}
+}
+
+int Actuator::openFile(const string path){
+
+	SysfsFile file;
+	file.path = path;
+	file.fd = open(path.c_str(), O_WRONLY);
+	if (file.fd < 0){
+		cerr << "Cannot open " << path << " for writing: " << strerror(errno) << endl;
+		terminate();
+	}
+	struct stat status;
+	file.regular = fstat(file.fd, &status) == 0 && S_ISREG(status.st_mode);
+	if (!readValue(path, file.value)){
+		file.value.clear(); // Unknown, the first apply writes it
+	}
+
+	this->files.push_back(file);
+	return this->files.size() - 1;
+}
+
+void Actuator::queue(int file, const string &value){
+	if (this->files.at(file).value == value){
+		this->noOfSkipped++;
+		return;
+	}
+	this->batch.push_back(make_pair(file, value));
+}
+
+void Actuator::flush(){
+
+	for (auto &write : this->batch){
+		SysfsFile &file = this->files.at(write.first);
+		ssize_t written;
+		do {
+			written = pwrite(file.fd, write.second.data(), write.second.size(), 0);
+		} while (written < 0 && errno == EINTR);
+
+		if (written == static_cast<ssize_t>(write.second.size()) && (!file.regular || ftruncate(file.fd, written) == 0)){
+			file.value = write.second;
+			this->noOfWrites++;
+		}
+		else {
+			this->noOfFailures++;
+			file.value.clear(); // Try again next time
+			cerr << "Writing " << write.second << " to " << file.path << " failed: " << strerror(errno) << endl;
+		}
+	}
+	this->batch.clear();
+}
+
+int Actuator::getFrequency(const int core, const double freq) const{
+	auto &available = this->frequencies.at(core);
+	double target = freq * available.back();
+	auto above = lower_bound(available.begin(), available.end(), static_cast<int>(ceil(target - 1e-6)));
+	return above == available.end() ? available.back() : *above;
+}
+
+void Actuator::apply(const PowerState &policy, const double freq){
+
+	auto start = chrono::steady_clock::now();
+
+	int depth = allowedDepth(policy.idleState);
+	for (int core = 0; core < static_cast<int>(this->freqFile.size()); core++){
+		bool active = core < policy.cores;
+		int kHz = active ? getFrequency(core, freq) : this->frequencies.at(core).front();
+		queue(this->freqFile.at(core), to_string(kHz));
+
+		for (int state = 0; state < static_cast<int>(this->idleFile.at(core).size()); state++){
+			bool enabled = !active || this->idleDepth.at(core).at(state) <= depth;
+			queue(this->idleFile.at(core).at(state), enabled ? "0" : "1");
+		}
+	}
+	flush();
+
+	this->applyTimes.record(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	this->noOfApplies++;
+}
+
+long Actuator::getApplies() const{
+	return this->noOfApplies;
+}
+
+long Actuator::getWrites() const{
+	return this->noOfWrites;
+}
+
+long Actuator::getSkipped() const{
+	return this->noOfSkipped;
+}
+
+long Actuator::getFailures() const{
+	return this->noOfFailures;
+}
+
+const LatencyHistogram &Actuator::getApplyTimes() const{
+	return this->applyTimes;
+}
@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Applies the policies SleepScale picks to the machine through the Linux cpufreq and cpuidle interfaces. The actuator manages cpu0 .. 
+cpu<cores - 1> under a sysfs root, normally /sys: 
+
+	devices/system/cpu/cpu<N>/cpufreq/cpuinfo_max_freq, cpuinfo_min_freq     kHz
+	devices/system/cpu/cpu<N>/cpufreq/scaling_available_frequencies          kHz, optional
+	devices/system/cpu/cpu<N>/cpufreq/scaling_governor                       userspace, or anything else
+	devices/system/cpu/cpu<N>/cpufreq/scaling_setspeed                       written under the userspace governor
+	devices/system/cpu/cpu<N>/cpufreq/scaling_max_freq                       written under any other governor, as a cap
+	devices/system/cpu/cpu<N>/cpuidle/state<K>/name, disable                 optional
+
+A relative frequency f runs the active cores at the lowest available frequency of at least f * cpuinfo_max_freq, so a core never runs 
+slower than the policy assumed. An idle state enables the cpuidle states no deeper than it (POLL is depth 0, "C1E" depth 1, "C6" depth 6; 
+names without a C-state number take their index) and disables the rest: C0i and DVFS_only leave only polling. Cores a multi-core policy 
+does not use are parked at the lowest frequency with every idle state enabled. 
+
+Every file is opened once. A policy becomes one batch of writes over all cores, and a write is skipped when the file already holds the 
+value, so an unchanged policy costs no system call. The time of each batch is recorded. A failed write is reported and counted, and is 
+tried again with the next policy. 
+
+For testing, the root can be a directory tree of plain files laid out as above. 
+*/
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include "PowerState.h"
+#include "LatencyHistogram.h"
+#include<string>
+#include<vector>
+#include<utility>
+using namespace std;
+
+class Actuator{
+
+private:
+	struct SysfsFile{
+		string path;
+		int fd;
+		bool regular; // A plain file of a test tree, truncated on write
+		string value; // What the file holds, as far as we know
+	};
+
+	string root;
+	vector<SysfsFile> files;
+	vector<int> freqFile; // Per core, index into files of scaling_setspeed or scaling_max_freq
+	vector<vector<int>> frequencies; // Per core, available frequencies in kHz, ascending
+	vector<vector<int>> idleFile; // Per core and cpuidle state, index into files of its disable file
+	vector<vector<int>> idleDepth; // Per core and cpuidle state
+	vector<pair<int, string>> batch; // (file, value) writes of the policy being applied
+
+	LatencyHistogram applyTimes; // ms
+	long noOfApplies = 0;
+	long noOfWrites = 0;
+	long noOfSkipped = 0;
+	long noOfFailures = 0;
+
+	int openFile(const string); // Index into files. Terminates if the file cannot be opened for writing.
+	void queue(int, const string &); // File, value. Dropped if the file holds it already.
+	void flush(); // Write the batch
+
+public:
+	Actuator(const string, const int); // Sysfs root, cores to manage. Terminates if a core has no cpufreq interface.
+	~Actuator();
+	Actuator(const Actuator &) = delete;
+	Actuator &operator=(const Actuator &) = delete;
+
+	int getFrequency(const int, const double) const; // kHz a core runs at for a relative frequency
+	void apply(const PowerState &, const double); // Policy, relative frequency to run (the policy's, or over-provisioned)
+
+	long getApplies() const;
+	long getWrites() const; // Writes issued
+	long getSkipped() const; // Writes skipped because nothing changed
+	long getFailures() const;
+	const LatencyHistogram &getApplyTimes() const;
+};
+
+#endif
@@ -0,0 +1,300 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "BatchRunner.h"
+#include "Server.h"
+#include "ThreadPool.h"
+#include<chrono>
+#include<iomanip>
+
+static vector<string> splitList(const string &field){
+	vector<string> values;
+	string value;
+	istringstream list(field);
+	while (getline(list, value, ',')){
+		if (!value.empty()){
+			values.push_back(value);
+		}
+	}
+	return values;
+}
+
+// File name without directories and without everything from the first '.'
+static string stem(const string &path){
+	string base = path.substr(path.find_last_of('/') + 1);
+	return base.substr(0, base.find('.'));
+}
+
+BatchRunner::BatchRunner(const string manifest, const Config &base, int noOfWorkers){
+
+	ifstream manifestIn;
+	openInputFile(manifest, manifestIn);
+	manifestIn.exceptions(ifstream::badbit);
+
+	string line;
+	int lineNo = 0;
+	while (getline(manifestIn, line)){
+		lineNo++;
+		this->parseLine(base, line, lineNo);
+	}
+
+	if (this->experiments.empty()){
+		cerr << "Manifest " << manifest << " has no experiments!" << endl;
+		terminate();
+	}
+
+	// Two experiments writing the same log would corrupt both
+	map<string, int> logs;
+	for (auto &e : this->experiments){
+		if (++logs[e.config.output] > 1){
+			cerr << "Experiment " << e.name << " writes log " << e.config.output << " which is already used by another experiment!" << endl;
+			terminate();
+		}
+	}
+
+	if (noOfWorkers <= 0){
+		noOfWorkers = max(1, static_cast<int>(thread::hardware_concurrency()));
+	}
+	this->noOfWorkers = min(noOfWorkers, static_cast<int>(this->experiments.size()));
+	this->results.resize(this->experiments.size());
+}
+
+void BatchRunner::parseLine(const Config &base, const string &line, int lineNo){
+
+	istringstream record(line);
+	vector<string> fields;
+	vector<string> overrides;
+	string field;
+	while (record >> field){
+		if (field.at(0) == '#'){
+			break;
+		}
+		if (field.find('=') != string::npos){
+			overrides.push_back(field);
+		}
+		else if (!overrides.empty()){
+			cerr << "Manifest line " << lineNo << ": key=value overrides must come last" << endl;
+			terminate();
+		}
+		else {
+			fields.push_back(field);
+		}
+	}
+
+	if (fields.empty() && overrides.empty()){
+		return;
+	}
+	if (fields.size() != 5 && fields.size() != 6){
+		cerr << "Manifest line " << lineNo << ": expected name trace service_cdf arrival_cdf mode [log] [key=value ...]" << endl;
+		terminate();
+	}
+
+	vector<string> names = splitList(fields.at(0));
+	vector<string> serviceCdfs = splitList(fields.at(2));
+	vector<string> arrivalCdfs = splitList(fields.at(3));
+
+	if (serviceCdfs.size() != arrivalCdfs.size()){
+		cerr << "Manifest line " << lineNo << ": service and arrival CDF lists must have the same length" << endl;
+		terminate();
+	}
+
+	/*
+	Every dimension sets one or more configuration keys to one of its rows of values. The line expands to the cartesian product of the 
+	dimensions. The service and arrival CDFs form a single dimension so that they stay paired. 
+	*/
+	struct Dimension{
+		vector<string> keys;
+		vector<vector<string>> rows;
+	};
+	vector<Dimension> dimensions;
+
+	dimensions.push_back(Dimension{ { "trace" }, {} });
+	for (auto &trace : splitList(fields.at(1))){
+		dimensions.back().rows.push_back({ trace });
+	}
+	dimensions.push_back(Dimension{ { "service_cdf", "arrival_cdf" }, {} });
+	for (int w = 0; w < serviceCdfs.size(); w++){
+		dimensions.back().rows.push_back({ serviceCdfs.at(w), arrivalCdfs.at(w) });
+	}
+	dimensions.push_back(Dimension{ { "run_as" }, {} });
+	for (auto &mode : splitList(fields.at(4))){
+		dimensions.back().rows.push_back({ mode });
+	}
+	for (auto &o : overrides){
+		string key = o.substr(0, o.find('='));
+		dimensions.push_back(Dimension{ { key }, {} });
+		for (auto &value : splitList(o.substr(o.find('=') + 1))){
+			dimensions.back().rows.push_back({ value });
+		}
+	}
+
+	int noOfCombinations = 1;
+	for (auto &d : dimensions){
+		noOfCombinations = noOfCombinations * d.rows.size();
+	}
+	if (noOfCombinations == 0){
+		cerr << "Manifest line " << lineNo << ": empty list" << endl;
+		terminate();
+	}
+	if (names.size() != 1 || (noOfCombinations > 1 && names.at(0) != "-") || (noOfCombinations > 1 && fields.size() == 6)){
+		cerr << "Manifest line " << lineNo << ": a line with several experiments must be named \"-\" and cannot set the log" << endl;
+		terminate();
+	}
+
+	for (int c = 0; c < noOfCombinations; c++){
+		Experiment e;
+		e.config = base;
+		string suffix;
+
+		// Decode c as a mixed-radix number, one digit per dimension
+		int rest = c;
+		for (int d = dimensions.size() - 1; d >= 0; d--){
+			const vector<string> &row = dimensions.at(d).rows.at(rest % dimensions.at(d).rows.size());
+			rest = rest / dimensions.at(d).rows.size();
+			for (int k = 0; k < row.size(); k++){
+				e.config.set(dimensions.at(d).keys.at(k), row.at(k));
+			}
+			if (d >= 3){
+				suffix = "." + dimensions.at(d).keys.at(0) + "=" + row.at(0) + suffix;
+			}
+		}
+
+		e.name = names.at(0) == "-" ? stem(e.config.trace) + "." + stem(e.config.serviceCdf) + "." + e.config.runAs + suffix : names.at(0);
+		e.config.output = fields.size() == 6 ? fields.at(5) : e.name;
+		if (!e.config.checkpoint.empty()){
+			e.config.checkpoint = e.config.checkpoint + "." + e.name; // One checkpoint per experiment
+		}
+		if (!e.config.metrics.empty()){
+			e.config.metrics = e.config.metrics + "." + e.name;
+		}
+		e.config.sweepThreads = 1; // The pool already keeps every core busy
+		e.config.check();
+
+		// Fail now rather than after the other experiments have run for an hour
+		ifstream traceIn;
+		openInputFile(e.config.trace, traceIn);
+		this->loadCdf(e.config.serviceCdf);
+		this->loadCdf(e.config.arrivalCdf);
+
+		this->experiments.push_back(e);
+	}
+}
+
+shared_ptr<const EmpiricalDistribution> BatchRunner::loadCdf(const string &fileName){
+
+	auto found = this->cdfCache.find(fileName);
+	if (found != this->cdfCache.end()){
+		return found->second;
+	}
+
+	auto dist = loadCdfTable(fileName);
+	this->cdfCache[fileName] = dist;
+	return dist;
+}
+
+int BatchRunner::getSize() const{
+	return this->experiments.size();
+}
+
+void BatchRunner::run(){
+
+	cout << "Running " << this->experiments.size() << " experiments on " << this->noOfWorkers << " threads" << endl;
+
+	ThreadPool pool(this->noOfWorkers);
+
+	pool.parallelFor(this->experiments.size(), [this](int i){
+		const Experiment &e = this->experiments.at(i);
+		auto start = chrono::steady_clock::now();
+
+		Server server(e.config);
+		server.run(e.config.trace, *this->cdfCache.at(e.config.serviceCdf), *this->cdfCache.at(e.config.arrivalCdf));
+
+		this->results.at(i) = collectResult(server, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	});
+}
+
+void BatchRunner::writeResults(const string fileName) const{
+
+	ofstream out;
+	openOutputFile(fileName, out);
+
+	out << "name\ttrace\tservice_cdf\tarrival_cdf\tmode\t";
+	writeResultHeader(out);
+	for (int i = 0; i < this->experiments.size(); i++){
+		const Experiment &e = this->experiments.at(i);
+		out << e.name << "\t" << e.config.trace << "\t" << e.config.serviceCdf << "\t" << e.config.arrivalCdf << "\t" << e.config.runAs << "\t";
+		writeResult(out, this->results.at(i));
+	}
+	out.close();
+}
+
+ExperimentResult collectResult(const Server &server, double seconds){
+	ExperimentResult r;
+	double target = server.config.slowdown * server.config.serTime;
+	r.noOfMinutes = server.minute;
+	r.noOfJobs = server.totalNoOfJobs;
+	r.runER = server.ER / server.totalNoOfJobs / target;
+	r.baselineER = server.ER_baseline / server.totalNoOfJobs_baseline / target;
+	r.runEP = server.EP / server.totalRunTime;
+	r.baselineEP = server.EP_baseline / server.totalRunTime_baseline;
+	r.estErrorAbs = server.estimator->estErrorAbs / server.estimator->noOfObserved;
+	r.estErrorPerc = server.estimator->estErrorPerc / server.estimator->noOfObserved;
+	r.seconds = seconds;
+#ifdef PROFILE_PHASES
+	for (int p = 0; p < NO_OF_PHASES; p++){
+		r.phaseMs[p] = server.profile.getTotal(static_cast<Phase>(p));
+	}
+#endif
+	return r;
+}
+
+void writeResultHeader(ostream &out){
+	out << "minutes\tjobs\trunER\tbaselineER\trunEP\tbaselineEP\testErrorAbs\testErrorPerc\tseconds";
+#ifdef PROFILE_PHASES
+	for (int p = 0; p < NO_OF_PHASES; p++){
+		out << "\t" << phaseName(static_cast<Phase>(p)) << "_ms";
+	}
+#endif
+	out << endl;
+}
+
+void writeResult(ostream &out, const ExperimentResult &r){
+	out << setprecision(10) << r.noOfMinutes << "\t" << r.noOfJobs << "\t" << r.runER << "\t" << r.baselineER << "\t" << r.runEP << "\t" << 
+		r.baselineEP << "\t" << r.estErrorAbs << "\t" << r.estErrorPerc << "\t" << r.seconds;
+#ifdef PROFILE_PHASES
+	for (int p = 0; p < NO_OF_PHASES; p++){
+		out << "\t" << r.phaseMs[p];
+	}
+#endif
+	out << endl;
+}
@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Batch runner. Runs many SleepScale experiments (trace x workload x run mode) at the same time and writes one results table.
+
+The manifest has one experiment per line: 
+	name trace service_cdf arrival_cdf mode [log] [key=value ...]
+Lines starting with '#' are comments. key=value fields override the configuration (Config.h) of that line only. A field may list several 
+values separated by commas and the line expands to every combination, except that service_cdf and arrival_cdf lists are paired element 
+by element because together they describe one workload. A name of "-" is replaced by trace.workload.mode plus the overrides, and the log 
+defaults to the name. 
+
+Every experiment gets its own Server and log. Each Server simulates its policies on one thread and the experiments are spread over a 
+work-stealing pool instead, so the cores stay busy without oversubscription. A CDF file is read once and the sampling table is shared 
+read-only by every experiment using it. 
+*/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "EmpiricalDistribution.h"
+#include "Config.h"
+#include "Profiler.h"
+#include<string>
+#include<vector>
+#include<map>
+#include<memory>
+using namespace std;
+
+class Server;
+
+struct Experiment{
+	string name;
+	Config config; // Trace, CDFs, run mode and log included
+};
+
+struct ExperimentResult{
+	int noOfMinutes = 0;
+	int noOfJobs = 0;
+	double runER = 0; // Normalized by slowdown * ser_time, as printed by a single run
+	double baselineER = 0;
+	double runEP = 0;
+	double baselineEP = 0;
+	double estErrorAbs = 0;
+	double estErrorPerc = 0;
+	double seconds = 0; // Wall clock time of the experiment
+#ifdef PROFILE_PHASES
+	double phaseMs[NO_OF_PHASES] = {}; // Time per phase (Profiler.h)
+#endif
+};
+
+class BatchRunner{
+
+private:
+	vector<Experiment> experiments;
+	vector<ExperimentResult> results;
+	map<string, shared_ptr<const EmpiricalDistribution>> cdfCache; // CDF file -> sampling table
+	int noOfWorkers;
+
+	void parseLine(const Config &, const string &, int);
+	shared_ptr<const EmpiricalDistribution> loadCdf(const string &);
+
+public:
+	BatchRunner(const string, const Config &, int); // Manifest, configuration every line starts from, number of concurrent experiments (0 uses all hardware threads)
+	void run();
+	void writeResults(const string) const; // Tab separated table, one row per experiment
+	int getSize() const;
+};
+
+// Shared by the batch runner and the parameter sweep
+ExperimentResult collectResult(const Server &, double); // Finished server, wall clock seconds
+void writeResultHeader(ostream &);
+void writeResult(ostream &, const ExperimentResult &);
+
+#endif
@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Checkpoint.h"
+#include<iostream>
+#include<cstring>
+#include<cstdio>
+#include<exception>
+
+CheckpointWriter::CheckpointWriter(const string fileName, const CheckpointHeader &fields){
+
+	this->fileName = fileName;
+	this->tempName = fileName + ".tmp";
+	this->out.open(this->tempName, ios::out | ios::binary | ios::trunc);
+	if (!this->out.is_open()){
+		cerr << "File " << this->tempName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	CheckpointHeader header = fields;
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header.version = CHECKPOINT_VERSION;
+	header.headerSize = sizeof(CheckpointHeader);
+	put(header);
+}
+
+void CheckpointWriter::put(const string &value){
+	put(static_cast<uint64_t>(value.size()));
+	this->out.write(value.data(), value.size());
+}
+
+void CheckpointWriter::put(const vector<string> &values){
+	put(static_cast<uint64_t>(values.size()));
+	for (auto &value : values){
+		put(value);
+	}
+}
+
+void CheckpointWriter::put(const double *values, uint64_t size){
+	put(size);
+	this->out.write(reinterpret_cast<const char *>(values), size * sizeof(double));
+}
+
+void CheckpointWriter::commit(){
+	this->out.close();
+	if (this->out.fail() || rename(this->tempName.c_str(), this->fileName.c_str()) != 0){
+		cerr << "Checkpoint " << this->fileName << " cannot be written!" << endl;
+		terminate();
+	}
+}
+
+
+CheckpointReader::CheckpointReader(const string fileName){
+
+	this->fileName = fileName;
+	this->in.open(fileName, ios::in | ios::binary);
+	if (!this->in.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	this->in.read(reinterpret_cast<char *>(&this->header), sizeof(CheckpointHeader));
+	bool valid = this->in.gcount() == sizeof(CheckpointHeader) && memcmp(this->header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0 && 
+		this->header.version == CHECKPOINT_VERSION && this->header.headerSize == sizeof(CheckpointHeader);
+	if (!valid){
+		cerr << "File " << fileName << " is not a checkpoint of this version of SleepScale!" << endl;
+		terminate();
+	}
+}
+
+const CheckpointHeader &CheckpointReader::getHeader() const{
+	return this->header;
+}
+
+void CheckpointReader::check(){
+	if (!this->in){
+		cerr << "Checkpoint " << this->fileName << " is truncated!" << endl;
+		terminate();
+	}
+}
+
+void CheckpointReader::get(string &value){
+	uint64_t size;
+	get(size);
+	value.resize(size);
+	this->in.read(&value[0], size);
+	check();
+}
+
+void CheckpointReader::get(vector<string> &values){
+	uint64_t size;
+	get(size);
+	values.resize(size);
+	for (auto &value : values){
+		get(value);
+	}
+}
+
+void CheckpointReader::get(double *values, uint64_t size){
+	uint64_t stored;
+	get(stored);
+	if (stored != size){
+		cerr << "Checkpoint " << this->fileName << " holds " << stored << " values where " << size << " are expected!" << endl;
+		terminate();
+	}
+	this->in.read(reinterpret_cast<char *>(values), size * sizeof(double));
+	check();
+}
+
+
+bool isCheckpoint(const string fileName){
+	char magic[sizeof(CHECKPOINT_MAGIC)] = {};
+	ifstream in(fileName, ios::binary);
+	in.read(magic, sizeof(magic));
+	return in.gcount() == sizeof(magic) && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0;
+}
+
+uint64_t checkpointConfigHash(const Config &config){
+
+	// FNV-1a over the values as they are logged, as policyConfigHash
+	uint64_t hash = 14695981039346656037ULL;
+	for (auto &name : Config::keys){
+		if (name == "seed" || name == "output" || name == "log_level" || name == "log_binary" || name == "sweep_threads" || 
+			name == "checkpoint" || name == "checkpoint_interval" || name == "resume" || name == "metrics"){
+			continue;
+		}
+		string field = name + "=" + config.get(name) + "|";
+		for (unsigned char c : field){
+			hash = (hash ^ c) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
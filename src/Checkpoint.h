@@ -0,0 +1,158 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Checkpoints of a replay. Server::saveCheckpoint writes everything a run carries from one minute to the next into one binary file, and 
+Server::restoreCheckpoint puts it back, so a long replay that was stopped continues where the checkpoint was taken instead of starting 
+over. Layout, in native byte order: 
+
+	CheckpointHeader       magic, version, the configuration hash and the minute
+	sections               written and read in the same order by the classes that own the state (Server, JobHistory, Estimator, 
+	                       MultiCoreQueue): plain values as they are, vectors, deques and strings as a uint64 count followed by the elements
+
+A checkpoint holds for one configuration only (checkpointConfigHash); a server refuses one taken with other parameters. The file is 
+written next to its final name and renamed over it, so a run killed while writing leaves the previous checkpoint intact. Caches that 
+only save work (the incremental sweep) are not written; they are rebuilt on the first step after a resume. 
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Config.h"
+#include<string>
+#include<vector>
+#include<deque>
+#include<fstream>
+#include<cstdint>
+#include<type_traits>
+using namespace std;
+
+struct CheckpointHeader{
+	char magic[8]; // CHECKPOINT_MAGIC
+	uint32_t version;
+	uint32_t headerSize; // sizeof(CheckpointHeader)
+	uint64_t configHash; // checkpointConfigHash of the configuration of the run
+	uint64_t seed; // Workload seed of the run, which a resumed run keeps
+	int64_t minute; // Next minute the run steps through
+};
+
+#define CHECKPOINT_MAGIC "SSCKP01"
+#define CHECKPOINT_VERSION 4
+
+class CheckpointWriter{
+
+private:
+	string fileName;
+	string tempName; // Written first, renamed to fileName by commit
+	ofstream out;
+
+public:
+	CheckpointWriter(const string, const CheckpointHeader &); // File, header. Terminates if it cannot be created.
+
+	template<class T>
+	void put(const T &value){
+		static_assert(is_trivially_copyable<T>::value, "Only plain values are written as they are");
+		this->out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+	}
+
+	template<class T>
+	void put(const vector<T> &values){
+		static_assert(is_trivially_copyable<T>::value, "Only vectors of plain values are written as they are");
+		put(static_cast<uint64_t>(values.size()));
+		this->out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+	}
+
+	template<class T>
+	void put(const deque<T> &values){
+		put(static_cast<uint64_t>(values.size()));
+		for (auto &value : values){
+			put(value);
+		}
+	}
+
+	void put(const string &);
+	void put(const vector<string> &);
+	void put(const double *, uint64_t); // An array, written like a vector
+
+	void commit(); // Flush and replace the checkpoint. Terminates on a write error.
+};
+
+class CheckpointReader{
+
+private:
+	string fileName;
+	ifstream in;
+	CheckpointHeader header;
+
+	void check(); // Terminate on a short read
+
+public:
+	CheckpointReader(const string); // Read the header. Terminates if the file is not a checkpoint.
+
+	const CheckpointHeader &getHeader() const;
+
+	template<class T>
+	void get(T &value){
+		static_assert(is_trivially_copyable<T>::value, "Only plain values are read as they are");
+		this->in.read(reinterpret_cast<char *>(&value), sizeof(T));
+		check();
+	}
+
+	template<class T>
+	void get(vector<T> &values){
+		static_assert(is_trivially_copyable<T>::value, "Only vectors of plain values are read as they are");
+		uint64_t size;
+		get(size);
+		values.resize(size);
+		this->in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+		check();
+	}
+
+	template<class T>
+	void get(deque<T> &values){
+		uint64_t size;
+		get(size);
+		values.resize(size);
+		for (auto &value : values){
+			get(value);
+		}
+	}
+
+	void get(string &);
+	void get(vector<string> &);
+	void get(double *, uint64_t); // An array of exactly this size. Terminates if the checkpoint holds another.
+};
+
+bool isCheckpoint(const string); // Does the file exist and start with the checkpoint magic?
+uint64_t checkpointConfigHash(const Config &); // Hash of every key that changes the run, i.e. all but the seed, outputs, logging, threads and checkpointing
+
+#endif
@@ -0,0 +1,189 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "CompiledCdf.h"
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<cstring>
+#include<exception>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+static_assert(sizeof(CompiledCdfHeader) == 128, "The compiled CDF header is part of the file format");
+
+CompiledCdf::CompiledCdf(const string fileName){
+
+	this->fileName = fileName;
+
+	int fd = open(fileName.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	this->length = info.st_size;
+	if (this->length < sizeof(CompiledCdfHeader)){
+		cerr << "File " << fileName << " is not a compiled CDF!" << endl;
+		terminate();
+	}
+
+	void *mapped = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED){
+		cerr << "File " << fileName << " cannot be mapped!" << endl;
+		terminate();
+	}
+	this->data = static_cast<const char *>(mapped);
+	this->header = reinterpret_cast<const CompiledCdfHeader *>(this->data);
+
+	const CompiledCdfHeader &h = *this->header;
+	size_t arrayBytes = h.noOfRows * sizeof(double);
+	bool valid = memcmp(h.magic, COMPILED_CDF_MAGIC, sizeof(COMPILED_CDF_MAGIC)) == 0;
+	valid = valid && h.version == COMPILED_CDF_VERSION && h.headerSize == sizeof(CompiledCdfHeader) && h.noOfRows > 0;
+	valid = valid && h.sampleOffset % COMPILED_CDF_ALIGN == 0 && h.probOffset % COMPILED_CDF_ALIGN == 0;
+	valid = valid && h.sampleOffset >= sizeof(CompiledCdfHeader) && h.sampleOffset + arrayBytes <= this->length;
+	valid = valid && h.probOffset >= sizeof(CompiledCdfHeader) && h.probOffset + arrayBytes <= this->length;
+
+	if (!valid){
+		cerr << "File " << fileName << " is not a valid compiled CDF (version " << COMPILED_CDF_VERSION << ")! Recompile it with tools/cdfcompile." << endl;
+		terminate();
+	}
+}
+
+CompiledCdf::~CompiledCdf(){
+	if (this->data != nullptr){
+		munmap(const_cast<char *>(this->data), this->length);
+	}
+}
+
+const CompiledCdfHeader &CompiledCdf::getHeader() const{
+	return *this->header;
+}
+
+const double *CompiledCdf::getSamples() const{
+	return reinterpret_cast<const double *>(this->data + this->header->sampleOffset);
+}
+
+const double *CompiledCdf::getProbs() const{
+	return reinterpret_cast<const double *>(this->data + this->header->probOffset);
+}
+
+int CompiledCdf::getSize() const{
+	return this->header->noOfRows;
+}
+
+bool isCompiledCdf(const string fileName){
+	char magic[sizeof(COMPILED_CDF_MAGIC)] = {};
+	ifstream in(fileName, ios::binary);
+	in.read(magic, sizeof(magic));
+	return in.gcount() == sizeof(magic) && memcmp(magic, COMPILED_CDF_MAGIC, sizeof(magic)) == 0;
+}
+
+double bigHouseCdfScale(const string fileName){
+
+	string base = fileName.substr(fileName.find_last_of('/') + 1);
+
+	// BigHouse stores Google search CDF in "second" unit. Need to scale by 1000. 
+	if (base.compare("search.service.cdf") == 0){
+		return 1000;
+	}
+	// Multiply by 16 because there are 16 servers. 
+	if (base.compare("search.arrival.cdf") == 0){
+		return 1000 * 16;
+	}
+	return 1;
+}
+
+string checkCdf(const vector<double> &sample, const vector<double> &prob){
+
+	ostringstream error;
+
+	if (sample.empty() || sample.size() != prob.size()){
+		error << "expected the same, non-zero number of samples and probabilities";
+		return error.str();
+	}
+
+	for (int k = 0; k < sample.size(); k++){
+		if (!(prob.at(k) >= 0 && prob.at(k) <= 1)){
+			error << "row " << k + 1 << ": probability " << prob.at(k) << " is outside [0, 1]";
+			return error.str();
+		}
+		if (k > 0 && !(sample.at(k) >= sample.at(k - 1))){
+			error << "row " << k + 1 << ": sample " << sample.at(k) << " is smaller than the previous one";
+			return error.str();
+		}
+		if (k > 0 && !(prob.at(k) >= prob.at(k - 1))){
+			error << "row " << k + 1 << ": probability " << prob.at(k) << " is smaller than the previous one";
+			return error.str();
+		}
+	}
+
+	return "";
+}
+
+void writeCompiledCdf(const string fileName, const vector<double> &sample, const vector<double> &prob, const CompiledCdfHeader &fields){
+
+	CompiledCdfHeader header = fields;
+	size_t arrayBytes = sample.size() * sizeof(double);
+	size_t paddedBytes = (arrayBytes + COMPILED_CDF_ALIGN - 1) / COMPILED_CDF_ALIGN * COMPILED_CDF_ALIGN;
+
+	memcpy(header.magic, COMPILED_CDF_MAGIC, sizeof(COMPILED_CDF_MAGIC));
+	header.version = COMPILED_CDF_VERSION;
+	header.headerSize = sizeof(CompiledCdfHeader);
+	header.noOfRows = sample.size();
+	header.sampleOffset = COMPILED_CDF_ALIGN * ((sizeof(CompiledCdfHeader) + COMPILED_CDF_ALIGN - 1) / COMPILED_CDF_ALIGN);
+	header.probOffset = header.sampleOffset + paddedBytes;
+
+	ofstream out(fileName, ios::binary);
+	if (!out.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	vector<char> padding(COMPILED_CDF_ALIGN, 0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(padding.data(), header.sampleOffset - sizeof(header));
+	out.write(reinterpret_cast<const char *>(sample.data()), arrayBytes);
+	out.write(padding.data(), paddedBytes - arrayBytes);
+	out.write(reinterpret_cast<const char *>(prob.data()), arrayBytes);
+	out.write(padding.data(), paddedBytes - arrayBytes);
+
+	if (!out.good()){
+		cerr << "Writing " << fileName << " failed!" << endl;
+		terminate();
+	}
+}
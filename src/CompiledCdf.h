@@ -0,0 +1,100 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Compiled CDF. A BigHouse CDF converted once by tools/cdfcompile.cpp into a binary file that loads with a single mmap instead of being 
+parsed on every launch. Layout, in native byte order: 
+
+	CompiledCdfHeader (128 bytes)   magic, version, rows, unit and scale of the samples, moments of the sampled distribution
+	samples                         noOfRows doubles at sampleOffset, already scaled to the unit in the header
+	cumulative probabilities        noOfRows doubles at probOffset
+
+Both arrays start on a 64-byte boundary. The converter checks that samples and probabilities are non-decreasing and within range, so a compiled 
+file is used without further checks. loadCdfTable (Server.h) accepts compiled and text CDFs alike. 
+*/
+
+#ifndef COMPILEDCDF_H
+#define COMPILEDCDF_H
+
+#include<string>
+#include<vector>
+#include<cstdint>
+using namespace std;
+
+struct CompiledCdfHeader{
+	char magic[8]; // COMPILED_CDF_MAGIC
+	uint32_t version;
+	uint32_t headerSize; // sizeof(CompiledCdfHeader)
+	uint64_t noOfRows;
+	uint64_t sampleOffset; // Bytes from the start of the file
+	uint64_t probOffset;
+	double scale; // Factor applied to the samples of the text CDF
+	double mean; // Mean of the values the sampler draws (bucket midpoints)
+	double secondMoment; // E[X^2] of the same
+	double minSample;
+	double maxSample;
+	double tailMass; // 1 - last probability. The sampler puts it into the last bucket.
+	char unit[16]; // Unit of the scaled samples, e.g., "ms"
+	char source[24]; // Base name of the text CDF
+};
+
+#define COMPILED_CDF_MAGIC "SSCDF01"
+#define COMPILED_CDF_VERSION 1
+#define COMPILED_CDF_ALIGN 64
+
+class CompiledCdf{
+
+private:
+	string fileName;
+	const char *data = nullptr;
+	size_t length = 0;
+	const CompiledCdfHeader *header = nullptr;
+
+public:
+	CompiledCdf(const string); // Map a compiled CDF. Terminates if the file is not one.
+	~CompiledCdf();
+	CompiledCdf(const CompiledCdf &) = delete;
+	CompiledCdf &operator=(const CompiledCdf &) = delete;
+
+	const CompiledCdfHeader &getHeader() const;
+	const double *getSamples() const;
+	const double *getProbs() const;
+	int getSize() const;
+};
+
+bool isCompiledCdf(const string); // Does the file start with the compiled CDF magic?
+double bigHouseCdfScale(const string); // Scale of the samples of a text BigHouse CDF, chosen by its base name
+string checkCdf(const vector<double> &, const vector<double> &); // Samples, probabilities. Empty if valid, otherwise what is wrong.
+void writeCompiledCdf(const string, const vector<double> &, const vector<double> &, const CompiledCdfHeader &); // Output, scaled samples, probabilities, header fields to keep
+
+#endif
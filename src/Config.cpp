@@ -0,0 +1,407 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "Config.h"
+#include<sstream>
+#include<fstream>
+#include<algorithm>
+#include<random>
+
+const vector<string> Config::keys = { "update_interval", "est_lookback", "slowdown", "slo_percentile", "ser_time", "no_freq", "over_prov", "over_prov_amount", 
+	"baseline", "core_act_max_pwr", "plat_idle_pwr", "plat_act_max_pwr", "wakeup_c0i", "wakeup_c1", "wakeup_c3", "wakeup_c6", "warm_up", 
+	"sweep_threads", "log_level", "log_binary", "platform", "cores", "core_queue", "run_as", "trace", "trace_reader", "service_cdf", "arrival_cdf", "seed", 
+	"policy_table", "policy_table_refresh", "decision_budget", "actuator", "checkpoint", 
+	"checkpoint_interval", "resume", "metrics", "output" };
+
+static const char *logLevelNames[] = { "off", "summary", "info", "debug" };
+
+static void badValue(const string &key, const string &value){
+	cerr << "Invalid value \"" << value << "\" for configuration key " << key << endl;
+	terminate();
+}
+
+static int parseInt(const string &key, const string &value){
+	size_t used = 0;
+	int parsed = 0;
+	try{
+		parsed = stoi(value, &used);
+	}
+	catch (const exception &e){
+		badValue(key, value);
+	}
+	if (used != value.size()){
+		badValue(key, value);
+	}
+	return parsed;
+}
+
+static double parseDouble(const string &key, const string &value){
+	size_t used = 0;
+	double parsed = 0;
+	try{
+		parsed = stod(value, &used);
+	}
+	catch (const exception &e){
+		badValue(key, value);
+	}
+	if (used != value.size()){
+		badValue(key, value);
+	}
+	return parsed;
+}
+
+static uint64_t parseSeed(const string &key, const string &value){
+	size_t used = 0;
+	uint64_t parsed = 0;
+	try{
+		parsed = stoull(value, &used, 0);
+	}
+	catch (const exception &e){
+		badValue(key, value);
+	}
+	if (used != value.size() || value.find('-') != string::npos){
+		badValue(key, value);
+	}
+	return parsed;
+}
+
+static bool parseBool(const string &key, const string &value){
+	if (value == "1" || value == "true" || value == "yes" || value == "on"){
+		return true;
+	}
+	if (value == "0" || value == "false" || value == "no" || value == "off"){
+		return false;
+	}
+	badValue(key, value);
+	return false;
+}
+
+static string toString(double value){
+	ostringstream out;
+	out.precision(17);
+	out << value;
+	return out.str();
+}
+
+void Config::set(const string &key, const string &value){
+
+	if (key == "update_interval"){
+		this->updateInterval = parseInt(key, value);
+	}
+	else if (key == "est_lookback"){
+		this->estLookback = parseInt(key, value);
+	}
+	else if (key == "slowdown"){
+		this->slowdown = parseDouble(key, value);
+	}
+	else if (key == "slo_percentile"){
+		this->sloPercentile = parseDouble(key, value);
+	}
+	else if (key == "ser_time"){
+		this->serTime = parseDouble(key, value);
+	}
+	else if (key == "no_freq"){
+		this->noFreq = parseInt(key, value);
+	}
+	else if (key == "over_prov"){
+		this->overProvision = parseBool(key, value);
+	}
+	else if (key == "over_prov_amount"){
+		this->overProvAmount = parseDouble(key, value);
+	}
+	else if (key == "baseline"){
+		if (value != "NO_PWR_CNTRL" && value != "R2H_C3" && value != "R2H_C6"){
+			badValue(key, value);
+		}
+		this->baseline = value;
+	}
+	else if (key == "core_act_max_pwr"){
+		this->coreActMaxPwr = parseDouble(key, value);
+	}
+	else if (key == "plat_idle_pwr"){
+		this->platIdlePwr = parseDouble(key, value);
+	}
+	else if (key == "plat_act_max_pwr"){
+		this->platActMaxPwr = parseDouble(key, value);
+	}
+	else if (key == "wakeup_c0i"){
+		this->wakeUpC0i = parseDouble(key, value);
+	}
+	else if (key == "wakeup_c1"){
+		this->wakeUpC1 = parseDouble(key, value);
+	}
+	else if (key == "wakeup_c3"){
+		this->wakeUpC3 = parseDouble(key, value);
+	}
+	else if (key == "wakeup_c6"){
+		this->wakeUpC6 = parseDouble(key, value);
+	}
+	else if (key == "warm_up"){
+		this->warmUp = parseInt(key, value);
+	}
+	else if (key == "sweep_threads"){
+		this->sweepThreads = parseInt(key, value);
+	}
+	else if (key == "log_level"){
+		for (int level = LOG_OFF; level <= LOG_DEBUG; level++){
+			if (value == logLevelNames[level] || value == to_string(level)){
+				this->logLevel = static_cast<LogLevel>(level);
+				return;
+			}
+		}
+		badValue(key, value);
+	}
+	else if (key == "log_binary"){
+		this->logBinary = parseBool(key, value);
+	}
+	else if (key == "platform"){
+		this->platform = value;
+	}
+	else if (key == "cores"){
+		this->cores = parseInt(key, value);
+	}
+	else if (key == "core_queue"){
+		if (value == "central"){
+			this->coreQueue = CORE_QUEUE_CENTRAL;
+		}
+		else if (value == "per_core"){
+			this->coreQueue = CORE_QUEUE_PER_CORE;
+		}
+		else {
+			badValue(key, value);
+		}
+	}
+	else if (key == "run_as"){
+		if (value != "SleepScale" && value != "DVFS_only" && value != "C0i" && value != "C1" && value != "C3" && value != "C6"){
+			badValue(key, value);
+		}
+		this->runAs = value;
+	}
+	else if (key == "trace"){
+		this->trace = value;
+	}
+	else if (key == "trace_reader"){
+		if (value == "mmap"){
+			this->traceReader = TRACE_MMAP;
+		}
+		else if (value == "buffered"){
+			this->traceReader = TRACE_BUFFERED;
+		}
+		else {
+			badValue(key, value);
+		}
+	}
+	else if (key == "service_cdf"){
+		this->serviceCdf = value;
+	}
+	else if (key == "arrival_cdf"){
+		this->arrivalCdf = value;
+	}
+	else if (key == "seed"){
+		this->seed = parseSeed(key, value);
+	}
+	else if (key == "policy_table"){
+		this->policyTable = value;
+	}
+	else if (key == "policy_table_refresh"){
+		this->policyTableRefresh = parseInt(key, value);
+	}
+	else if (key == "decision_budget"){
+		this->decisionBudget = parseDouble(key, value);
+	}
+	else if (key == "actuator"){
+		this->actuator = value;
+	}
+	else if (key == "checkpoint"){
+		this->checkpoint = value;
+	}
+	else if (key == "checkpoint_interval"){
+		this->checkpointInterval = parseInt(key, value);
+	}
+	else if (key == "resume"){
+		this->resume = parseBool(key, value);
+	}
+	else if (key == "metrics"){
+		this->metrics = value;
+	}
+	else if (key == "output"){
+		this->output = value;
+	}
+	else {
+		cerr << "Unknown configuration key " << key << endl;
+		terminate();
+	}
+}
+
+string Config::get(const string &key) const{
+
+	if (key == "update_interval") return to_string(this->updateInterval);
+	if (key == "est_lookback") return to_string(this->estLookback);
+	if (key == "slowdown") return toString(this->slowdown);
+	if (key == "slo_percentile") return toString(this->sloPercentile);
+	if (key == "ser_time") return toString(this->serTime);
+	if (key == "no_freq") return to_string(this->noFreq);
+	if (key == "over_prov") return this->overProvision ? "1" : "0";
+	if (key == "over_prov_amount") return toString(this->overProvAmount);
+	if (key == "baseline") return this->baseline;
+	if (key == "core_act_max_pwr") return toString(this->coreActMaxPwr);
+	if (key == "plat_idle_pwr") return toString(this->platIdlePwr);
+	if (key == "plat_act_max_pwr") return toString(this->platActMaxPwr);
+	if (key == "wakeup_c0i") return toString(this->wakeUpC0i);
+	if (key == "wakeup_c1") return toString(this->wakeUpC1);
+	if (key == "wakeup_c3") return toString(this->wakeUpC3);
+	if (key == "wakeup_c6") return toString(this->wakeUpC6);
+	if (key == "warm_up") return to_string(this->warmUp);
+	if (key == "sweep_threads") return to_string(this->sweepThreads);
+	if (key == "log_level") return logLevelNames[this->logLevel];
+	if (key == "log_binary") return this->logBinary ? "1" : "0";
+	if (key == "platform") return this->platform;
+	if (key == "cores") return to_string(this->cores);
+	if (key == "core_queue") return this->coreQueue == CORE_QUEUE_CENTRAL ? "central" : "per_core";
+	if (key == "run_as") return this->runAs;
+	if (key == "trace") return this->trace;
+	if (key == "trace_reader") return this->traceReader == TRACE_MMAP ? "mmap" : "buffered";
+	if (key == "service_cdf") return this->serviceCdf;
+	if (key == "arrival_cdf") return this->arrivalCdf;
+	if (key == "seed") return to_string(this->seed);
+	if (key == "policy_table") return this->policyTable;
+	if (key == "policy_table_refresh") return to_string(this->policyTableRefresh);
+	if (key == "decision_budget") return toString(this->decisionBudget);
+	if (key == "actuator") return this->actuator;
+	if (key == "checkpoint") return this->checkpoint;
+	if (key == "checkpoint_interval") return to_string(this->checkpointInterval);
+	if (key == "resume") return this->resume ? "1" : "0";
+	if (key == "metrics") return this->metrics;
+	if (key == "output") return this->output;
+
+	cerr << "Unknown configuration key " << key << endl;
+	terminate();
+}
+
+void Config::setOption(const string &option){
+
+	string keyValue = option.compare(0, 2, "--") == 0 ? option.substr(2) : option;
+	size_t equal = keyValue.find('=');
+	if (equal == string::npos){
+		cerr << "Expected key=value but got " << option << endl;
+		terminate();
+	}
+	this->set(keyValue.substr(0, equal), keyValue.substr(equal + 1));
+}
+
+void Config::loadFile(const string fileName){
+
+	ifstream configIn(fileName);
+	if (!configIn.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	string line;
+	while (getline(configIn, line)){
+		line = line.substr(0, line.find('#'));
+		size_t equal = line.find('=');
+		if (line.find_first_not_of(" \t\r") == string::npos){
+			continue;
+		}
+		if (equal == string::npos){
+			cerr << "Expected key = value in " << fileName << " but got " << line << endl;
+			terminate();
+		}
+
+		// Trim blanks around the key and the value
+		string key = line.substr(0, equal);
+		string value = line.substr(equal + 1);
+		key.erase(0, key.find_first_not_of(" \t"));
+		key.erase(key.find_last_not_of(" \t\r") + 1);
+		value.erase(0, value.find_first_not_of(" \t"));
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+		this->set(key, value);
+	}
+}
+
+void Config::check() const{
+
+	bool valid = true;
+	valid = valid && this->updateInterval >= 1;
+	valid = valid && this->estLookback >= 1;
+	valid = valid && this->slowdown >= 1;
+	valid = valid && this->sloPercentile >= 0 && this->sloPercentile <= 100;
+	valid = valid && this->serTime > 0;
+	valid = valid && this->noFreq >= 1;
+	valid = valid && this->overProvAmount >= 0;
+	valid = valid && this->warmUp >= 0;
+	valid = valid && this->policyTableRefresh >= 0;
+	valid = valid && this->decisionBudget >= 0;
+	valid = valid && this->checkpointInterval >= 1;
+	valid = valid && this->cores >= 1;
+
+	if (!valid){
+		cerr << "Invalid configuration! Need update_interval >= 1, est_lookback >= 1, slowdown >= 1, 0 <= slo_percentile <= 100, ser_time > 0, no_freq >= 1, " << 
+			"over_prov_amount >= 0, warm_up >= 0, policy_table_refresh >= 0, decision_budget >= 0, checkpoint_interval >= 1 and cores >= 1" << endl;
+		terminate();
+	}
+	if (this->resume && this->logBinary){
+		cerr << "A binary log cannot be continued: its literal dictionary is not part of the checkpoint. Unset log_binary or resume." << endl;
+		terminate();
+	}
+	if (this->cores > 1 && !this->policyTable.empty()){
+		cerr << "Policy tables are compiled for a single core. Unset policy_table or set cores = 1." << endl;
+		terminate();
+	}
+}
+
+void Config::write(Logger &logOut) const{
+	for (auto &key : Config::keys){
+		LOG_TO(logOut, LOG_DEBUG) << "[CONFIG] " << key << " = " << this->get(key);
+	}
+}
+
+bool isConfigOption(const string &option){
+	if (option.compare(0, 2, "--") != 0 || option.find('=') == string::npos){
+		return false;
+	}
+	string key = option.substr(2, option.find('=') - 2);
+	return find(Config::keys.begin(), Config::keys.end(), key) != Config::keys.end();
+}
+
+void Config::resolveSeed(){
+
+	if (this->seed != 0){
+		return;
+	}
+	random_device rd;
+	while (this->seed == 0){
+		this->seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+	}
+}
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Runtime configuration. Every field starts at the compile-time default in const.h/config.h, can be overridden by a configuration file 
+of "key = value" lines ('#' starts a comment) and then by "--key=value" options on the command line. A Server keeps its own copy, so 
+servers with different parameters can run side by side (see BatchRunner.h and ParameterSweep.h). 
+
+Switches that pick code paths (DO_SLEEPSCALE, DO_OFFLINE, the estimator, USE_SIMD_KERNEL, SLEEPSCALE_SEARCH, ...) stay in config.h.
+*/
+
+#ifndef CONFIG_RUNTIME_H
+#define CONFIG_RUNTIME_H
+
+#include "const.h"
+#include "config.h"
+#include "Logger.h"
+#include "TraceSource.h"
+#include "MultiCore.h"
+#include<string>
+#include<vector>
+#include<cstdint>
+using namespace std;
+
+class Config{
+
+public:
+	int updateInterval = UPDATE_INTERVAL; // update_interval: minutes between policy updates
+	int estLookback = EST_LOOKBACK; // est_lookback: minutes of history used by the estimator
+	double slowdown = SLEEPSCALE_SLOWDOWN; // slowdown: allowed mean response time in multiples of ser_time
+	double sloPercentile = SLO_PERCENTILE; // slo_percentile: if not 0, slowdown bounds this percentile of the response times instead of the mean
+	double serTime = SER_TIME; // ser_time: mean service time of the workload, ms
+	int noFreq = NO_FREQ; // no_freq: number of frequency levels
+#ifdef DO_OVER_PROV
+	bool overProvision = true; // over_prov: run faster than the chosen frequency by over_prov_amount
+	double overProvAmount = OVER_PROV_AMOUNT; // over_prov_amount
+#else
+	bool overProvision = false;
+	double overProvAmount = 0.35;
+#endif
+#if defined(BASE_USE_NO_PWR_CNTRL)
+	string baseline = "NO_PWR_CNTRL"; // baseline: NO_PWR_CNTRL (always on), R2H_C3 or R2H_C6 (race to halt)
+#elif defined(BASE_USE_R2H_C6)
+	string baseline = "R2H_C6";
+#else
+	string baseline = "R2H_C3";
+#endif
+	double coreActMaxPwr = CORE_ACT_MAX_PWR; // core_act_max_pwr, Watt
+	double platIdlePwr = PLAT_IDLE_PWR; // plat_idle_pwr, Watt
+	double platActMaxPwr = PLAT_ACT_MAX_PWR; // plat_act_max_pwr, Watt
+	double wakeUpC0i = WAKEUP_C0i; // wakeup_c0i, ms
+	double wakeUpC1 = WAKEUP_C1; // wakeup_c1, ms
+	double wakeUpC3 = WAKEUP_C3; // wakeup_c3, ms
+	double wakeUpC6 = WAKEUP_C6; // wakeup_c6, ms
+#ifdef CUT_THE_FIRST_120_MINS
+	int warmUp = 120; // warm_up: results of minutes up to this one are not counted
+#else
+	int warmUp = 0;
+#endif
+	int sweepThreads = SWEEP_THREADS; // sweep_threads: threads simulating policies, 0 uses all hardware threads
+	LogLevel logLevel = LOG_LEVEL; // log_level: off, summary, info or debug
+#ifdef LOG_BINARY
+	bool logBinary = true; // log_binary: write binary log records
+#else
+	bool logBinary = false;
+#endif
+	string platform = PLATFORM; // platform: power model file (PowerModel.h), empty for the built-in one. The power keys, wake-up latencies and no_freq only set the built-in model
+	int cores = CORES; // cores: cores of the server, 1 for the single-core model (MultiCore.h)
+	CoreQueue coreQueue = CORE_QUEUE; // core_queue: central, one queue shared by the cores, or per_core, round-robin over a queue per core
+	string runAs = RUN_AS; // run_as: SleepScale, DVFS_only, C0i, C1, C3 or C6
+	string trace = TRACE_FILE; // trace: utilization trace
+	TraceReaderType traceReader = TRACE_MMAP; // trace_reader: mmap, or buffered for pipes and FIFOs
+	string serviceCdf = SERVICE_CDF; // service_cdf
+	string arrivalCdf = ARRIVAL_CDF; // arrival_cdf
+	uint64_t seed = RANDOM_SEED; // seed: workload random seed, 0 draws one (see resolveSeed)
+	string policyTable = POLICY_TABLE; // policy_table: look policies up in this table instead of simulating them (PolicyTable.h)
+	int policyTableRefresh = POLICY_TABLE_REFRESH; // policy_table_refresh: minutes between refreshing a table entry from the job log, 0 never
+	double decisionBudget = DECISION_BUDGET; // decision_budget: ms a daemon decision may take before it switches to the policy search, 0 never switches
+	string actuator = ACTUATOR; // actuator: sysfs root the daemon applies its decisions under (Actuator.h), e.g. /sys. Empty only reports them
+	string checkpoint = CHECKPOINT; // checkpoint: file a replay saves its state to (Checkpoint.h), empty never saves
+	int checkpointInterval = CHECKPOINT_INTERVAL; // checkpoint_interval: minutes between checkpoints
+	bool resume = false; // resume: continue from the checkpoint if there is one
+	string metrics = METRICS; // metrics: per-minute metrics file (MinuteMetrics.h), empty writes none
+	string output = OUTPUT; // output: log file
+
+	static const vector<string> keys; // Every key, in the order above
+
+	void set(const string &, const string &); // Key, value. Unknown keys and malformed values terminate.
+	string get(const string &) const;
+	void setOption(const string &); // "key=value" or "--key=value"
+	void loadFile(const string); 
+	void check() const; // Terminate if the parameters make no sense
+	void resolveSeed(); // Replace seed 0 by a random seed, so that the logged configuration reproduces the run
+	void write(Logger &) const; // Log every key at LOG_DEBUG
+};
+
+bool isConfigOption(const string &); // True for "--key=value" with a known key
+
+#endif
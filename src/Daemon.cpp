@@ -0,0 +1,327 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Daemon.h"
+#include "Server.h"
+#include<iostream>
+#include<cstring>
+#include<cerrno>
+#include<charconv>
+#include<exception>
+#include<algorithm>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/socket.h>
+#include<sys/un.h>
+
+LiveFeed::LiveFeed(const string source){
+
+	this->source = source;
+	this->buffer.resize(CHUNK_SIZE);
+
+	if (source.compare(0, 5, "unix:") == 0){
+		string path = source.substr(5);
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(address.sun_path)){
+			cerr << "Socket path " << path << " is too long!" << endl;
+			terminate();
+		}
+		strcpy(address.sun_path, path.c_str());
+
+		unlink(path.c_str()); // A socket left behind by an earlier run
+		this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (this->listenFd < 0 || bind(this->listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || 
+			listen(this->listenFd, 1) != 0){
+			cerr << "Cannot listen on socket " << path << ": " << strerror(errno) << endl;
+			terminate();
+		}
+		cout << "Waiting for a producer on " << path << endl;
+		do {
+			this->fd = accept(this->listenFd, nullptr, nullptr);
+		} while (this->fd < 0 && errno == EINTR);
+		if (this->fd < 0){
+			cerr << "Accepting a producer on socket " << path << " failed: " << strerror(errno) << endl;
+			terminate();
+		}
+	}
+	else {
+		cout << "Waiting for a producer on " << source << endl;
+		this->fd = open(source.c_str(), O_RDONLY); // Blocks until a FIFO has a writer
+		if (this->fd < 0){
+			cerr << "File " << source << " cannot be opened!" << endl;
+			terminate();
+		}
+	}
+}
+
+LiveFeed::~LiveFeed(){
+	if (this->fd >= 0){
+		close(this->fd);
+	}
+	if (this->listenFd >= 0){
+		close(this->listenFd);
+		unlink(this->source.substr(5).c_str());
+	}
+}
+
+bool LiveFeed::fill(){
+
+	if (this->endOfStream){
+		return false;
+	}
+
+	if (this->head > 0){
+		memmove(this->buffer.data(), this->buffer.data() + this->head, this->tail - this->head);
+		this->tail = this->tail - this->head;
+		this->head = 0;
+	}
+	if (this->tail == this->buffer.size()){
+		this->buffer.resize(2 * this->buffer.size());
+	}
+
+	ssize_t got;
+	do {
+		got = read(this->fd, this->buffer.data() + this->tail, this->buffer.size() - this->tail);
+	} while (got < 0 && errno == EINTR);
+
+	if (got < 0){
+		cerr << "Reading feed " << this->source << " failed: " << strerror(errno) << endl;
+		terminate();
+	}
+	if (got == 0){
+		this->endOfStream = true;
+		return false;
+	}
+
+	this->tail = this->tail + got;
+	return true;
+}
+
+// Parse the numbers of [first, last), separated by blanks. False unless there are exactly count of them.
+static bool parseNumbers(const char *first, const char *last, double *values, int count){
+	for (int i = 0; i < count; i++){
+		while (first < last && (*first == ' ' || *first == '\t')){
+			first++;
+		}
+		auto parsed = from_chars(first, last, values[i]);
+		if (parsed.ec != errc()){
+			return false;
+		}
+		first = parsed.ptr;
+	}
+	while (first < last && (*first == ' ' || *first == '\t')){
+		first++;
+	}
+	return first == last;
+}
+
+bool LiveFeed::parseLine(const char *first, const char *last, double &rho){
+
+	while (first < last && (*first == ' ' || *first == '\t')){
+		first++;
+	}
+	while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')){
+		last--;
+	}
+	if (first == last || *first == '#'){
+		return false;
+	}
+
+	bool valid;
+	bool isRho = false;
+	if (last - first > 4 && memcmp(first, "job", 3) == 0 && (first[3] == ' ' || first[3] == '\t')){
+		double job[2];
+		valid = parseNumbers(first + 3, last, job, 2) && job[0] >= 0 && job[0] < 60 * 1000 && job[1] > 0;
+		if (valid){
+			this->records.push_back(make_pair(job[0], job[1]));
+		}
+	}
+	else {
+		if (last - first > 4 && memcmp(first, "rho", 3) == 0 && (first[3] == ' ' || first[3] == '\t')){
+			first = first + 3;
+		}
+		valid = parseNumbers(first, last, &rho, 1) && rho >= 0;
+		isRho = valid;
+	}
+
+	if (!valid){
+		this->badLines++;
+		cerr << "Skipping line " << this->lineNo << " of feed " << this->source << ": " << string(first, last) << endl;
+	}
+	return isRho;
+}
+
+bool LiveFeed::next(double &rho){
+
+	while (true){
+		const char *start = this->buffer.data() + this->head;
+		const char *newline = static_cast<const char *>(memchr(start, '\n', this->tail - this->head));
+
+		if (newline == nullptr && this->fill()){
+			continue;
+		}
+		if (newline == nullptr && this->head == this->tail){
+			return false; // The producer closed the feed
+		}
+
+		start = this->buffer.data() + this->head;
+		const char *lineEnd = newline != nullptr ? newline : this->buffer.data() + this->tail;
+		this->head = newline != nullptr ? newline + 1 - this->buffer.data() : this->tail;
+		this->lineNo++;
+
+		if (this->parseLine(start, lineEnd, rho)){
+			// The minute is complete. Its job records go with it.
+			this->minuteRecords.swap(this->records);
+			this->records.clear();
+			return true;
+		}
+	}
+}
+
+long LiveFeed::getLineNo() const{
+	return this->lineNo;
+}
+
+string LiveFeed::getName() const{
+	return this->source;
+}
+
+long LiveFeed::getBadLines() const{
+	return this->badLines;
+}
+
+/*
+Jobs are built as drawWorkloadCDF builds them: absolute arrival times, and the gap of the first job counted from the start of the minute. 
+*/
+void LiveFeed::takeJobs(int minute, double rho, vector<Job> &jobs){
+
+	sort(this->minuteRecords.begin(), this->minuteRecords.end());
+	double previous = 0;
+	for (auto &record : this->minuteRecords){
+		jobs.push_back(Job(minute * 60 * 1000 + record.first, record.second, record.first - previous, rho));
+		previous = record.first;
+	}
+	this->minuteRecords.clear();
+}
+
+
+Daemon::Daemon(const Config &config, const string source, const string decisionsFile) : config(config) {
+
+	this->source = source;
+	this->decisionsFile = decisionsFile;
+	if (decisionsFile == "-"){
+		this->decisions = &cout;
+	}
+	else {
+		openOutputFile(decisionsFile, this->decisionsStream);
+		this->decisions = &this->decisionsStream;
+	}
+	if (!config.actuator.empty()){
+		this->actuator = make_shared<Actuator>(config.actuator, config.cores);
+	}
+}
+
+void Daemon::decide(Server &server, const PowerState &policy, double ms){
+
+	*this->decisions << "minute " << server.minute << " est " << server.estimator->est << " freq " << policy.freq << " idle " << policy.idle << 
+		" cores " << policy.cores << " compute_ms " << ms << endl; // Flushed, the controller acts on it right away
+
+	if (this->actuator != nullptr){
+		double freq = this->config.overProvision ? min(policy.freq * (1 + this->config.overProvAmount), 1.0) : policy.freq; // As doQueue runs it
+		this->actuator->apply(policy, freq);
+	}
+
+	this->noOfDecisions++;
+	this->totalDecisionTime = this->totalDecisionTime + ms;
+	this->maxDecisionTime = max(this->maxDecisionTime, ms);
+
+	if (this->config.decisionBudget > 0 && ms > this->config.decisionBudget){
+		this->noOfOverruns++;
+		if (!server.forceSearch){
+			server.forceSearch = true;
+			LOG_TO(server.logOut, LOG_SUMMARY) << "[DAEMON] Decision at minute " << server.minute << " took " << ms << " ms, over the budget of " << 
+				this->config.decisionBudget << " ms. Searching policies from now on.";
+		}
+	}
+}
+
+void Daemon::run(){
+
+#ifdef DO_OFFLINE
+	cerr << "The offline estimator reads the trace ahead and cannot run on a live feed. Undefine DO_OFFLINE." << endl;
+	terminate();
+#endif
+
+	auto serDist = loadCdfTable(this->config.serviceCdf);
+	auto arrDist = loadCdfTable(this->config.arrivalCdf);
+
+	Server server(this->config);
+	server.onDecision = [this, &server](const PowerState &policy, double ms){ this->decide(server, policy, ms); };
+
+	auto feed = make_shared<LiveFeed>(this->source);
+	server.start(feed);
+	LOG_TO(server.logOut, LOG_INFO) << "[DAEMON] Reading the feed " << this->source << ", writing decisions to " << this->decisionsFile;
+
+	vector<Job> jobs;
+	while (server.isRunning()){
+		double newRho = server.stepMinute();
+
+		if (newRho >= 0){
+			jobs.clear();
+			feed->takeJobs(server.minute, newRho, jobs);
+			if (jobs.empty()){
+				server.generateWorkloadCDF(*serDist, *arrDist, server.minute, newRho);
+			}
+			else {
+				server.addWorkload(jobs);
+			}
+		}
+	}
+
+	double mean = this->noOfDecisions > 0 ? this->totalDecisionTime / this->noOfDecisions : 0;
+	LOG_TO(server.logOut, LOG_SUMMARY) << "Daemon: " << this->noOfDecisions << " decisions, compute time mean " << mean << " ms, max " << 
+		this->maxDecisionTime << " ms, " << this->noOfOverruns << " over the budget. " << feed->getBadLines() << " malformed feed lines skipped";
+	cout << "Decisions: " << this->noOfDecisions << ", compute time mean " << mean << " ms, max " << this->maxDecisionTime << " ms" << endl;
+
+	if (this->actuator != nullptr){
+		auto &applyTimes = this->actuator->getApplyTimes();
+		LOG_TO(server.logOut, LOG_SUMMARY) << "Actuator: " << this->actuator->getApplies() << " policies applied under " << this->config.actuator << 
+			", " << this->actuator->getWrites() << " writes, " << this->actuator->getSkipped() << " unchanged and skipped, " << 
+			this->actuator->getFailures() << " failed. Apply time p50 " << applyTimes.percentile(50) << " ms, p99 " << applyTimes.percentile(99) << 
+			" ms, max " << applyTimes.max() << " ms";
+		cout << "Applied: " << this->actuator->getApplies() << ", writes " << this->actuator->getWrites() << ", skipped " << 
+			this->actuator->getSkipped() << ", failed " << this->actuator->getFailures() << ", apply time p99 " << applyTimes.percentile(99) << " ms" << endl;
+	}
+
+	server.finish();
+}
@@ -0,0 +1,132 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Controller daemon. Runs SleepScale next to a live service instead of replaying a finished trace: the utilization of every minute comes 
+from a FIFO or a UNIX stream socket, and every policy SleepScale picks is written out as soon as it is known, before the next minute is 
+read. 
+
+The feed is a stream of text lines: 
+
+	<rho> or rho <rho>              the minute just ended had utilization rho (per core on a multi-core server)
+	job <arrival ms> <service ms>   one request of the minute being received, arrival time from the start of the minute
+
+Blank lines and lines starting with '#' are ignored, so a utilization trace can be fed as it is. A minute with job records runs exactly 
+those jobs; a minute without them gets jobs drawn from the CDFs at its utilization, as in a replay. Malformed lines are counted and 
+skipped rather than stopping the controller. The run ends when the producer closes the feed, and the report is written as usual. 
+
+Each decision is one line on the decision output: 
+
+	minute <m> est <rho> freq <f> idle <state> cores <k> compute_ms <t>
+
+compute_ms is the time doSleepScale took. With decision_budget set, a sweep of every policy that takes longer than the budget switches 
+the server to the monotone search (Server::searchPolicies) for the rest of the run, which bounds later decisions at a fraction of the 
+cost. 
+
+With actuator set to a sysfs root, each decision is also applied to the cores through cpufreq and cpuidle (Actuator.h), at the frequency 
+doQueue runs it, i.e. over-provisioned if over_prov is set. 
+*/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "TraceSource.h"
+#include "Config.h"
+#include "Job.h"
+#include "Actuator.h"
+#include<string>
+#include<vector>
+#include<fstream>
+#include<utility>
+#include<memory>
+using namespace std;
+
+class Server;
+class PowerState;
+
+class LiveFeed : public TraceSource{
+
+private:
+	static const int CHUNK_SIZE = 1 << 16; // Bytes per read
+
+	string source;
+	int fd = -1;
+	int listenFd = -1; // Listening socket of a unix: source
+	vector<char> buffer;
+	size_t head = 0; // First unread byte in buffer
+	size_t tail = 0; // One past the last valid byte in buffer
+	bool endOfStream = false;
+	long lineNo = 0;
+	long badLines = 0;
+	vector<pair<double, double>> records; // (arrival, service) of the minute being received
+	vector<pair<double, double>> minuteRecords; // Those of the minute next returned last
+
+	bool fill(); // Read more bytes, blocking until they arrive. False once the producer has closed the feed.
+	bool parseLine(const char *, const char *, double &); // True for a utilization line
+
+public:
+	LiveFeed(const string); // FIFO or file path, or unix:path for a UNIX stream socket. Blocks until a producer connects.
+	~LiveFeed();
+	LiveFeed(const LiveFeed &) = delete;
+	LiveFeed &operator=(const LiveFeed &) = delete;
+
+	bool next(double &) override; // Utilization of the next minute, blocking. False at the end of the feed.
+	long getLineNo() const override;
+	string getName() const override;
+	long getBadLines() const;
+	void takeJobs(int, double, vector<Job> &); // Job records of the minute next returned last, as jobs of a minute at a utilization
+};
+
+class Daemon{
+
+private:
+	Config config;
+	string source;
+	string decisionsFile;
+	ofstream decisionsStream;
+	ostream *decisions;
+	shared_ptr<Actuator> actuator; // If actuator is set
+
+	int noOfDecisions = 0;
+	double totalDecisionTime = 0; // ms
+	double maxDecisionTime = 0;
+	int noOfOverruns = 0; // Decisions over decision_budget
+
+	void decide(Server &, const PowerState &, double); // Server, its decision, compute time in ms
+
+public:
+	Daemon(const Config &, const string, const string); // Configuration, feed, decision output ("-" for stdout)
+	void run(); // Until the feed ends
+};
+
+#endif
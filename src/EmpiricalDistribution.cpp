@@ -0,0 +1,178 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "EmpiricalDistribution.h"
+#include "Philox.h"
+#include<algorithm>
+
+EmpiricalDistribution::EmpiricalDistribution(const vector<double> &sample, const vector<double> &prob) : 
+	EmpiricalDistribution(sample.data(), prob.data(), min(sample.size(), prob.size())){
+
+	assert(sample.size() == prob.size());
+}
+
+EmpiricalDistribution::EmpiricalDistribution(const double *sample, const double *prob, int n){
+
+	assert(n > 0);
+
+	this->cdfProb.assign(prob, prob + n);
+
+	for (int k = 0; k < n; k++){
+		int j = min(k + 1, n - 1);
+		this->value.push_back((sample[k] + sample[j]) / 2);
+	}
+
+	// Probability mass of each bucket. Bucket 0 also takes u <= prob[0] and the last bucket takes u > prob[n - 1]. 
+	vector<double> mass(n, 0.0);
+	for (int k = 0; k < n - 1; k++){
+		mass.at(k) = max(prob[k + 1] - prob[k], 0.0);
+	}
+	mass.at(0) = mass.at(0) + max(prob[0], 0.0);
+	mass.at(n - 1) = mass.at(n - 1) + max(1 - prob[n - 1], 0.0);
+
+	double totalMass = 0;
+	for (int k = 0; k < n; k++){
+		totalMass = totalMass + mass.at(k);
+		this->mean = this->mean + mass.at(k) * this->value.at(k);
+		this->secondMoment = this->secondMoment + mass.at(k) * this->value.at(k) * this->value.at(k);
+	}
+	assert(totalMass > 0);
+	this->mean = this->mean / totalMass;
+	this->secondMoment = this->secondMoment / totalMass;
+
+	// Guide table with one entry per row
+	this->guide.resize(n);
+	for (int j = 0; j < n; j++){
+		this->guide.at(j) = lower_bound(this->cdfProb.begin(), this->cdfProb.end(), static_cast<double>(j) / n) - this->cdfProb.begin();
+	}
+
+	// Walker's alias table. Columns are split into those below and above the average mass and paired up. 
+	this->aliasProb.assign(n, 1.0);
+	this->aliasIndex.resize(n);
+	vector<double> scaled(n);
+	vector<int> small;
+	vector<int> large;
+
+	for (int k = 0; k < n; k++){
+		this->aliasIndex.at(k) = k;
+		scaled.at(k) = mass.at(k) / totalMass * n;
+		if (scaled.at(k) < 1){
+			small.push_back(k);
+		}
+		else{
+			large.push_back(k);
+		}
+	}
+
+	while (!small.empty() && !large.empty()){
+		int s = small.back();
+		small.pop_back();
+		int l = large.back();
+
+		this->aliasProb.at(s) = scaled.at(s);
+		this->aliasIndex.at(s) = l;
+		scaled.at(l) = scaled.at(l) + scaled.at(s) - 1;
+
+		if (scaled.at(l) < 1){
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// Whatever is left is full up to rounding errors
+	for (auto k : small){
+		this->aliasProb.at(k) = 1.0;
+	}
+	for (auto k : large){
+		this->aliasProb.at(k) = 1.0;
+	}
+}
+
+int EmpiricalDistribution::getSize() const{
+	return this->value.size();
+}
+
+double EmpiricalDistribution::getMean() const{
+	return this->mean;
+}
+
+double EmpiricalDistribution::getSecondMoment() const{
+	return this->secondMoment;
+}
+
+double EmpiricalDistribution::lookup(double u, Method method) const{
+	switch (method){
+	case BINARY_SEARCH:
+		return this->value[this->lookupBinary(u)];
+	case GUIDE_TABLE:
+		return this->value[this->lookupGuide(u)];
+	default:
+		return this->value[this->lookupAlias(u)];
+	}
+}
+
+// Last row with cdfProb < u, or row 0 if there is none
+int EmpiricalDistribution::lookupBinary(double u) const{
+	int first = lower_bound(this->cdfProb.begin(), this->cdfProb.end(), u) - this->cdfProb.begin();
+	return max(first - 1, 0);
+}
+
+// Same answer as lookupBinary. The guide table jumps close to the row, then a short linear scan finishes the search. 
+int EmpiricalDistribution::lookupGuide(double u) const{
+	int n = this->cdfProb.size();
+	int j = min(static_cast<int>(u * n), n - 1);
+	if (j > 0 && static_cast<double>(j) / n > u){
+		j--; // u * n was rounded up across an entry
+	}
+	int first = this->guide[j];
+	while (first < n && this->cdfProb[first] < u){
+		first++;
+	}
+	return max(first - 1, 0);
+}
+
+int EmpiricalDistribution::lookupAlias(double u) const{
+	int n = this->aliasProb.size();
+	double scaled = u * n;
+	int column = min(static_cast<int>(scaled), n - 1);
+	return (scaled - column < this->aliasProb[column]) ? column : this->aliasIndex[column];
+}
+
+double EmpiricalDistribution::draw(RandomStream &stream, Method method) const{
+	return this->lookup(stream.uniform(), method);
+}
+
+void EmpiricalDistribution::drawBatch(RandomStream &stream, double *out, int n, Method method) const{
+	stream.uniform(out, n);
+	for (int i = 0; i < n; i++){
+		out[i] = this->lookup(out[i], method);
+	}
+}
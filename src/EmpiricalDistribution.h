@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Empirical distribution built from a BigHouse CDF (the output of readBigHouseCDF). It reproduces the lookup generateWorkloadCDF always used: 
+a uniform u maps to the midpoint of the bucket [sample[k], sample[k + 1]] where k is the last row with prob[k] < u. 
+Three samplers are offered. BINARY_SEARCH and GUIDE_TABLE return exactly the same value for the same u, in O(log n) and O(1) expected time. 
+ALIAS_TABLE uses Walker's alias method. It has the same distribution and takes O(1) worst-case time, but maps u to a different value. 
+*/
+
+#ifndef EMPIRICALDISTRIBUTION_H
+#define EMPIRICALDISTRIBUTION_H
+
+#include<vector>
+#include<random>
+#include<assert.h>
+using namespace std;
+
+class RandomStream;
+
+class EmpiricalDistribution{
+
+public:
+	enum Method { BINARY_SEARCH, GUIDE_TABLE, ALIAS_TABLE };
+
+private:
+	vector<double> value; // value.at(k) is the midpoint of bucket k
+	vector<double> cdfProb; // Cumulative probability of each row of the CDF file
+	vector<int> guide; // guide.at(j) is the first row with cdfProb >= j / guide.size()
+	vector<double> aliasProb; // Probability of keeping column k in the alias table
+	vector<int> aliasIndex; // Where column k goes otherwise
+	double mean = 0;
+	double secondMoment = 0;
+
+	int lookupBinary(double) const;
+	int lookupGuide(double) const;
+	int lookupAlias(double) const;
+
+public:
+	EmpiricalDistribution() = default;
+	EmpiricalDistribution(const vector<double> &, const vector<double> &); // Samples and cumulative probabilities
+	EmpiricalDistribution(const double *, const double *, int); // Same, from arrays of n rows (e.g., a mapped CompiledCdf)
+
+	double lookup(double, Method) const; // Map a uniform sample in [0, 1) to a value
+	int getSize() const;
+	double getMean() const; // Mean of the sampled values
+	double getSecondMoment() const; // E[X^2] of the sampled values
+
+	// Draw from a counter-based stream (Philox.h). The uniforms are taken in bulk from the stream. 
+	double draw(RandomStream &, Method) const;
+	void drawBatch(RandomStream &, double *, int, Method) const;
+
+	// Draw one value
+	template<class Engine>
+	double draw(Engine &eng, Method method) const{
+		uniform_real_distribution<double> genUniform(0.0, 1.0);
+		return this->lookup(genUniform(eng), method);
+	}
+
+	// Draw n values into a caller buffer. Uniforms are generated first and then mapped, so the lookup loop is free of RNG state. 
+	template<class Engine>
+	void drawBatch(Engine &eng, double *out, int n, Method method) const{
+		uniform_real_distribution<double> genUniform(0.0, 1.0);
+		for (int i = 0; i < n; i++){
+			out[i] = genUniform(eng);
+		}
+		for (int i = 0; i < n; i++){
+			out[i] = this->lookup(out[i], method);
+		}
+	}
+
+};
+
+#endif
@@ -31,27 +31,125 @@
 
 
 #include "Estimator.h"
+#include "Checkpoint.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL
+#include<immintrin.h>
+#endif
 
 const double Estimator::a = 10;
-double Estimator::g1 = 0;
-double Estimator::g2 = 0;
 const double Estimator::h = 0.15;
 const double Estimator::v = 0.03;
-double Estimator::mu = 0;
+
+
+/*
+Scalar kernels. The dot product keeps four partial sums, one per lane of the AVX2 path, so both paths add in the same order. 
+*/
+static double estDotScalar(const double *w, const double *x, int n){
+	double acc[4] = { 0, 0, 0, 0 };
+	int i = 0;
+	for (; i + 4 <= n; i += 4){
+		for (int l = 0; l < 4; l++){
+			acc[l] = acc[l] + w[i + l] * x[i + l];
+		}
+	}
+	double sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+	for (; i < n; i++){
+		sum = sum + w[i] * x[i];
+	}
+	return sum;
+}
+
+static void estAxpyScalar(double *w, double c, const double *x, int n){
+	for (int i = 0; i < n; i++){
+		w[i] = w[i] + c * x[i];
+	}
+}
+
+
+#ifdef HAVE_AVX2_KERNEL
+
+// The weights are aligned, the window starts anywhere in the ring
+__attribute__((target("avx2")))
+static double estDotAVX2(const double *w, const double *x, int n){
+	__m256d acc = _mm256_setzero_pd();
+	int i = 0;
+	for (; i + 4 <= n; i += 4){
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_load_pd(w + i), _mm256_loadu_pd(x + i)));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; i < n; i++){
+		sum = sum + w[i] * x[i];
+	}
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static void estAxpyAVX2(double *w, double c, const double *x, int n){
+	const __m256d cc = _mm256_set1_pd(c);
+	int i = 0;
+	for (; i + 4 <= n; i += 4){
+		_mm256_store_pd(w + i, _mm256_add_pd(_mm256_load_pd(w + i), _mm256_mul_pd(cc, _mm256_loadu_pd(x + i))));
+	}
+	for (; i < n; i++){
+		w[i] = w[i] + c * x[i];
+	}
+}
+
+static bool estHasAVX2(){
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	return hasAVX2;
+}
+
+#endif // HAVE_AVX2_KERNEL
+
+
+static double estDot(const double *w, const double *x, int n){
+#ifdef HAVE_AVX2_KERNEL
+	if (estHasAVX2()){
+		return estDotAVX2(w, x, n);
+	}
+#endif
+	return estDotScalar(w, x, n);
+}
+
+static void estAxpy(double *w, double c, const double *x, int n){
+#ifdef HAVE_AVX2_KERNEL
+	if (estHasAVX2()){
+		estAxpyAVX2(w, c, x, n);
+		return;
+	}
+#endif
+	estAxpyScalar(w, c, x, n);
+}
+
+
+string estPredictorName(int predictor){
+	switch (predictor){
+	case EST_NLMS: return "NLMS";
+	case EST_IMMEDIATE_PAST: return "immediate past";
+	case EST_EWMA: return "EWMA";
+	case EST_CUSUM_MEAN: return "CUSUM-reset mean";
+	}
+	return "unknown";
+}
+
 
 // Construct estimator
-Estimator::Estimator(int maxLookback, ifstream &logIn, ofstream &logOut) {
-	assert(logIn.is_open() && logOut.is_open());
+Estimator::Estimator(int maxLookback, Logger &logOut) {
+	assert(logOut.is_open());
 	
 	this->historySize = maxLookback;
 	this->curLookback = maxLookback;
 	this->est = 0;
 
-	for (int i = 0; i < maxLookback; i++){
-		this->weight.push_back(1.0 / maxLookback);
-	}
+	this->weight.assign(maxLookback, 1.0 / maxLookback);
 
 	// Initialize history and historyL2Norm
+	this->ring.assign(2 * maxLookback, 0);
 	this->historyL2Norm = 0;
 
 	this->estErrorPerc = 0;
@@ -59,59 +157,54 @@ Estimator::Estimator(int maxLookback, ifstream &logIn, ofstream &logOut) {
 	this->estErrorAbs = 0;
 	this->noOfObserved = 0;
 
-	logOut << "[ESTIMATOR] Estimator is up!" << endl;
+	LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Estimator is up!";
 
 }
 
 
 // Estimate next utilization
-void Estimator::estimateRho(ofstream &logOut, ifstream &rhoIn){
+void Estimator::estimateRho(Logger &logOut, TraceSource &rhoIn){
 
-	logOut << "[ESTIMATOR] I'm an offline estimatior I'll simply observe the next one as my estimate" << endl;
+	LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] I'm an offline estimatior I'll simply observe the next one as my estimate";
 
 
 	double estimated = 0;
 
-	string line;
-
-	try{
-		getline(rhoIn, line);
-	}
-	catch (const ifstream::failure &e){
-		logOut << "[ESTIMATOR] Reached the EoF" << endl;
+	if (!rhoIn.next(estimated)){
+		LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Reached the EoF";
 		this->estimatorStatus = false;
 		return;
 	}
 
-	estimated = stod(line);
 	this->est = min(estimated, 1.0);
 
-	logOut << "[ESTIMATOR] Estimation success! The next estimate is " << this->est << endl;
+	LOG_TO(logOut, LOG_INFO) << "[ESTIMATOR] Estimation success! The next estimate is " << this->est;
 
 	return;
 }
 
 
+// Prediction of the NLMS filter from a full window
+double Estimator::predictNLMS() const{
+	return estDot(this->weight.data(), this->ring.data() + this->head, this->historySize);
+}
+
+
 // Estimate next utilization based on the current history
-void Estimator::estimateRho(ofstream &logOut){
+void Estimator::estimateRho(Logger &logOut){
 
-	logOut << "[ESTIMATOR] Estimating utilization." << endl;
+	LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Estimating utilization.";
 
-	if (this->curHistory.size() < this->historySize){
-		logOut << "[ESTIMATOR] Not enough history! Need more samples!" << endl;
+	if (this->noOfHistory < this->historySize){
+		LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Not enough history! Need more samples!";
 		// this->est = this->immediatePastUtil;
 		return;
 	}
 
-	assert(this->historySize == this->curHistory.size());
 	assert(this->historySize == this->weight.size());
 
-	double estimated = 0;
-
 	// Construct estimation
-	for (int i = 0; i < this->historySize; i++){
-		estimated = estimated + this->weight.at(i) * this->curHistory.at(i);
-	}
+	double estimated = this->predictNLMS();
 
 	// Update parameters
 	this->mu = 0.01 / (this->historyL2Norm + this->a);
@@ -120,40 +213,102 @@ void Estimator::estimateRho(ofstream &logOut){
 #ifdef useImmediatePastHist
 	this->est = this->immediatePastUtil; // Over-ride the estimated utilization by the immediate past utilization
 #endif
+
+#ifdef EST_ENSEMBLE
+	this->prediction[EST_NLMS] = this->est;
+	this->prediction[EST_IMMEDIATE_PAST] = this->immediatePastUtil;
+	this->prediction[EST_EWMA] = this->ewma;
+	this->prediction[EST_CUSUM_MEAN] = this->changeMean;
+	this->predicted = true;
+
+	// Lowest recent error. Ties go to the first, so the NLMS filter starts.
+	this->picked = EST_NLMS;
+	for (int p = 1; p < NO_OF_PREDICTORS; p++){
+		if (this->recentError[p] < this->recentError[this->picked]){
+			this->picked = p;
+		}
+	}
+	this->picks[this->picked]++;
+	this->est = this->prediction[this->picked];
+
+	LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Ensemble picks " << estPredictorName(this->picked) << " with recent squared error " << this->recentError[this->picked];
+#endif
 	
-	logOut << "[ESTIMATOR] Estimation success! The next estimate is " << this->est << endl;
+	LOG_TO(logOut, LOG_INFO) << "[ESTIMATOR] Estimation success! The next estimate is " << this->est;
 
 	return;
 }
 
-// Observe a new rho from the log
-double Estimator::observeRho(ifstream &logIn, ofstream &logOut){
 
-	logOut << "[ESTIMATOR] Observing utilization" << endl;
-	string line;
+// Score the predictions of the ensemble against the observed rho, then let every predictor see it
+void Estimator::observeEnsemble(double rho){
+
+	if (this->predicted){
+		for (int p = 0; p < NO_OF_PREDICTORS; p++){
+			double err = rho - this->prediction[p];
+			this->recentError[p] = EST_ENSEMBLE_DECAY * this->recentError[p] + (1 - EST_ENSEMBLE_DECAY) * err * err;
+		}
+		this->predicted = false;
+	}
+
+	if (this->changeCount == 0){
+		this->ewma = rho;
+		this->changeMean = rho;
+		this->changeCount = 1;
+		return;
+	}
+
+	this->ewma = EST_EWMA_ALPHA * rho + (1 - EST_EWMA_ALPHA) * this->ewma;
 
-	try{
-		getline(logIn, line);
+	// Restart the mean when the relative error drifts either way
+	if (rho > 0){
+		double err = (rho - this->changeMean) / rho;
+		this->changeG1 = max(this->changeG1 + err - this->v, 0.0);
+		this->changeG2 = max(this->changeG2 - err - this->v, 0.0);
+	}
+
+	if (this->changeG1 > this->h || this->changeG2 > this->h){
+		this->changeG1 = 0;
+		this->changeG2 = 0;
+		this->changeMean = rho;
+		this->changeCount = 1;
+	}
+	else {
+		this->changeCount = min(this->changeCount + 1, this->historySize);
+		this->changeMean = this->changeMean + (rho - this->changeMean) / this->changeCount;
 	}
-	catch (const ifstream::failure &e){
-		logOut << "[ESTIMATOR] Reached the EoF" << endl;
+}
+
+
+// Observe a new rho from the log
+double Estimator::observeRho(TraceSource &logIn, Logger &logOut){
+
+	LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Observing utilization";
+	double rho;
+
+	if (!logIn.next(rho)){
+		LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Reached the EoF";
 		this->observorStatus = false;
 		return -1;
 	}
 
-	double rho = stod(line);
 	this->immediatePastUtil = rho;
 
+#ifdef EST_ENSEMBLE
+	this->observeEnsemble(rho);
+#endif
+
 	// cout << "Current read is " << rho << endl;
 
-	if (this->curHistory.size() < this->historySize){
-		logOut << "[ESTIMATOR] Not enough history! Adding this observed " << rho <<" to the history queue!" << endl;
-		curHistory.push_back(rho);
+	if (this->noOfHistory < this->historySize){
+		LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] Not enough history! Adding this observed " << rho <<" to the history queue!";
+		this->ring[this->noOfHistory] = rho;
+		this->ring[this->noOfHistory + this->historySize] = rho;
+		this->noOfHistory++;
 		this->historyL2Norm = this->historyL2Norm + rho * rho;
 		return rho;
 	}
 
-	assert(this->historySize == this->curHistory.size());
 	assert(this->historySize == this->weight.size());
 
 	double err = rho - this->est; // Estimation error
@@ -162,9 +317,7 @@ double Estimator::observeRho(ifstream &logIn, ofstream &logOut){
 
 
 	// Update the weight
-	for (int i = 0; i < this->historySize; i++){
-		this->weight.at(i) = this->weight.at(i) + this->mu * err * this->curHistory.at(i);
-	}
+	estAxpy(this->weight.data(), this->mu * err, this->ring.data() + this->head, this->historySize);
 
 #ifdef doCUSUM
 	// Update parameters
@@ -173,59 +326,112 @@ double Estimator::observeRho(ifstream &logIn, ofstream &logOut){
 
 	if (this->g1 > this->h || this->g2 > this->h){
 
-		logOut << "[ESTIMATOR] CUSUM detects abrupt changes" << endl;
+		LOG_TO(logOut, LOG_DEBUG) << "[ESTIMATOR] CUSUM detects abrupt changes";
 		this->g1 = 0;
 		this->g2 = 0;
 
 		// Reset lookback
 		this->curLookback = 1;
-		double tmp = 0;
-
-		for (int i = 0; i < this->historySize; i++){
-			tmp = tmp + this->weight.at(i) / this->curLookback;
-		}
-
-		for (int i = 0; i < this->historySize; i++){
-			if (i < (this->historySize - this->curLookback)){
-				this->weight.at(i) = 0;
-			}
-			else{
-				this->weight.at(i) = tmp;
-			}
-		}
 	}
-	else {
-		if (this->curLookback < this->historySize){
-			this->curLookback = min(this->curLookback + 2, 10);
-		}
-
-		double tmp = 0;
+	else if (this->curLookback < this->historySize){
+		this->curLookback = min(this->curLookback + 2, 10);
+	}
 
-		for (int i = 0; i < this->historySize; i++){
-			tmp = tmp + this->weight.at(i) / this->curLookback;
-		}
+	// Spread the weight evenly over the last curLookback minutes
+	double tmp = 0;
 
-		for (int i = 0; i < this->historySize; i++){
-			if (i < (this->historySize - this->curLookback)){
-				this->weight.at(i) = 0;
-			}
-			else{
-				this->weight.at(i) = tmp;
-			}
-		}
+	for (int i = 0; i < this->historySize; i++){
+		tmp = tmp + this->weight[i] / this->curLookback;
+	}
 
+	for (int i = 0; i < this->historySize; i++){
+		this->weight[i] = i < (this->historySize - this->curLookback) ? 0 : tmp;
 	}
 #endif
 
-	// Update history and its L2 Norm
-	this->historyL2Norm = this->historyL2Norm - this->curHistory.at(0) * this->curHistory.at(0) + rho * rho;
+	// Update history and its L2 Norm. The oldest sample is overwritten by the new one in both copies.
+	this->historyL2Norm = this->historyL2Norm - this->ring[this->head] * this->ring[this->head] + rho * rho;
 
-	this->curHistory.pop_front();
-	this->curHistory.push_back(rho);
+	this->ring[this->head] = rho;
+	this->ring[this->head + this->historySize] = rho;
+	this->head = (this->head + 1) % this->historySize;
 
-	logOut << "[ESTIMATOR] New utilization is observed successfully! The observed rho is " << rho << endl;
+	LOG_TO(logOut, LOG_INFO) << "[ESTIMATOR] New utilization is observed successfully! The observed rho is " << rho;
 
 	this->noOfObserved++;  
 
 	return rho;
 }
+
+void Estimator::save(CheckpointWriter &out) const{
+	out.put(this->g1);
+	out.put(this->g2);
+	out.put(this->mu);
+	out.put(this->historySize);
+	out.put(this->weight.data(), this->historySize);
+	out.put(vector<double>(this->ring.begin() + this->head, this->ring.begin() + this->head + this->noOfHistory)); // Window, oldest first
+	out.put(this->historyL2Norm);
+	out.put(this->curLookback);
+	out.put(this->est);
+	out.put(this->estErrorAbs);
+	out.put(this->estErrorPerc);
+	out.put(this->noOfObserved);
+	out.put(this->immediatePastUtil);
+	out.put(this->estimatorStatus);
+	out.put(this->observorStatus);
+
+	out.put(this->prediction, NO_OF_PREDICTORS);
+	out.put(this->recentError, NO_OF_PREDICTORS);
+	out.put(this->predicted);
+	out.put(this->ewma);
+	out.put(this->changeMean);
+	out.put(this->changeCount);
+	out.put(this->changeG1);
+	out.put(this->changeG2);
+	out.put(this->picked);
+	out.put(vector<int>(this->picks, this->picks + NO_OF_PREDICTORS));
+}
+
+void Estimator::restore(CheckpointReader &in){
+	in.get(this->g1);
+	in.get(this->g2);
+	in.get(this->mu);
+	in.get(this->historySize);
+	this->weight.assign(this->historySize, 0);
+	in.get(this->weight.data(), this->historySize);
+
+	vector<double> window;
+	in.get(window);
+	assert(window.size() <= this->historySize);
+	this->ring.assign(2 * this->historySize, 0);
+	this->head = 0;
+	this->noOfHistory = window.size();
+	for (int i = 0; i < this->noOfHistory; i++){
+		this->ring[i] = window[i];
+		this->ring[i + this->historySize] = window[i];
+	}
+
+	in.get(this->historyL2Norm);
+	in.get(this->curLookback);
+	in.get(this->est);
+	in.get(this->estErrorAbs);
+	in.get(this->estErrorPerc);
+	in.get(this->noOfObserved);
+	in.get(this->immediatePastUtil);
+	in.get(this->estimatorStatus);
+	in.get(this->observorStatus);
+
+	in.get(this->prediction, NO_OF_PREDICTORS);
+	in.get(this->recentError, NO_OF_PREDICTORS);
+	in.get(this->predicted);
+	in.get(this->ewma);
+	in.get(this->changeMean);
+	in.get(this->changeCount);
+	in.get(this->changeG1);
+	in.get(this->changeG2);
+	in.get(this->picked);
+	vector<int> picks;
+	in.get(picks);
+	assert(picks.size() == NO_OF_PREDICTORS);
+	copy(picks.begin(), picks.end(), this->picks);
+}
@@ -30,35 +30,89 @@
 */
 
 
+/*
+Utilization estimator. An NLMS filter predicts the next minute from the last est_lookback minutes (historySize). The history is a 
+circular buffer stored twice over, so the window is always contiguous, oldest first, and the prediction and the weight update run as 
+one dot product and one axpy over it (AVX2 when the processor has it). All state, the change detector included, is per estimator. 
+
+With EST_ENSEMBLE (config.h), four predictors run side by side: the NLMS filter, the immediately past utilization, an EWMA 
+(EST_EWMA_ALPHA), and the mean since the last change a CUSUM detector found. Every minute the estimate is the prediction of the one 
+with the lowest recent squared error, decayed by EST_ENSEMBLE_DECAY per minute. 
+*/
+
 #ifndef ESTIMATOR_H
 #define ESTIMATOR_H
 
 #include<vector>
 #include<assert.h>
 #include<algorithm>
-#include<deque>
 #include<iostream>
 #include<fstream>
+#include<new>
+#include<string>
 #include "const.h"
 #include "config.h"
+#include "Logger.h"
+#include "TraceSource.h"
 #include<sstream>
 using namespace std;
 
+class CheckpointWriter;
+class CheckpointReader;
+
+// Allocator of vectors the AVX2 kernels load with aligned loads
+template<class T, size_t ALIGN = 32>
+struct AlignedAllocator{
+	typedef T value_type;
+	template<class U> struct rebind{ typedef AlignedAllocator<U, ALIGN> other; };
+
+	AlignedAllocator() = default;
+	template<class U> AlignedAllocator(const AlignedAllocator<U, ALIGN> &){}
+
+	T *allocate(size_t n){ return static_cast<T *>(::operator new(n * sizeof(T), align_val_t(ALIGN))); }
+	void deallocate(T *p, size_t){ ::operator delete(p, align_val_t(ALIGN)); }
+
+	template<class U> bool operator==(const AlignedAllocator<U, ALIGN> &) const { return true; }
+	template<class U> bool operator!=(const AlignedAllocator<U, ALIGN> &) const { return false; }
+};
+
+typedef vector<double, AlignedAllocator<double>> AlignedVector;
+
+// Predictors of the ensemble
+enum EstPredictor{ EST_NLMS, EST_IMMEDIATE_PAST, EST_EWMA, EST_CUSUM_MEAN, NO_OF_PREDICTORS };
+
+string estPredictorName(int);
+
 class Estimator{
 private:
 	static const double a;
-	static double g1;
-	static double g2;
+	double g1 = 0; // Change detector state
+	double g2 = 0;
 	static const double h;
 	static const double v;
-	static double mu;
+	double mu = 0;
 	
 	int historySize; // Maximum lookback
-	vector<double> weight; // Weight for history
-	deque<double> curHistory; // Store history utilization 
+	AlignedVector weight; // Weight for history, oldest first
+	AlignedVector ring; // History utilization, twice over. ring[head .. head + historySize) is the window, oldest first
+	int head = 0; // Oldest sample of a full window
+	int noOfHistory = 0; // Samples in the window
 	double historyL2Norm;
 	int curLookback; // Look back
 
+	// Ensemble
+	double prediction[NO_OF_PREDICTORS] = {}; // What each predictor said about the coming minute
+	double recentError[NO_OF_PREDICTORS] = {}; // Decayed squared error of each predictor
+	bool predicted = false; // If prediction holds this minute's predictions
+	double ewma = 0;
+	double changeMean = 0; // Mean since the last change
+	int changeCount = 0; // Samples in it, at most historySize
+	double changeG1 = 0; // Change detector of the CUSUM-reset mean
+	double changeG2 = 0;
+
+	double predictNLMS() const;
+	void observeEnsemble(double); // Score the predictions against an observation and update the predictors
+
 public:
 	double est; // Estimated utilization
 	double estErrorAbs; // Estimation error in abs
@@ -66,15 +120,21 @@ public:
 	int noOfObserved; // No of samples observed. 
 	double immediatePastUtil; // Immediately past utilization
 
+	int picked = EST_NLMS; // Predictor the ensemble estimated with
+	int picks[NO_OF_PREDICTORS] = {}; // Minutes each predictor was picked
+
 	bool estimatorStatus = true;
 	bool observorStatus = true;
 
 	Estimator() = default;
-	Estimator(int, ifstream &, ofstream &);
+	Estimator(int, Logger &); // Maximum lookback, log
+
+	void estimateRho(Logger &); // Estimate rho based on history
+	void estimateRho(Logger &, TraceSource &); // Estimate rho offline
+	double observeRho(TraceSource &, Logger &); // Observe a new utilization. Negative at the end of the trace.
 
-	void estimateRho(ofstream &); // Estimate rho based on history
-	void estimateRho(ofstream &, ifstream &); // Estimate rho offline
-	double observeRho(ifstream &, ofstream &); // Observe a new utilization 
+	void save(CheckpointWriter &) const; // Weights, history, change detectors and the ensemble (Checkpoint.h)
+	void restore(CheckpointReader &);
 };
 
 #endif
\ No newline at end of file
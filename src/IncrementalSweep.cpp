@@ -0,0 +1,294 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "IncrementalSweep.h"
+#include<assert.h>
+
+// One FCFS step, as in simQueue. Returns true if the job found the server idle.
+static inline bool stepJob(double &ER, double &opLength, double &offLength, double &wakeUps, double &prevDepart, double arrival, 
+	double service, double freq, double wakeUp){
+
+	if (arrival <= prevDepart){
+		opLength = opLength + service / freq;
+		prevDepart = prevDepart + service / freq;
+		ER = ER + prevDepart - arrival;
+		return false;
+	}
+	offLength = offLength + arrival - prevDepart;
+	opLength = opLength + service / freq + wakeUp;
+	prevDepart = arrival + service / freq + wakeUp;
+	wakeUps = wakeUps + 1;
+	ER = ER + prevDepart - arrival;
+	return true;
+}
+
+IncrementalSweep::IncrementalSweep(int cacheSize){
+	assert(cacheSize >= 1);
+	this->states.resize(cacheSize);
+}
+
+/*
+Simulate jobs [from, last) of the state from an empty server, as simQueue does: the first job starts the system after firstGap. 
+*/
+void IncrementalSweep::build(WindowState &state, const PowerState &policy, PolicyWindow &window, JobHistory &jobLog, long from, double firstGap) const{
+
+	const double *service = jobLog.getServices();
+	long logFirst = jobLog.getFirstJobNo();
+	double freq = policy.freq;
+
+	window = PolicyWindow();
+	double arrival = state.arrival[from - state.first];
+	window.prevDepart = arrival + service[from - logFirst] / freq;
+	window.ER = window.prevDepart - arrival;
+	window.opLength = 0 + window.prevDepart - arrival;
+	window.offLength = 0 + firstGap;
+
+	this->append(state, policy, window, jobLog, from + 1);
+}
+
+/*
+Continue the simulation with jobs [from, last), keeping a checkpoint at an idle job every CHECKPOINT_SPACING jobs or more. 
+*/
+void IncrementalSweep::append(WindowState &state, const PowerState &policy, PolicyWindow &window, JobHistory &jobLog, long from) const{
+
+	const double *service = jobLog.getServices() - jobLog.getFirstJobNo();
+	const double *arrival = state.arrival.data() - state.first;
+	double freq = policy.freq;
+	double wakeUp = policy.wakeUp;
+	long lastCheckpoint = window.checkpoints.empty() ? from - CHECKPOINT_SPACING : window.checkpoints.back().job;
+
+	// Locals, so the sums stay in registers
+	double ER = window.ER;
+	double opLength = window.opLength;
+	double offLength = window.offLength;
+	double wakeUps = window.wakeUps;
+	double prevDepart = window.prevDepart;
+
+	for (long job = from; job < state.last; job++){
+		bool idle = stepJob(ER, opLength, offLength, wakeUps, prevDepart, arrival[job], service[job], freq, wakeUp);
+		if (idle && job - lastCheckpoint >= CHECKPOINT_SPACING){
+			window.checkpoints.push_back({ job, prevDepart, ER, opLength, offLength, wakeUps });
+			lastCheckpoint = job;
+		}
+	}
+
+	window.ER = ER;
+	window.opLength = opLength;
+	window.offLength = offLength;
+	window.wakeUps = wakeUps;
+	window.prevDepart = prevDepart;
+}
+
+/*
+Drop the jobs before newFirst. The remaining window starts on an empty server after firstGap. The new run is simulated until its 
+departure equals the old run's at a checkpoint, and the sums from there on are corrected by the difference. Checkpoints passed on the 
+way are rewritten with the new run. Returns false if the runs do not meet at any checkpoint, in which case the caller has to build 
+the window again. noOfSimulated is set to the jobs simulated. 
+*/
+bool IncrementalSweep::retire(WindowState &state, const PowerState &policy, PolicyWindow &window, JobHistory &jobLog, long newFirst, 
+	double firstGap, long &noOfSimulated) const{
+
+	const double *service = jobLog.getServices() - jobLog.getFirstJobNo();
+	const double *arrival = state.arrival.data() - state.first;
+	double freq = policy.freq;
+	double wakeUp = policy.wakeUp;
+
+	// The first job of the new window starts the system without a wake-up, so the runs can only meet after it
+	while (!window.checkpoints.empty() && window.checkpoints.front().job <= newFirst){
+		window.checkpoints.pop_front();
+	}
+
+	// Jobs from newFirst on an empty server
+	double prevDepart = arrival[newFirst] + service[newFirst] / freq;
+	double ER = prevDepart - arrival[newFirst];
+	double opLength = 0 + prevDepart - arrival[newFirst];
+	double offLength = 0 + firstGap;
+	double wakeUps = 0;
+	long job = newFirst + 1;
+
+	/*
+	With a wake-up latency, a job that found the old run idle can find the new one busy and leave later, so the runs are only known 
+	to be the same from a job on whose departure is the same in both. 
+	*/
+	for (auto meet = window.checkpoints.begin(); meet != window.checkpoints.end(); ++meet){
+		for (; job <= meet->job; job++){
+			stepJob(ER, opLength, offLength, wakeUps, prevDepart, arrival[job], service[job], freq, wakeUp);
+		}
+
+		if (prevDepart != meet->prevDepart){
+			*meet = { meet->job, prevDepart, ER, opLength, offLength, wakeUps };
+			continue;
+		}
+
+		double dER = ER - meet->ER;
+		double dOpLength = opLength - meet->opLength;
+		double dOffLength = offLength - meet->offLength;
+		double dWakeUps = wakeUps - meet->wakeUps;
+		window.ER = window.ER + dER;
+		window.opLength = window.opLength + dOpLength;
+		window.offLength = window.offLength + dOffLength;
+		window.wakeUps = window.wakeUps + dWakeUps;
+		for (auto checkpoint = meet; checkpoint != window.checkpoints.end(); ++checkpoint){
+			checkpoint->ER = checkpoint->ER + dER;
+			checkpoint->opLength = checkpoint->opLength + dOpLength;
+			checkpoint->offLength = checkpoint->offLength + dOffLength;
+			checkpoint->wakeUps = checkpoint->wakeUps + dWakeUps;
+		}
+
+		noOfSimulated = job - newFirst;
+		return true;
+	}
+
+	noOfSimulated = job - newFirst;
+	return false;
+}
+
+bool IncrementalSweep::simulate(const vector<shared_ptr<PowerState>> &policies, JobHistory &jobLog, double est, double maxER, 
+	ThreadPool &pool, vector<PolicyResult> &results){
+
+	this->noOfCalls++;
+
+	long logFirst = jobLog.getFirstJobNo();
+	long logLast = logFirst + jobLog.getSize();
+	const double *interArr = jobLog.getInterArrivals();
+	const double *rho = jobLog.getUtilizations();
+	const double *service = jobLog.getServices();
+	int noOfPolicies = policies.size();
+	int noOfJobs = logLast - logFirst;
+
+	// A state for this estimate that still overlaps the log, or else the least recently used one
+	WindowState *state = nullptr;
+	WindowState *oldest = &this->states.at(0);
+	for (auto &candidate : this->states){
+		if (candidate.est == est && candidate.last > logFirst && candidate.last <= logLast){
+			state = &candidate;
+		}
+		if (candidate.lastUsed < oldest->lastUsed){
+			oldest = &candidate;
+		}
+	}
+
+	bool update = state != nullptr;
+	long oldLast = logLast;
+	if (update){
+		// New jobs continue the rescaled arrival times
+		oldLast = state->last;
+		for (long job = oldLast; job < logLast; job++){
+			state->arrival.push_back(state->arrival.back() + interArr[job - logFirst] * (rho[job - logFirst] / est));
+		}
+		state->last = logLast;
+		this->reused++;
+	}
+	else {
+		state = oldest;
+		state->est = est;
+		state->first = logFirst;
+		state->last = logLast;
+		state->arrival.clear();
+		double arrTimeNew = 0;
+		for (long job = logFirst; job < logLast; job++){
+			arrTimeNew = arrTimeNew + interArr[job - logFirst] * (rho[job - logFirst] / est);
+			state->arrival.push_back(arrTimeNew);
+		}
+		state->policies.assign(noOfPolicies, PolicyWindow());
+		this->rebuilt++;
+	}
+	state->lastUsed = this->noOfCalls;
+
+	double firstGap = interArr[0] * (rho[0] / est); // Rescaled as in doSleepScale
+
+	/*
+	Work bound. Starting empty, job j cannot leave before all work since the first arrival is done, so the window's sum of response 
+	times is at least workSum / f - arrivalSum. 
+	*/
+	const double *arrival = state->arrival.data() - state->first;
+	double workSum = 0;
+	double arrivalSum = 0;
+	double work = 0;
+	for (long job = logFirst; job < logLast; job++){
+		work = work + service[job - logFirst];
+		workSum = workSum + work;
+		arrivalSum = arrivalSum + arrival[job] - arrival[logFirst];
+	}
+
+	vector<long> simulated(noOfPolicies, 0);
+	vector<char> pruned(noOfPolicies, 0);
+
+	pool.parallelFor(noOfPolicies - 1, [&](int task){
+		int p = task + 1;
+		const PowerState &policy = *policies.at(p);
+		PolicyWindow &window = state->policies.at(p);
+
+		double boundER = (workSum / policy.freq - arrivalSum) / noOfJobs;
+		if (boundER > maxER){
+			// Cannot be picked. Its simulation is dropped and rebuilt if it is needed again.
+			window = PolicyWindow();
+			results.at(p).ER = boundER;
+			results.at(p).EP = policy.actPwr;
+			pruned.at(p) = 1;
+			return;
+		}
+
+		if (!window.valid){
+			this->build(*state, policy, window, jobLog, logFirst, firstGap);
+			simulated.at(p) = noOfJobs;
+		}
+		else {
+			this->append(*state, policy, window, jobLog, oldLast);
+			simulated.at(p) = logLast - oldLast;
+			if (logFirst > state->first){
+				long retired = 0;
+				bool met = this->retire(*state, policy, window, jobLog, logFirst, firstGap, retired);
+				simulated.at(p) = simulated.at(p) + retired;
+				if (!met){
+					this->build(*state, policy, window, jobLog, logFirst, firstGap);
+					simulated.at(p) = simulated.at(p) + noOfJobs;
+				}
+			}
+		}
+		window.valid = true;
+
+		double totalLength = window.opLength + window.offLength; // Total operation length
+		results.at(p).EP = policy.energy(window.opLength, window.offLength, window.wakeUps) / totalLength; // Power consumption of this policy
+		results.at(p).ER = window.ER / noOfJobs; // Response time of this policy
+	});
+
+	state->arrival.erase(state->arrival.begin(), state->arrival.begin() + (logFirst - state->first));
+	state->first = logFirst;
+
+	for (int p = 1; p < noOfPolicies; p++){
+		this->jobsSimulated = this->jobsSimulated + simulated.at(p);
+		this->pruned = this->pruned + pruned.at(p);
+	}
+
+	return update;
+}
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Incremental policy sweep over the sliding job log. Every minute only the jobs of about one minute enter the log and as many leave, so 
+instead of simulating the whole window for every policy, the state of each policy's simulation is carried over and updated: 
+
+	append   the new jobs continue the simulation from the last departure. 
+	retire   the oldest jobs are dropped. The window now starts on an empty server, and the remaining jobs are simulated again until 
+	         the new run meets the old one: a job whose departure is the same in both runs departs the same way, and so does every 
+	         job after it. The sums of the rest are corrected by the difference. 
+
+Jobs that found the server idle are kept as checkpoints with their departure and the sums up to them, at least CHECKPOINT_SPACING jobs 
+apart, and meeting is checked by comparing departures there. Without a wake-up latency a job that found the old run idle finds the new 
+one idle too, so the runs meet at the first checkpoint and retiring costs about CHECKPOINT_SPACING jobs. With one, the departure is not 
+monotone in the previous departure: a job that found the old run idle may find the new run busy behind a wake-up and leave later. The 
+runs then meet at a later checkpoint, or not at all, and the window is built again. 
+
+A policy slower than the load never idles, so its runs never meet and it would be simulated in full every step. Such policies cannot 
+meet the response time target anyway: a lower bound of the window's response times from the work arrived so far proves it, and they 
+are skipped, so the pick is unchanged. 
+
+doSleepScale rescales the inter-arrival times of the log by the estimated utilization, which changes from step to step, so a state is 
+only valid for one estimate. States are kept for the INCREMENTAL_CACHE_SIZE estimates used last (config.h): traces move among a few 
+dozen utilization levels, so most steps find their estimate in the cache. A state whose jobs have all left the log is rebuilt by a 
+full simulation, which gives the same results as simQueue. Updated states add the same numbers in a different order, so their results 
+can differ from a full simulation in the last bits (SLEEPSCALE_INCREMENTAL_VERIFY checks them). 
+*/
+
+#ifndef INCREMENTALSWEEP_H
+#define INCREMENTALSWEEP_H
+
+#include "PowerState.h"
+#include "JobHistory.h"
+#include "ThreadPool.h"
+#include<deque>
+#include<vector>
+#include<memory>
+using namespace std;
+
+class IncrementalSweep{
+
+private:
+	static const int CHECKPOINT_SPACING = 64;
+
+	// A job that found the server idle, with the sums over the window up to and including it
+	struct Checkpoint{
+		long job;
+		double prevDepart; // Its departure
+		double ER;
+		double opLength;
+		double offLength;
+		double wakeUps;
+	};
+
+	// Simulation of one policy over the window
+	struct PolicyWindow{
+		double ER = 0;
+		double opLength = 0;
+		double offLength = 0;
+		double wakeUps = 0;
+		double prevDepart = 0; // Departure of the last job
+		deque<Checkpoint> checkpoints;
+		bool valid = false; // False until built, and after the policy was pruned
+	};
+
+	// Simulations of every policy for one estimate. Jobs are numbered as in JobHistory::getFirstJobNo.
+	struct WindowState{
+		double est = -1;
+		long first = 0; // First job of the window
+		long last = 0; // One past the last job
+		vector<double> arrival; // Rescaled arrival times of jobs [first, last)
+		vector<PolicyWindow> policies;
+		long lastUsed = 0;
+	};
+
+	vector<WindowState> states;
+	long noOfCalls = 0;
+
+	void build(WindowState &, const PowerState &, PolicyWindow &, JobHistory &, long, double) const; // From job, idle time before it
+	void append(WindowState &, const PowerState &, PolicyWindow &, JobHistory &, long) const; // From job
+	bool retire(WindowState &, const PowerState &, PolicyWindow &, JobHistory &, long, double, long &) const; // New first job, idle time before it, jobs simulated
+
+public:
+	int reused = 0; // Calls served by updating a cached state
+	int rebuilt = 0; // Calls that simulated the whole window
+	long jobsSimulated = 0; // Jobs simulated, summed over the policies
+	long pruned = 0; // Policy simulations skipped by the work bound
+
+	IncrementalSweep(int); // Number of estimates to keep states for
+
+	/*
+	Simulate policies[1, n) for the current log and estimate into results[1, n). Policies that provably miss the response time target 
+	maxER get a lower bound of their ER instead (and their active power as EP). True if a cached state was updated. 
+	*/
+	bool simulate(const vector<shared_ptr<PowerState>> &, JobHistory &, double, double, ThreadPool &, vector<PolicyResult> &);
+};
+
+#endif
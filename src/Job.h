@@ -50,4 +50,13 @@ public:
 
 };
 
+/*
+A job stream as parallel arrays of arrival and service times, e.g., a view into the job log. It does not own the data. 
+*/
+struct JobStreamView{
+	const double *arrival;
+	const double *service;
+	int noOfJobs;
+};
+
 #endif
\ No newline at end of file
@@ -32,28 +32,58 @@
 
 
 #include "JobHistory.h"
-
+#include "Checkpoint.h"
+#include<iostream>
+#include<exception>
+#include<algorithm>
+#include<assert.h>
+
+JobHistory::JobHistory(){
+	this->arrival.assign(2 * this->size, 0.0);
+	this->gapFromPrevious.assign(2 * this->size, 0.0);
+	this->service.assign(2 * this->size, 0.0);
+	this->whatRho.assign(2 * this->size, 0.0);
+}
 
 double JobHistory::getArrAt(int i){
-	return this->jobStream.at(i).arrival;
+	assert(i >= 0 && i < this->count);
+	return this->arrival[this->head + i];
 }
 
 double JobHistory::getInterArrAt(int i){
-	return this->jobStream.at(i).gapFromPrevious;
+	assert(i >= 0 && i < this->count);
+	return this->gapFromPrevious[this->head + i];
 }
 
 double JobHistory::getUtilizationAt(int i){
-	return this->jobStream.at(i).whatRho;
+	assert(i >= 0 && i < this->count);
+	return this->whatRho[this->head + i];
 }
 
 double JobHistory::getSerAt(int i){
-	return this->jobStream.at(i).service;
+	assert(i >= 0 && i < this->count);
+	return this->service[this->head + i];
+}
+
+const double *JobHistory::getArrivals() const{
+	return this->arrival.data() + this->head;
 }
 
+const double *JobHistory::getInterArrivals() const{
+	return this->gapFromPrevious.data() + this->head;
+}
+
+const double *JobHistory::getServices() const{
+	return this->service.data() + this->head;
+}
+
+const double *JobHistory::getUtilizations() const{
+	return this->whatRho.data() + this->head;
+}
 
 
 bool JobHistory::readyForSleepScale(){
-	if (this->jobStream.size() == this->size){
+	if (this->count == this->size){
 		return true;
 	}
 	else{
@@ -61,30 +91,81 @@ bool JobHistory::readyForSleepScale(){
 	}
 }
 
+// Write a job to a ring slot and to its mirror
+void JobHistory::writeSlot(int slot, const Job &newJob){
+	this->arrival[slot] = this->arrival[slot + this->size] = newJob.arrival;
+	this->gapFromPrevious[slot] = this->gapFromPrevious[slot + this->size] = newJob.gapFromPrevious;
+	this->service[slot] = this->service[slot + this->size] = newJob.service;
+	this->whatRho[slot] = this->whatRho[slot + this->size] = newJob.whatRho;
+}
 
-void JobHistory::insertNewJob(Job newJob){
+void JobHistory::insertNewJob(const Job &newJob){
 
-	this->jobStream.push_back(newJob);
+	this->noOfInserted++;
 
-	if (this->jobStream.size() > size){
-		this->jobStream.pop_front();
+	if (this->count < this->size){
+		// Not full yet, so head is still 0
+		this->writeSlot(this->count, newJob);
+		this->count++;
+	}
+	else{
+		// Overwrite the oldest job
+		this->writeSlot(this->head, newJob);
+		this->head = (this->head + 1) % this->size;
 	}
 }
 
-void JobHistory::insertNewJobVector(deque<Job> &newJobVector){
+void JobHistory::insertNewJobVector(const vector<Job> &newJobVector, int first, int n){
 
-	while (newJobVector.size() != 0){
-		Job pop = newJobVector.front();
-		this->jobStream.push_back(pop);
+	assert(first >= 0 && first + n <= newJobVector.size());
 
-		if (this->jobStream.size() > size){
-			this->jobStream.pop_front();
-		}
+	// Only the last size jobs survive
+	if (n > this->size){
+		first = first + n - this->size;
+		n = this->size;
+	}
 
+	for (int i = first; i < first + n; i++){
+		this->insertNewJob(newJobVector[i]);
 	}
 
 }
 
 int JobHistory::getSize(){
-	return this->jobStream.size();
+	return this->count;
+}
+
+long JobHistory::getFirstJobNo() const{
+	return this->noOfInserted - this->count;
+}
+void JobHistory::save(CheckpointWriter &out) const{
+	out.put(this->size);
+	out.put(this->noOfInserted);
+	out.put(this->getArrivals(), this->count);
+	out.put(this->getInterArrivals(), this->count);
+	out.put(this->getServices(), this->count);
+	out.put(this->getUtilizations(), this->count);
+}
+
+void JobHistory::restore(CheckpointReader &in){
+
+	int size;
+	in.get(size);
+	if (size != this->size){
+		cerr << "The checkpoint has a job log of " << size << " jobs, this build keeps " << this->size << " (JOB_LOG_LENGTH)!" << endl;
+		terminate();
+	}
+	in.get(this->noOfInserted);
+
+	// Back to a log starting at slot 0, then mirrored
+	vector<double> *columns[] = { &this->arrival, &this->gapFromPrevious, &this->service, &this->whatRho };
+	vector<double> window;
+	for (auto column : columns){
+		in.get(window);
+		assert(window.size() <= this->size);
+		copy(window.begin(), window.end(), column->begin());
+		copy(window.begin(), window.end(), column->begin() + this->size);
+		this->count = window.size();
+	}
+	this->head = 0;
 }
@@ -32,7 +32,6 @@
 #ifndef JOBQUEUE_H
 #define JOBQUEUE_H
 
-#include<deque>
 #include<vector>
 #include "Job.h"
 #include "const.h"
@@ -40,25 +39,51 @@
 
 using namespace std;
 
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+Job log of the last JOB_LOG_LENGTH jobs, kept as a fixed-capacity ring buffer of parallel arrays (arrival, gap, service time and 
+utilization). Every entry is stored twice, at slot i and at slot i + size, so the live window always starts at the oldest job and is 
+contiguous. The simulator reads it in place through the get...() pointers without copying. 
+*/
 class JobHistory{
 
 private:
-	deque<Job> jobStream; // default jobStream of size 10000 used by SleepScale to simulate
+	int head = 0; // Slot of the oldest job
+	int count = 0; // Number of jobs in the log
+	long noOfInserted = 0; // Jobs ever inserted
+	vector<double> arrival; // 2 * size slots each
+	vector<double> gapFromPrevious;
+	vector<double> service;
+	vector<double> whatRho;
+
+	void writeSlot(int, const Job &);
 
 public:
 
 	int size = JOB_LOG_LENGTH;
-	JobHistory() = default;
+	JobHistory();
 
-	void insertNewJobVector(deque<Job> &);
-	void insertNewJob(Job);
+	void insertNewJobVector(const vector<Job> &, int, int); // Append jobs [first, first + n) of a vector in one batch
+	void insertNewJob(const Job &);
 	int getSize();
+	long getFirstJobNo() const; // Number of the oldest job in the log, counting every job ever inserted from 0
 	bool readyForSleepScale();
 	double getArrAt(int); // Get the arrival time of a job
 	double getInterArrAt(int); // Get the gap between this job and its previous job
 	double getSerAt(int); // Get the service time of a job
 	double getUtilizationAt(int); // Get the utilization at which this job is genereated. 
 
+	// Contiguous views of the log, oldest job first, valid for getSize() entries until the next insert
+	const double *getArrivals() const;
+	const double *getInterArrivals() const;
+	const double *getServices() const;
+	const double *getUtilizations() const;
+
+	void save(CheckpointWriter &) const; // The live window, oldest job first (Checkpoint.h)
+	void restore(CheckpointReader &);
+
 };
 
 
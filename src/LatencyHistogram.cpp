@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "LatencyHistogram.h"
+#include<cassert>
+#include<cmath>
+
+// Lower edge of a bucket, ms
+static double bucketStart(int bucket){
+	uint64_t bits = static_cast<uint64_t>(bucket + ((1023 + HISTOGRAM_MIN_EXPONENT) << HISTOGRAM_SUB_BITS)) << (52 - HISTOGRAM_SUB_BITS);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+LatencyHistogram::LatencyHistogram(){
+	this->clear();
+}
+
+void LatencyHistogram::clear(){
+	memset(this->counts, 0, sizeof(this->counts));
+	this->total = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const{
+	return this->total;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other){
+	for (int b = 0; b < HISTOGRAM_BUCKETS; b++){
+		this->counts[b] = this->counts[b] + other.counts[b];
+	}
+	this->total = this->total + other.total;
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram &other){
+	assert(other.total <= this->total);
+	for (int b = 0; b < HISTOGRAM_BUCKETS; b++){
+		this->counts[b] = this->counts[b] - other.counts[b];
+	}
+	this->total = this->total - other.total;
+}
+
+/*
+The value reported for a bucket is its midpoint. 
+*/
+double LatencyHistogram::percentile(double p) const{
+
+	assert(p > 0 && p <= 100);
+	if (this->total == 0){
+		return 0;
+	}
+
+	uint64_t rank = static_cast<uint64_t>(ceil(p / 100 * this->total));
+	rank = rank < 1 ? 1 : rank;
+	uint64_t seen = 0;
+	int b = 0;
+	for (; b < HISTOGRAM_BUCKETS - 1; b++){
+		seen = seen + this->counts[b];
+		if (seen >= rank){
+			break;
+		}
+	}
+	return (bucketStart(b) + bucketStart(b + 1)) / 2;
+}
+
+double LatencyHistogram::max() const{
+	for (int b = HISTOGRAM_BUCKETS - 1; b >= 0; b--){
+		if (this->counts[b] != 0){
+			return bucketStart(b + 1);
+		}
+	}
+	return 0;
+}
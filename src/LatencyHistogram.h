@@ -0,0 +1,85 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Response time histogram with log-linear buckets, in the style of HDR histograms. Each power of two between 2^HISTOGRAM_MIN_EXPONENT and 
+2^HISTOGRAM_MAX_EXPONENT ms is split into 2^HISTOGRAM_SUB_BITS equal buckets, so a percentile is off by at most half a bucket, 1/64 of the 
+value. Shorter times count in the first bucket and longer ones in the last. 
+
+The bucket of a value is read off its bits: the exponent and the top mantissa bits, one shift. The memory is fixed, so recording never 
+allocates, and histograms of the same jobs split over threads or runs merge by adding their counts. 
+*/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include<cstdint>
+#include<cstring>
+using namespace std;
+
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_MIN_EXPONENT -10 // About 1 us
+#define HISTOGRAM_MAX_EXPONENT 22 // About 70 minutes
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_MIN_EXPONENT) << HISTOGRAM_SUB_BITS)
+
+class LatencyHistogram{
+
+private:
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	uint64_t total;
+
+public:
+	LatencyHistogram(); // Empty
+
+	void clear();
+	uint64_t getCount() const;
+
+	// Count a response time, ms
+	void record(double value){
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		int64_t bucket = static_cast<int64_t>(bits >> (52 - HISTOGRAM_SUB_BITS)) - (static_cast<int64_t>(1023 + HISTOGRAM_MIN_EXPONENT) << HISTOGRAM_SUB_BITS);
+		bucket = bucket < 0 ? 0 : bucket; // Below the range, or zero
+		bucket = bucket >= HISTOGRAM_BUCKETS ? (value > 0 ? HISTOGRAM_BUCKETS - 1 : 0) : bucket; // Above the range, or negative (sign bit set)
+		this->counts[bucket]++;
+		this->total++;
+	}
+
+	void merge(const LatencyHistogram &); // Add the counts of another histogram
+	void subtract(const LatencyHistogram &); // Remove counts that were merged or recorded before
+
+	double percentile(double) const; // Smallest value with at least p percent of the counts at or below it, 0 < p <= 100. 0 if empty.
+	double max() const; // Upper edge of the highest non-empty bucket
+};
+
+#endif
@@ -0,0 +1,378 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Logger.h"
+#include<chrono>
+#include<sstream>
+#include<assert.h>
+#include<unistd.h>
+
+const char *Logger::BINARY_MAGIC = "SSLOG01";
+
+static uint64_t nowNs(){
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Logger::~Logger(){
+	this->close();
+}
+
+void Logger::open(const string fileName, LogLevel level, bool binary, bool append){
+
+	// A binary log starts a new literal dictionary, so it is never appended to
+	append = append && !binary;
+	this->bytesWritten = 0;
+	if (append){
+		ifstream existing(fileName, ios::binary | ios::ate);
+		this->bytesWritten = existing.is_open() ? static_cast<uint64_t>(existing.tellg()) : 0;
+	}
+
+	this->file.exceptions(ofstream::failbit | ofstream::badbit);
+	try{
+		this->file.open(fileName, binary ? (ios::out | ios::binary) : (append ? ios::app : ios::out));
+	}
+	catch (const ofstream::failure &e){
+		cerr << e.what() << endl;
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	this->ring.assign(RING_SIZE, 0);
+	this->fileName = fileName;
+	this->level = level;
+	this->binary = binary;
+	this->startTime = nowNs();
+	this->stopping = false;
+
+	if (binary){
+		this->file.write(BINARY_MAGIC, 8);
+		this->bytesWritten = 8;
+	}
+
+	this->writer = thread(&Logger::writerLoop, this);
+}
+
+void Logger::close(){
+	if (!this->writer.joinable()){
+		return;
+	}
+	this->stopping = true;
+	this->wakeUp.notify_one();
+	this->writer.join();
+	this->file.close();
+}
+
+bool Logger::is_open() const{
+	return this->writer.joinable();
+}
+
+uint64_t Logger::sync(){
+	if (!this->writer.joinable()){
+		return this->bytesWritten;
+	}
+	this->syncRequested.store(true, memory_order_release);
+	while (this->syncRequested.load(memory_order_acquire)){
+		this->wakeUp.notify_one();
+		this_thread::yield();
+	}
+	return this->syncedBytes;
+}
+
+void Logger::resumeAt(uint64_t bytes){
+	assert(!this->binary);
+	string fileName = this->fileName;
+	LogLevel level = this->level;
+	this->close();
+	if (truncate(fileName.c_str(), bytes) != 0){
+		cerr << "Log " << fileName << " cannot be continued at byte " << bytes << "!" << endl;
+		terminate();
+	}
+	this->open(fileName, level, false, true);
+}
+
+void Logger::setLevel(LogLevel level){
+	this->level = level;
+}
+
+void Logger::push(LogLevel level, const char *payload, int length){
+
+	if (!this->writer.joinable()){
+		return;
+	}
+
+	char header[HEADER_SIZE];
+	uint32_t len = length;
+	uint8_t lvl = level;
+	uint64_t time = nowNs() - this->startTime;
+	memcpy(header, &len, 4);
+	memcpy(header + 4, &lvl, 1);
+	memcpy(header + 5, &time, 8);
+
+	uint64_t total = HEADER_SIZE + length;
+	uint64_t pos = this->writePos.load(memory_order_relaxed);
+
+	// Wait for the writer thread if the ring is full. It never drops records. 
+	while (pos + total - this->readPos.load(memory_order_acquire) > RING_SIZE){
+		this->wakeUp.notify_one();
+		this_thread::yield();
+	}
+
+	for (int part = 0; part < 2; part++){
+		const char *src = (part == 0) ? header : payload;
+		int n = (part == 0) ? HEADER_SIZE : length;
+		int offset = pos & (RING_SIZE - 1);
+		int first = min(n, RING_SIZE - offset);
+		memcpy(&this->ring[offset], src, first);
+		memcpy(&this->ring[0], src + first, n - first);
+		pos = pos + n;
+	}
+
+	this->writePos.store(pos, memory_order_release);
+}
+
+// Copy n bytes starting at ring position pos, handling wrap-around
+void Logger::copyOut(uint64_t pos, char *dst, int n){
+	int offset = pos & (RING_SIZE - 1);
+	int first = min(n, RING_SIZE - offset);
+	memcpy(dst, &this->ring[offset], first);
+	memcpy(dst + first, &this->ring[0], n - first);
+}
+
+void Logger::writeRecord(uint8_t level, uint64_t time, const char *payload, int length){
+	char header[HEADER_SIZE];
+	uint32_t len = length;
+	memcpy(header, &len, 4);
+	memcpy(header + 4, &level, 1);
+	memcpy(header + 5, &time, 8);
+	this->file.write(header, HEADER_SIZE);
+	this->file.write(payload, length);
+	this->bytesWritten = this->bytesWritten + HEADER_SIZE + length;
+}
+
+// Move every complete record from the ring to the file
+void Logger::drain(string &record, string &converted){
+
+	uint64_t pos = this->readPos.load(memory_order_relaxed);
+	uint64_t end = this->writePos.load(memory_order_acquire);
+
+	if (pos == end){
+		return;
+	}
+
+	static const vector<string> noDictionary;
+	ostringstream text;
+	while (pos < end){
+		char header[HEADER_SIZE];
+		this->copyOut(pos, header, HEADER_SIZE);
+		uint32_t len;
+		uint8_t level;
+		uint64_t time;
+		memcpy(&len, header, 4);
+		memcpy(&level, header + 4, 1);
+		memcpy(&time, header + 5, 8);
+
+		record.resize(len);
+		this->copyOut(pos + HEADER_SIZE, &record[0], len);
+
+		if (this->binary){
+			// Replace literal addresses by dictionary ids, defining new ids on first use
+			converted.clear();
+			int field = 0;
+			while (field < len){
+				char tag = record[field];
+				int size = 1 + 8;
+				if (tag == 's'){
+					uint16_t n;
+					memcpy(&n, &record[field + 1], 2);
+					size = 1 + 2 + n;
+				}
+
+				if (tag == 'p'){
+					const char *literal;
+					memcpy(&literal, &record[field + 1], 8);
+					auto found = this->dictionary.find(literal);
+					uint32_t id;
+					if (found == this->dictionary.end()){
+						id = this->dictionary.size();
+						this->dictionary[literal] = id;
+						this->writeRecord(DICTIONARY_RECORD, time, literal, strlen(literal));
+					}
+					else{
+						id = found->second;
+					}
+					converted.push_back('r');
+					converted.append(reinterpret_cast<const char *>(&id), 4);
+				}
+				else{
+					converted.append(record, field, size);
+				}
+				field = field + size;
+			}
+			this->writeRecord(level, time, converted.data(), converted.size());
+		}
+		else{
+			formatPayload(record.data(), len, text, noDictionary);
+			text << '\n';
+		}
+		pos = pos + HEADER_SIZE + len;
+	}
+
+	if (!this->binary){
+		string out = text.str();
+		this->file.write(out.data(), out.size());
+		this->bytesWritten = this->bytesWritten + out.size();
+	}
+
+	this->readPos.store(pos, memory_order_release);
+}
+
+void Logger::writerLoop(){
+
+	string record;
+	string converted;
+
+	while (!this->stopping){
+		{
+			unique_lock<mutex> guard(this->wakeLock);
+			this->wakeUp.wait_for(guard, chrono::milliseconds(5));
+		}
+		bool syncing = this->syncRequested.load(memory_order_acquire);
+		this->drain(record, converted);
+		if (syncing){
+			this->file.flush();
+			this->syncedBytes = this->bytesWritten;
+			this->syncRequested.store(false, memory_order_release);
+		}
+	}
+
+	this->drain(record, converted);
+	this->file.flush();
+}
+
+void Logger::formatPayload(const char *payload, int length, ostream &out, const vector<string> &dictionary){
+
+	int pos = 0;
+	while (pos < length){
+		char tag = payload[pos++];
+		if (tag == 'd'){
+			double value;
+			memcpy(&value, payload + pos, 8);
+			out << value;
+			pos = pos + 8;
+		}
+		else if (tag == 'i'){
+			int64_t value;
+			memcpy(&value, payload + pos, 8);
+			out << value;
+			pos = pos + 8;
+		}
+		else if (tag == 's'){
+			uint16_t n;
+			memcpy(&n, payload + pos, 2);
+			out.write(payload + pos + 2, n);
+			pos = pos + 2 + n;
+		}
+		else if (tag == 'p'){
+			const char *literal;
+			memcpy(&literal, payload + pos, 8);
+			out << literal;
+			pos = pos + 8;
+		}
+		else if (tag == 'r'){
+			uint32_t id;
+			memcpy(&id, payload + pos, 4);
+			out << (id < dictionary.size() ? dictionary[id] : "<unknown literal>");
+			pos = pos + 4;
+		}
+		else {
+			out << "<corrupt record>";
+			return;
+		}
+	}
+}
+
+
+void LogLine::put(char tag, const void *value, int n){
+	if (this->length + 1 + n > MAX_PAYLOAD){
+		return; // Truncate overlong lines
+	}
+	this->buffer[this->length] = tag;
+	memcpy(this->buffer + this->length + 1, value, n);
+	this->length = this->length + 1 + n;
+}
+
+LogLine &LogLine::operator<<(double value){
+	this->put('d', &value, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(int value){
+	int64_t v = value;
+	this->put('i', &v, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(long value){
+	int64_t v = value;
+	this->put('i', &v, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(unsigned long value){
+	int64_t v = value;
+	this->put('i', &v, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(unsigned int value){
+	int64_t v = value;
+	this->put('i', &v, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(const char *value){
+	this->put('p', &value, 8);
+	return *this;
+}
+
+LogLine &LogLine::operator<<(const string &value){
+	int room = MAX_PAYLOAD - this->length - 3;
+	if (room < 0){
+		return *this; // Truncate overlong lines
+	}
+	uint16_t n = min<size_t>(value.size(), room);
+	this->buffer[this->length] = 's';
+	memcpy(this->buffer + this->length + 1, &n, 2);
+	memcpy(this->buffer + this->length + 3, value.data(), n);
+	this->length = this->length + 3 + n;
+	return *this;
+}
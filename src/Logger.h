@@ -0,0 +1,157 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Asynchronous, leveled logger. 
+
+A log statement encodes its arguments as typed binary fields (no formatting, no I/O) and pushes the record into a lock-free 
+single-producer/single-consumer ring buffer. A background thread drains the buffer and either formats the records as text or writes 
+them to a compact binary file, which tools/logdecode.cpp turns back into text. const char * arguments must be string literals: only 
+their address is recorded, and the binary file stores each literal once in a dictionary record. Pass anything else as a string. 
+
+Statements above LOG_COMPILED_LEVEL are compiled out. Statements above the runtime level cost one comparison. Use it as 
+
+	LOG_TO(this->logOut, LOG_DEBUG) << "[TAG] Something happened at " << time;
+
+A logger has one producing thread at a time, i.e., the thread that owns the Server (or Estimator) writing to it. 
+*/
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include<string>
+#include<vector>
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<iostream>
+#include<fstream>
+#include<cstdint>
+#include<cstring>
+#include<unordered_map>
+#include "config.h"
+using namespace std;
+
+enum LogLevel { LOG_OFF = 0, LOG_SUMMARY = 1, LOG_INFO = 2, LOG_DEBUG = 3 };
+
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL LOG_DEBUG
+#endif
+
+#define LOG_TO(logger, level) if ((level) > LOG_COMPILED_LEVEL || !(logger).isEnabled(level)) ; else LogLine((logger), (level))
+
+class Logger{
+
+private:
+	static const int RING_SIZE = 1 << 20; // Bytes. Must be a power of 2.
+
+	vector<char> ring;
+	atomic<uint64_t> writePos{ 0 }; // Only the producer moves it
+	atomic<uint64_t> readPos{ 0 }; // Only the writer thread moves it
+
+	LogLevel level = LOG_DEBUG;
+	bool binary = false;
+	string fileName;
+	ofstream file;
+	uint64_t bytesWritten = 0; // Size of the file, counted by the writer thread
+	atomic<bool> syncRequested{ false }; // Set by sync, cleared by the writer thread once the file holds every record pushed before
+	uint64_t syncedBytes = 0;
+	thread writer;
+	atomic<bool> stopping{ false };
+	mutex wakeLock;
+	condition_variable wakeUp;
+
+	void writerLoop();
+	uint64_t startTime = 0; // When the logger was opened, in steady-clock nanoseconds
+	unordered_map<const char *, uint32_t> dictionary; // Literals already written to the binary file, with their ids
+	void drain(string &, string &);
+	void copyOut(uint64_t, char *, int);
+	void writeRecord(uint8_t, uint64_t, const char *, int);
+
+public:
+	static const char *BINARY_MAGIC; // First 8 bytes of a binary log
+	static const uint8_t DICTIONARY_RECORD = 255; // Level of a record defining the next literal id. Its payload is the literal. 
+
+	Logger() = default;
+	~Logger();
+
+	void open(const string, LogLevel, bool, bool = false); // File name, runtime level, binary records or text, append to a text log (resume)
+	void close(); // Drain everything and stop the writer thread
+	bool is_open() const;
+	uint64_t sync(); // Write out every record pushed so far. Returns the size of the file, e.g., for a checkpoint.
+	void resumeAt(uint64_t); // Text logs: drop what was written after this many bytes and continue behind it
+	void setLevel(LogLevel);
+	bool isEnabled(LogLevel level) const { return level <= this->level; }
+
+	void push(LogLevel, const char *, int); // Push one encoded record (called by LogLine)
+
+	/*
+	Record layout shared with the decoder: u32 payload length, u8 level, u64 nanoseconds since the logger opened, payload. 
+	Payload fields are a tag followed by a value: 'd' double, 'i' int64, 's' u16 length and bytes, 'p' address of a literal 
+	(in memory only) and 'r' u32 literal id (in binary files). 
+	*/
+	static const int HEADER_SIZE = 4 + 1 + 8;
+	static void formatPayload(const char *, int, ostream &, const vector<string> &); // Turn an encoded payload into text, given the literal dictionary
+
+};
+
+/*
+One log statement. Arguments are appended to a fixed buffer as (type tag, value). The record is pushed when the statement ends. 
+*/
+class LogLine{
+
+private:
+	static const int MAX_PAYLOAD = 1024;
+
+	Logger &logger;
+	LogLevel level;
+	char buffer[MAX_PAYLOAD];
+	int length = 0;
+
+	void put(char, const void *, int);
+
+public:
+	LogLine(Logger &logger, LogLevel level) : logger(logger), level(level) {}
+	~LogLine(){ this->logger.push(this->level, this->buffer, this->length); }
+
+	LogLine &operator<<(double);
+	LogLine &operator<<(int);
+	LogLine &operator<<(long);
+	LogLine &operator<<(unsigned int);
+	LogLine &operator<<(unsigned long);
+	LogLine &operator<<(const char *);
+	LogLine &operator<<(const string &);
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,239 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "MinuteMetrics.h"
+#include<iostream>
+#include<cstring>
+#include<cstddef>
+#include<cmath>
+#include<charconv>
+#include<exception>
+#include<unistd.h>
+
+// Columns of MinuteMetrics, in file order
+struct MetricsField{
+	const char *name;
+	MetricsType type;
+	size_t offset;
+};
+
+static const MetricsField fields[] = {
+	{ "minute", METRICS_INT32, offsetof(MinuteMetrics, minute) },
+	{ "observed_rho", METRICS_FLOAT64, offsetof(MinuteMetrics, observedRho) },
+	{ "estimated_rho", METRICS_FLOAT64, offsetof(MinuteMetrics, estimatedRho) },
+	{ "freq", METRICS_FLOAT64, offsetof(MinuteMetrics, freq) },
+	{ "idle_state", METRICS_INT32, offsetof(MinuteMetrics, idleState) },
+	{ "cores", METRICS_INT32, offsetof(MinuteMetrics, cores) },
+	{ "jobs", METRICS_INT32, offsetof(MinuteMetrics, noOfJobs) },
+	{ "mean_response_ms", METRICS_FLOAT64, offsetof(MinuteMetrics, ER) },
+	{ "energy_mj", METRICS_FLOAT64, offsetof(MinuteMetrics, energy) },
+	{ "busy_ms", METRICS_FLOAT64, offsetof(MinuteMetrics, busy) },
+	{ "idle_ms", METRICS_FLOAT64, offsetof(MinuteMetrics, idle) },
+	{ "compute_ms", METRICS_FLOAT64, offsetof(MinuteMetrics, computeMs) },
+};
+static const int noOfFields = sizeof(fields) / sizeof(fields[0]);
+
+static uint32_t typeWidth(MetricsType type){
+	return type == METRICS_INT32 ? sizeof(int32_t) : sizeof(double);
+}
+
+MetricsWriter::MetricsWriter(const string fileName, const uint64_t resumeAt){
+
+	this->fileName = fileName;
+	if (resumeAt > 0){
+		// Drop what was written after the checkpoint, then continue behind it
+		if (truncate(fileName.c_str(), resumeAt) != 0){
+			cerr << "Metrics file " << fileName << " cannot be continued at byte " << resumeAt << "!" << endl;
+			terminate();
+		}
+		this->out.open(fileName, ios::out | ios::binary | ios::app);
+	}
+	else {
+		this->out.open(fileName, ios::out | ios::binary | ios::trunc);
+	}
+	if (!this->out.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+	this->bytesWritten = resumeAt;
+
+	if (resumeAt == 0){
+		MetricsHeader header = {};
+		memcpy(header.magic, METRICS_MAGIC, sizeof(METRICS_MAGIC));
+		header.version = METRICS_VERSION;
+		header.noOfColumns = noOfFields;
+		this->out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		for (auto &field : fields){
+			MetricsColumn column = {};
+			strncpy(column.name, field.name, sizeof(column.name) - 1);
+			column.type = field.type;
+			column.width = typeWidth(field.type);
+			this->out.write(reinterpret_cast<const char *>(&column), sizeof(column));
+		}
+		this->bytesWritten = sizeof(MetricsHeader) + noOfFields * sizeof(MetricsColumn);
+	}
+
+	this->columns.resize(noOfFields);
+	for (int i = 0; i < noOfFields; i++){
+		this->columns.at(i).resize(METRICS_BLOCK * typeWidth(fields[i].type));
+	}
+}
+
+MetricsWriter::~MetricsWriter(){
+	this->flush();
+}
+
+void MetricsWriter::append(const MinuteMetrics &record){
+	const char *bytes = reinterpret_cast<const char *>(&record);
+	for (int i = 0; i < noOfFields; i++){
+		uint32_t width = typeWidth(fields[i].type);
+		memcpy(this->columns[i].data() + this->noOfBuffered * width, bytes + fields[i].offset, width);
+	}
+	if (++this->noOfBuffered == METRICS_BLOCK){
+		this->flush();
+	}
+}
+
+void MetricsWriter::flush(){
+	if (this->noOfBuffered == 0){
+		return;
+	}
+
+	uint32_t blockHeader[2] = { this->noOfBuffered, 0 };
+	this->out.write(reinterpret_cast<const char *>(blockHeader), sizeof(blockHeader));
+	this->bytesWritten = this->bytesWritten + sizeof(blockHeader);
+	for (int i = 0; i < noOfFields; i++){
+		uint32_t bytes = this->noOfBuffered * typeWidth(fields[i].type);
+		this->out.write(this->columns[i].data(), bytes);
+		this->bytesWritten = this->bytesWritten + bytes;
+	}
+	this->out.flush();
+	if (!this->out){
+		cerr << "Metrics file " << this->fileName << " cannot be written!" << endl;
+		terminate();
+	}
+	this->noOfBuffered = 0;
+}
+
+uint64_t MetricsWriter::getBytesWritten() const{
+	return this->bytesWritten;
+}
+
+
+MetricsReader::MetricsReader(const string fileName){
+
+	this->fileName = fileName;
+	this->in.open(fileName, ios::in | ios::binary);
+	if (!this->in.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	MetricsHeader header;
+	this->in.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if (this->in.gcount() != sizeof(header) || memcmp(header.magic, METRICS_MAGIC, sizeof(METRICS_MAGIC)) != 0 || header.version != METRICS_VERSION){
+		cerr << "File " << fileName << " is not a SleepScale metrics file of this version!" << endl;
+		terminate();
+	}
+
+	this->columns.resize(header.noOfColumns);
+	this->in.read(reinterpret_cast<char *>(this->columns.data()), header.noOfColumns * sizeof(MetricsColumn));
+	for (auto &column : this->columns){
+		if (!this->in || column.width != typeWidth(column.type)){
+			cerr << "Metrics file " << fileName << " has a malformed column description!" << endl;
+			terminate();
+		}
+		column.name[sizeof(column.name) - 1] = '\0';
+	}
+	this->block.resize(this->columns.size());
+}
+
+const vector<MetricsColumn> &MetricsReader::getColumns() const{
+	return this->columns;
+}
+
+bool MetricsReader::nextRow(vector<double> &row){
+
+	if (this->next == this->blockSize){
+		uint32_t blockHeader[2];
+		if (!this->in.read(reinterpret_cast<char *>(blockHeader), sizeof(blockHeader))){
+			return false;
+		}
+		this->blockSize = blockHeader[0];
+		this->next = 0;
+		for (int i = 0; i < this->columns.size(); i++){
+			this->block[i].resize(this->blockSize * this->columns[i].width);
+			this->in.read(this->block[i].data(), this->block[i].size());
+		}
+		if (!this->in){
+			cerr << "Metrics file " << this->fileName << " ends inside a block!" << endl;
+			terminate();
+		}
+	}
+
+	row.resize(this->columns.size());
+	for (int i = 0; i < this->columns.size(); i++){
+		const char *value = this->block[i].data() + this->next * this->columns[i].width;
+		if (this->columns[i].type == METRICS_INT32){
+			int32_t integer;
+			memcpy(&integer, value, sizeof(integer));
+			row[i] = integer;
+		}
+		else {
+			memcpy(&row[i], value, sizeof(double));
+		}
+	}
+	this->next++;
+	return true;
+}
+
+void exportMetricsCsv(const string fileName, ostream &out){
+
+	MetricsReader reader(fileName);
+	auto &columns = reader.getColumns();
+	for (int i = 0; i < columns.size(); i++){
+		out << (i > 0 ? "," : "") << columns[i].name;
+	}
+	out << "\n";
+
+	vector<double> row;
+	char buffer[32];
+	while (reader.nextRow(row)){
+		for (int i = 0; i < row.size(); i++){
+			out << (i > 0 ? "," : "");
+			if (!isnan(row[i])){
+				out.write(buffer, to_chars(buffer, buffer + sizeof(buffer), row[i]).ptr - buffer); // Shortest form that reads back the same. Empty if missing.
+			}
+		}
+		out << "\n";
+	}
+}
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Per-minute metrics of a run, as fixed-width binary columns instead of log lines to scrape. Server::stepMinute fills one MinuteMetrics per 
+minute and hands it to a MetricsWriter (metrics key). The file is columnar, in native byte order: 
+
+	MetricsHeader                       magic, version, number of columns
+	MetricsColumn x noOfColumns         name, type and width of each column
+	blocks                              uint32 number of records, uint32 0, then each column of the block as one array
+
+The writer buffers METRICS_BLOCK records per column and writes them as one block, so a record costs a few stores. A reader needs only 
+the column descriptors, so columns can be added without breaking old readers. tools/metricsexport.cpp turns a file into CSV. 
+
+Minutes in which the server did not run (before the job log is full, or between updates) have no jobs and zero run columns; minutes 
+without a decision have compute_ms 0. Missing values are NaN: the mean response time during the warm-up, whose response times are not 
+summed, and the observed utilization of the last record, written at the end of the trace. 
+*/
+
+#ifndef MINUTEMETRICS_H
+#define MINUTEMETRICS_H
+
+#include<string>
+#include<vector>
+#include<fstream>
+#include<cstdint>
+#include<cmath>
+using namespace std;
+
+#define METRICS_MAGIC "SSMET01"
+#define METRICS_VERSION 1
+#define METRICS_BLOCK 4096 // Records per block
+
+struct MinuteMetrics{
+	int32_t minute = 0;
+	int32_t idleState = 0; // IdleState of the chosen policy (PowerState.h)
+	int32_t cores = 0; // Active cores of the chosen policy
+	int32_t noOfJobs = 0; // Jobs the server ran this minute
+	double observedRho = 0; // Utilization read from the trace for this minute
+	double estimatedRho = 0; // Estimate the policy of this minute was picked for
+	double freq = 0; // Chosen policy, in force from the next minute on
+	double ER = NAN; // Mean response time of the jobs run, ms
+	double energy = 0; // Of the jobs run, mJ
+	double busy = 0; // Busy core time, ms
+	double idle = 0; // Idle core time, ms
+	double computeMs = 0; // Time doSleepScale took
+};
+
+struct MetricsHeader{
+	char magic[8]; // METRICS_MAGIC
+	uint32_t version;
+	uint32_t noOfColumns;
+};
+
+enum MetricsType : uint32_t { METRICS_INT32, METRICS_FLOAT64 };
+
+struct MetricsColumn{
+	char name[24];
+	MetricsType type;
+	uint32_t width; // Bytes per value
+};
+
+class MetricsWriter{
+
+private:
+	string fileName;
+	ofstream out;
+	vector<vector<char>> columns; // Buffered values of the block, one array per column
+	uint32_t noOfBuffered = 0;
+	uint64_t bytesWritten = 0;
+
+public:
+	MetricsWriter(const string, const uint64_t = 0); // File, and the size to continue a file at (resume), or 0 to start a new one
+	~MetricsWriter();
+	MetricsWriter(const MetricsWriter &) = delete;
+	MetricsWriter &operator=(const MetricsWriter &) = delete;
+
+	void append(const MinuteMetrics &);
+	void flush(); // Write the buffered records as a block
+	uint64_t getBytesWritten() const; // File size after the last flush
+};
+
+class MetricsReader{
+
+private:
+	string fileName;
+	ifstream in;
+	vector<MetricsColumn> columns;
+	vector<vector<char>> block; // Current block, one array per column
+	uint32_t blockSize = 0;
+	uint32_t next = 0; // Next record of the block
+
+public:
+	MetricsReader(const string); // Terminates if the file is not a metrics file
+
+	const vector<MetricsColumn> &getColumns() const;
+	bool nextRow(vector<double> &); // Values of the next record, one per column. False at the end.
+};
+
+void exportMetricsCsv(const string, ostream &); // Metrics file, CSV output with a header line
+
+#endif
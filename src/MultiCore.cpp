@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "MultiCore.h"
+#include "PowerModel.h"
+#include "Checkpoint.h"
+
+MultiCoreQueue::MultiCoreQueue(int cores, CoreQueue queue){
+	assert(cores >= 1);
+	this->queue = queue;
+	this->coreFree.assign(cores, 0);
+}
+
+int MultiCoreQueue::getCores() const{
+	return this->coreFree.size();
+}
+
+void MultiCoreQueue::setCores(int cores){
+
+	assert(cores >= 1);
+	int oldCores = this->coreFree.size();
+	if (cores == oldCores){
+		return;
+	}
+
+	// Sorted ascending is a valid min-heap. Parking drops the cores that run out of work last.
+	sort(this->coreFree.begin(), this->coreFree.end());
+	this->coreFree.resize(cores, this->lastDepart);
+	this->nextCore = 0;
+}
+
+void MultiCoreQueue::replaceTop(double free){
+
+	double *heap = this->coreFree.data();
+	int size = this->coreFree.size();
+	int parent = 0;
+	while (true){
+		int child = 2 * parent + 1;
+		if (child >= size){
+			break;
+		}
+		if (child + 1 < size && heap[child + 1] < heap[child]){
+			child = child + 1;
+		}
+		if (heap[child] >= free){
+			break;
+		}
+		heap[parent] = heap[child];
+		parent = child;
+	}
+	heap[parent] = free;
+}
+
+void CoreResidency::add(const MultiCoreTotals &run, int active, int cores){
+	double length = run.end - run.start;
+	this->length = this->length + length;
+	this->busy = this->busy + run.busy;
+	this->idle = this->idle + active * length - run.busy;
+	this->parked = this->parked + (cores - active) * length;
+	this->allIdle = this->allIdle + run.allIdle;
+	this->packageSleep = this->packageSleep + run.packageSleep;
+}
+
+double multiCoreEnergy(const PowerModel &model, const PowerState &policy, double freq, int cores, const MultiCoreTotals &run){
+
+	double length = run.end - run.start;
+	double coreIdle = policy.cores * length - run.busy;
+
+	double energy = run.busy * model.coreActivePower(freq) + coreIdle * model.coreIdlePower(policy.idleState, freq) + 
+		(cores - policy.cores) * length * model.parkedPower();
+	energy = energy + (length - run.allIdle) * model.platformActivePower() + (run.allIdle - run.packageSleep) * model.platformIdlePower() + 
+		run.packageSleep * model.packageIdlePower();
+	energy = energy + run.wakeUps * policy.wakeEnergy + run.packageWakeUps * model.packageWakeUpEnergy();
+	return energy;
+}
+
+void MultiCoreQueue::save(CheckpointWriter &out) const{
+	out.put(this->queue);
+	out.put(this->coreFree);
+	out.put(this->lastDepart);
+	out.put(this->nextCore);
+}
+
+void MultiCoreQueue::restore(CheckpointReader &in){
+	in.get(this->queue);
+	in.get(this->coreFree);
+	in.get(this->lastDepart);
+	in.get(this->nextCore);
+}
@@ -0,0 +1,208 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Multi-core server (cores > 1). The cores share a package and serve one stream of jobs, either from one FCFS queue (central, M/G/k) or 
+from a queue per core that jobs are sent to round-robin (per_core). A policy picks how many cores are active, their frequency and the 
+C-state they idle in; the other cores are parked. 
+
+The queue keeps the time each active core runs out of work. Central dispatch keeps them in a binary min-heap, so a job goes to the core 
+that frees up first in O(log k). As in simQueue, departures are known at dispatch, so the state carries over from one run to the next. 
+A job that finds its core idle pays the core's wake-up latency. The package sleeps only while every active core is idle, which is when a 
+job arrives after the latest departure on any core; if the idle state lets the package enter its C-state (PowerModel.h), that job waits 
+for the package's exit latency too. 
+
+Energy is split into the cores (busy, idle in the policy's C-state, parked) and the package (active while any core is busy, idle, or in 
+its C-state), plus the transition energy of every core and package wake-up. Over many runs the core times add up exactly; when the 
+number of active cores changes, a core that is parked still finishes the jobs it was given. 
+*/
+
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include "PowerState.h"
+#include "QueueKernel.h"
+#include "LatencyHistogram.h"
+#include<vector>
+#include<algorithm>
+using namespace std;
+
+class CheckpointWriter;
+class CheckpointReader;
+
+enum CoreQueue { CORE_QUEUE_CENTRAL, CORE_QUEUE_PER_CORE };
+
+/*
+Sums of a run on the active cores. The run covers [start, end), from the latest departure before it to the latest departure after it. 
+*/
+struct MultiCoreTotals{
+	double ER = 0; // Sum of response times
+	double busy = 0; // Core time running jobs or waking up, summed over the cores
+	double allIdle = 0; // Time every active core was idle
+	double packageSleep = 0; // Part of allIdle the package spent in its C-state
+	double wakeUps = 0; // Jobs that found their core idle
+	double packageWakeUps = 0; // Jobs that found the package in its C-state
+	double target = INFINITY; // Response time above which a job adds to overTarget. Only read.
+	double overTarget = 0; // Jobs with a longer response time than target
+	double start = 0;
+	double end = 0;
+};
+
+/*
+Where the cores of the server spent their time, summed over runs, for the report. 
+*/
+struct CoreResidency{
+	double length = 0; // Length of the runs
+	double busy = 0; // Core time, summed over the cores of the server
+	double idle = 0;
+	double parked = 0;
+	double allIdle = 0; // Package time
+	double packageSleep = 0;
+
+	void add(const MultiCoreTotals &, int, int); // Run, active cores, cores of the server
+};
+
+class MultiCoreQueue{
+
+private:
+	CoreQueue queue;
+	vector<double> coreFree; // When each active core runs out of work. A min-heap for the central queue.
+	double lastDepart = 0; // Latest departure on any core
+	int nextCore = 0; // Next core of the round-robin dispatch
+
+	void replaceTop(double); // Give the first core of the heap a new free time and restore the heap
+
+public:
+	MultiCoreQueue() = default;
+	MultiCoreQueue(int, CoreQueue); // Active cores, dispatch. The server starts empty at time 0.
+
+	int getCores() const;
+	void setCores(int); // Park the cores that run out of work last, or unpark cores idle since the latest departure
+
+	void save(CheckpointWriter &) const; // Checkpoint.h
+	void restore(CheckpointReader &);
+
+	/*
+	Run jobs[first, last) at frequency freq and add to the sums in totals. packageWakeUp is the package's exit latency if the package 
+	enters its C-state when every core idles, or negative if it does not. Unless latencies is null, the response times go to it too. 
+	*/
+	template<class Jobs>
+	void run(const Jobs &jobs, int first, int last, double freq, double wakeUp, double packageWakeUp, MultiCoreTotals &totals, 
+		LatencyHistogram *latencies = nullptr);
+};
+
+double multiCoreEnergy(const PowerModel &, const PowerState &, double, int, const MultiCoreTotals &); // Policy, its frequency, cores of the server. mJ
+
+template<class Jobs>
+void MultiCoreQueue::run(const Jobs &jobs, int first, int last, double freq, double wakeUp, double packageWakeUp, MultiCoreTotals &totals, 
+	LatencyHistogram *latencies){
+
+	double *coreFree = this->coreFree.data();
+	int cores = this->coreFree.size();
+	bool central = this->queue == CORE_QUEUE_CENTRAL;
+	bool packageSleeps = packageWakeUp >= 0;
+
+	// Locals, so the sums stay in registers
+	double ER = 0;
+	double busy = 0;
+	double allIdle = 0;
+	double packageSleep = 0;
+	double wakeUps = 0;
+	double packageWakeUps = 0;
+	double overTarget = 0;
+	double target = totals.target;
+	double lastDepart = this->lastDepart;
+	int core = this->nextCore;
+
+	totals.start = lastDepart;
+
+	for (int job = first; job < last; job++){
+		double arrival = jobs.arrival(job);
+		double work = jobs.service(job) / freq;
+		if (central){
+			core = 0; // The core that frees up first
+		}
+
+		double depart;
+		if (arrival > lastDepart){
+			// Every core is idle
+			double latency = wakeUp;
+			allIdle = allIdle + arrival - lastDepart;
+			if (packageSleeps){
+				packageSleep = packageSleep + arrival - lastDepart;
+				latency = latency + packageWakeUp;
+				packageWakeUps = packageWakeUps + 1;
+			}
+			depart = arrival + work + latency;
+			busy = busy + work + latency;
+			wakeUps = wakeUps + 1;
+		}
+		else if (arrival > coreFree[core]){
+			depart = arrival + work + wakeUp;
+			busy = busy + work + wakeUp;
+			wakeUps = wakeUps + 1;
+		}
+		else {
+			depart = coreFree[core] + work;
+			busy = busy + work;
+		}
+		ER = ER + depart - arrival;
+		overTarget = depart - arrival > target ? overTarget + 1 : overTarget;
+		if (latencies != nullptr){
+			latencies->record(depart - arrival);
+		}
+		lastDepart = max(lastDepart, depart);
+
+		if (central){
+			this->replaceTop(depart);
+		}
+		else {
+			coreFree[core] = depart;
+			core = core + 1 == cores ? 0 : core + 1;
+		}
+	}
+
+	this->lastDepart = lastDepart;
+	this->nextCore = core;
+
+	totals.ER = totals.ER + ER;
+	totals.busy = totals.busy + busy;
+	totals.allIdle = totals.allIdle + allIdle;
+	totals.packageSleep = totals.packageSleep + packageSleep;
+	totals.wakeUps = totals.wakeUps + wakeUps;
+	totals.packageWakeUps = totals.packageWakeUps + packageWakeUps;
+	totals.overTarget = totals.overTarget + overTarget;
+	totals.end = lastDepart;
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "ParameterSweep.h"
+#include "Server.h"
+#include "ThreadPool.h"
+#include<chrono>
+#include<map>
+
+ParameterSweep::ParameterSweep(const Config &base, const vector<string> &specs, int noOfWorkers){
+
+	this->base = base;
+	vector<vector<string>> values;
+
+	for (auto &spec : specs){
+		size_t equal = spec.find('=');
+		if (equal == string::npos){
+			cerr << "Expected key=value1,value2,... but got " << spec << endl;
+			terminate();
+		}
+		string key = spec.substr(0, equal);
+		if (key == "trace" || key == "service_cdf" || key == "arrival_cdf" || key == "output" || key == "metrics" || key == "seed" || key == "cores"){
+			cerr << "Cannot sweep " << key << ": all points share the workload. Use --batch instead." << endl;
+			terminate();
+		}
+
+		vector<string> list;
+		string value;
+		istringstream listIn(spec.substr(equal + 1));
+		while (getline(listIn, value, ',')){
+			if (!value.empty()){
+				list.push_back(value);
+			}
+		}
+		if (list.empty()){
+			cerr << "No values to sweep for " << key << endl;
+			terminate();
+		}
+
+		this->sweptKeys.push_back(key);
+		values.push_back(list);
+	}
+
+	if (this->sweptKeys.empty()){
+		cerr << "Nothing to sweep!" << endl;
+		terminate();
+	}
+
+	int noOfPoints = 1;
+	for (auto &list : values){
+		noOfPoints = noOfPoints * list.size();
+	}
+
+	map<string, int> leaderOf;
+	for (int p = 0; p < noOfPoints; p++){
+		Config point = base;
+		string suffix;
+
+		// The last key changes fastest
+		int rest = p;
+		for (int k = this->sweptKeys.size() - 1; k >= 0; k--){
+			const string &value = values.at(k).at(rest % values.at(k).size());
+			rest = rest / values.at(k).size();
+			point.set(this->sweptKeys.at(k), value);
+			suffix = "." + this->sweptKeys.at(k) + "=" + value + suffix;
+		}
+		point.output = base.output + suffix;
+		if (!base.metrics.empty()){
+			point.metrics = base.metrics + suffix;
+		}
+		point.sweepThreads = 1; // Points run in parallel instead
+		point.check();
+
+		this->points.push_back(point);
+
+		int leader = p;
+#if !defined(GEN_MM1) && !defined(SLEEPSCALE_SEARCH) && !defined(SLEEPSCALE_INCREMENTAL)
+		string key = this->signature(point);
+		if (leaderOf.count(key) == 0){
+			leaderOf[key] = p;
+		}
+		leader = leaderOf.at(key);
+#endif
+		this->leaders.push_back(leader);
+	}
+
+	if (noOfWorkers <= 0){
+		noOfWorkers = max(1, static_cast<int>(thread::hardware_concurrency()));
+	}
+	this->noOfWorkers = min(noOfWorkers, noOfPoints);
+	this->results.resize(noOfPoints);
+}
+
+string ParameterSweep::signature(const Config &config) const{
+	string key;
+	for (auto name : { "platform", "cores", "core_queue", "no_freq", "run_as", "core_act_max_pwr", "plat_idle_pwr", "plat_act_max_pwr", "wakeup_c0i", "wakeup_c1", "wakeup_c3", "wakeup_c6" }){
+		key = key + config.get(name) + "|";
+	}
+	// The sweep also counts the response times above slowdown * ser_time, but only for a percentile target
+	key = key + config.get("slo_percentile") + "|";
+	if (config.sloPercentile > 0){
+		key = key + config.get("slowdown") + "|" + config.get("ser_time") + "|";
+	}
+	return key;
+}
+
+int ParameterSweep::getSize() const{
+	return this->points.size();
+}
+
+const Config &ParameterSweep::getPoint(int p) const{
+	return this->points.at(p);
+}
+
+const ExperimentResult &ParameterSweep::getResult(int p) const{
+	return this->results.at(p);
+}
+
+void ParameterSweep::run(){
+
+	int noOfPoints = this->points.size();
+	cout << "Sweeping " << noOfPoints << " points on " << this->noOfWorkers << " threads" << endl;
+
+	auto serDist = loadCdfTable(this->base.serviceCdf);
+	auto arrDist = loadCdfTable(this->base.arrivalCdf);
+
+	vector<shared_ptr<Server>> servers;
+	vector<int> leaderPoints;
+	vector<int> followerPoints;
+	for (int p = 0; p < noOfPoints; p++){
+		servers.push_back(make_shared<Server>(this->points.at(p)));
+		servers.back()->start(this->base.trace);
+		if (this->leaders.at(p) == p){
+			leaderPoints.push_back(p);
+		}
+		else {
+			followerPoints.push_back(p);
+		}
+	}
+	for (auto p : followerPoints){
+		servers.at(p)->sweepLeader = servers.at(this->leaders.at(p)).get();
+	}
+
+	ThreadPool pool(this->noOfWorkers);
+	vector<double> newRho(noOfPoints);
+	vector<double> seconds(noOfPoints, 0);
+	vector<Job> newJobs;
+
+	auto step = [&](int p){
+		auto start = chrono::steady_clock::now();
+		newRho.at(p) = servers.at(p)->stepMinute();
+		seconds.at(p) = seconds.at(p) + chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	};
+
+	while (servers.at(0)->isRunning()){
+
+		// Leaders first, so that their sweeps of this minute are done when the followers look for them
+		pool.parallelFor(leaderPoints.size(), [&](int i){ step(leaderPoints.at(i)); });
+		pool.parallelFor(followerPoints.size(), [&](int i){ step(followerPoints.at(i)); });
+
+		// Every point reads the same trace
+		for (int p = 1; p < noOfPoints; p++){
+			assert(newRho.at(p) == newRho.at(0) && servers.at(p)->isRunning() == servers.at(0)->isRunning());
+		}
+
+		if (newRho.at(0) >= 0){
+			newJobs.clear();
+			drawWorkloadCDF(*serDist, *arrDist, servers.at(0)->minute, newRho.at(0) * this->base.cores, servers.at(0)->config.seed, newJobs);
+			pool.parallelFor(noOfPoints, [&](int p){ servers.at(p)->addWorkload(newJobs); });
+		}
+	}
+
+	for (int p = 0; p < noOfPoints; p++){
+		servers.at(p)->finish();
+		this->results.at(p) = collectResult(*servers.at(p), seconds.at(p));
+		this->noOfSweeps = this->noOfSweeps + servers.at(p)->noOfSleepScale;
+		this->noOfReusedSweeps = this->noOfReusedSweeps + servers.at(p)->reusedSweeps;
+	}
+
+	cout << this->noOfReusedSweeps << " of " << this->noOfSweeps << " SleepScale steps reused the policy simulations of another point" << endl;
+}
+
+void ParameterSweep::writeResults(const string fileName) const{
+
+	ofstream out;
+	openOutputFile(fileName, out);
+
+	out << "point\t";
+	for (auto &key : this->sweptKeys){
+		out << key << "\t";
+	}
+	writeResultHeader(out);
+
+	for (int p = 0; p < this->points.size(); p++){
+		out << p << "\t";
+		for (auto &key : this->sweptKeys){
+			out << this->points.at(p).get(key) << "\t";
+		}
+		writeResult(out, this->results.at(p));
+	}
+	out.close();
+}
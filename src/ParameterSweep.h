@@ -0,0 +1,81 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Parameter sweep. Runs one trace and workload under every combination of the listed parameter values, e.g. 
+
+	SleepScale --sweep slowdown=2,3,5,8 update_interval=1,5
+
+All points advance in lockstep, one minute at a time. The jobs of each minute are drawn once and handed to every point, and the CDFs and 
+the trace are read once per point only. Points whose policies and power constants are identical (they differ in, e.g., slowdown, 
+update_interval, over-provisioning, warm-up or baseline) also see the same job log, so when they estimate the same utilization in the 
+same minute the policy simulations of one of them, the leader, are reused by the others and only the choice of policy is redone. 
+That is most of the cost of a run, so such a sweep costs little more than a single run. Reuse is off with GEN_MM1 (every server draws 
+its own job stream), with SLEEPSCALE_SEARCH and with SLEEPSCALE_INCREMENTAL (the simulated policies depend on the slowdown).
+With slo_percentile set, reuse is narrower: the simulations also count the jobs over slowdown * ser_time, so only points that agree 
+on the percentile, the slowdown and the service time share them. tools/sweepcheck.cpp checks that every point matches its solo run. 
+*/
+
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include "Config.h"
+#include "BatchRunner.h"
+#include<string>
+#include<vector>
+using namespace std;
+
+class ParameterSweep{
+
+private:
+	Config base;
+	vector<string> sweptKeys;
+	vector<Config> points;
+	vector<int> leaders; // Index of the point whose sweeps point i reuses, i itself for a leader
+	vector<ExperimentResult> results;
+	int noOfWorkers;
+	int noOfSweeps = 0;
+	int noOfReusedSweeps = 0;
+
+	string signature(const Config &) const; // Points with equal signatures simulate identical policies
+
+public:
+	ParameterSweep(const Config &, const vector<string> &, int); // Base configuration, "key=v1,v2,..." per swept key, number of threads (0 uses all hardware threads)
+	void run();
+	void writeResults(const string) const; // Tab separated table, one row per point
+	int getSize() const;
+	const Config &getPoint(int) const; // Configuration of a point
+	const ExperimentResult &getResult(int) const; // Result of a point, after run
+};
+
+#endif
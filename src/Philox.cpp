@@ -0,0 +1,155 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Philox.h"
+#include<cstring>
+#include<algorithm>
+
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+
+static const int LANES = 8; // Blocks computed side by side in Philox4x32::blocks
+
+void Philox4x32::block(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]){
+
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+
+	for (int round = 0; round < ROUNDS; round++){
+		uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+		uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+		uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		uint32_t n1 = (uint32_t)p1;
+		uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		uint32_t n3 = (uint32_t)p0;
+		c0 = n0; c1 = n1; c2 = n2; c3 = n3;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+void Philox4x32::blocks(uint64_t first, int noOfBlocks, uint32_t c2In, uint32_t c3In, const uint32_t key[2], uint32_t *out){
+
+	int done = 0;
+
+	for (; done + LANES <= noOfBlocks; done += LANES){
+		uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+		for (int lane = 0; lane < LANES; lane++){
+			uint64_t counter = first + done + lane;
+			c0[lane] = (uint32_t)counter;
+			c1[lane] = (uint32_t)(counter >> 32);
+			c2[lane] = c2In;
+			c3[lane] = c3In;
+		}
+
+		uint32_t k0 = key[0], k1 = key[1];
+		for (int round = 0; round < ROUNDS; round++){
+			for (int lane = 0; lane < LANES; lane++){
+				uint64_t p0 = (uint64_t)PHILOX_M0 * c0[lane];
+				uint64_t p1 = (uint64_t)PHILOX_M1 * c2[lane];
+				uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[lane] ^ k0;
+				uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[lane] ^ k1;
+				c0[lane] = n0;
+				c1[lane] = (uint32_t)p1;
+				c2[lane] = n2;
+				c3[lane] = (uint32_t)p0;
+			}
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+
+		for (int lane = 0; lane < LANES; lane++){
+			uint32_t *o = out + 4 * (done + lane);
+			o[0] = c0[lane]; o[1] = c1[lane]; o[2] = c2[lane]; o[3] = c3[lane];
+		}
+	}
+
+	// Remainder one block at a time
+	for (; done < noOfBlocks; done++){
+		uint64_t counter = first + done;
+		uint32_t c[4] = { (uint32_t)counter, (uint32_t)(counter >> 32), c2In, c3In };
+		block(c, key, out + 4 * done);
+	}
+}
+
+// 53 random bits from two words
+static inline double toUniform(uint32_t high, uint32_t low){
+	return ((((uint64_t)high << 32) | low) >> 11) * 0x1.0p-53;
+}
+
+RandomStream::RandomStream(uint64_t seed, int minute, RandomStreamId stream){
+	this->key[0] = (uint32_t)seed;
+	this->key[1] = (uint32_t)(seed >> 32);
+	this->minute = (uint32_t)minute;
+	this->stream = (uint32_t)stream;
+}
+
+void RandomStream::refill(){
+
+	uint32_t words[4 * BUFFER_BLOCKS];
+	Philox4x32::blocks(this->nextBlock, BUFFER_BLOCKS, this->minute, this->stream, this->key, words);
+	this->nextBlock += BUFFER_BLOCKS;
+
+	for (int i = 0; i < 2 * BUFFER_BLOCKS; i++){
+		this->buffer[i] = toUniform(words[2 * i], words[2 * i + 1]);
+	}
+	this->bufferPos = 0;
+}
+
+double RandomStream::uniform(){
+	if (this->bufferPos == 2 * BUFFER_BLOCKS){
+		this->refill();
+	}
+	return this->buffer[this->bufferPos++];
+}
+
+void RandomStream::uniform(double *out, int n){
+	while (n > 0){
+		if (this->bufferPos == 2 * BUFFER_BLOCKS){
+			this->refill();
+		}
+		int copied = std::min(n, 2 * BUFFER_BLOCKS - this->bufferPos);
+		memcpy(out, this->buffer + this->bufferPos, copied * sizeof(double));
+		this->bufferPos += copied;
+		out += copied;
+		n -= copied;
+	}
+}
+
+RandomStream::result_type RandomStream::operator()(){
+	// The top 32 of the 53 bits
+	return (result_type)(this->uniform() * 0x1.0p32);
+}
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Counter-based random numbers for workload generation. Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 
+SC'11) turns a 128-bit counter and a 64-bit key into four 32-bit random words. Nothing is carried from one block to the next, so any 
+block can be computed on its own. 
+
+A RandomStream is keyed by the experiment seed and counts blocks within (minute, stream). The jobs of a minute therefore depend only on 
+the seed, the minute and the utilization: they can be regenerated independently (e.g., in parallel, or after a restart), and two runs 
+with the same seed produce the same workload. Service times and inter-arrival times come from different streams, so changing how many 
+jobs one of them needs does not shift the other. 
+*/
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include<cstdint>
+#include<limits>
+using namespace std;
+
+enum RandomStreamId{ STREAM_SERVICE, STREAM_ARRIVAL, STREAM_MM1_SERVICE, STREAM_MM1_ARRIVAL };
+
+class Philox4x32{
+
+public:
+	static const int ROUNDS = 10;
+
+	// counter = {c0, c1, c2, c3}, key = {k0, k1}. Writes four words to out.
+	static void block(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+	// Blocks first, first + 1, ... for the given c2, c3 and key, i.e., 4 * noOfBlocks words. Lanes are independent so the loop vectorizes.
+	static void blocks(uint64_t first, int noOfBlocks, uint32_t c2, uint32_t c3, const uint32_t key[2], uint32_t *out);
+};
+
+class RandomStream{
+
+private:
+	static const int BUFFER_BLOCKS = 128;
+
+	uint32_t key[2];
+	uint32_t minute;
+	uint32_t stream;
+	uint64_t nextBlock = 0; // First block not generated yet
+	double buffer[2 * BUFFER_BLOCKS]; // Uniforms not handed out yet, two per block
+	int bufferPos = 2 * BUFFER_BLOCKS;
+
+	void refill();
+
+public:
+	RandomStream(uint64_t, int, RandomStreamId); // Seed, minute, stream
+
+	double uniform(); // Next uniform in [0, 1) with 53 random bits
+	void uniform(double *, int); // The next n uniforms, same values as n calls of uniform()
+
+	// Lets the stream drive the <random> distributions as well
+	typedef uint32_t result_type;
+	static constexpr result_type min(){ return 0; }
+	static constexpr result_type max(){ return numeric_limits<uint32_t>::max(); }
+	result_type operator()();
+};
+
+#endif
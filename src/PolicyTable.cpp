@@ -0,0 +1,193 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "PolicyTable.h"
+#include<iostream>
+#include<fstream>
+#include<cstring>
+#include<cmath>
+#include<algorithm>
+#include<exception>
+
+static_assert(sizeof(PolicyTableHeader) == 160, "The policy table header is part of the file format");
+static_assert(sizeof(PolicyTableEntry) == 56, "Policy table entries are part of the file format");
+
+PolicyTable::PolicyTable(const string fileName){
+
+	this->fileName = fileName;
+
+	// Tables are a few kB, so they are read rather than mapped. Refreshed entries stay in memory.
+	ifstream in(fileName, ios::binary | ios::ate);
+	if (!in.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+	size_t length = in.tellg();
+	in.seekg(0);
+
+	if (length < sizeof(PolicyTableHeader)){
+		cerr << "File " << fileName << " is not a policy table!" << endl;
+		terminate();
+	}
+	in.read(reinterpret_cast<char *>(&this->header), sizeof(PolicyTableHeader));
+
+	const PolicyTableHeader &h = this->header;
+	bool valid = memcmp(h.magic, POLICY_TABLE_MAGIC, sizeof(POLICY_TABLE_MAGIC)) == 0;
+	valid = valid && h.version == POLICY_TABLE_VERSION && h.headerSize == sizeof(PolicyTableHeader) && h.noOfEntries > 0;
+	valid = valid && h.entryOffset % POLICY_TABLE_ALIGN == 0 && h.entryOffset >= sizeof(PolicyTableHeader);
+	valid = valid && h.entryOffset + h.noOfEntries * sizeof(PolicyTableEntry) <= length;
+	valid = valid && h.rhoStep > 0;
+
+	if (!valid){
+		cerr << "File " << fileName << " is not a valid policy table (version " << POLICY_TABLE_VERSION << ")! Recompile it with tools/policycompile." << endl;
+		terminate();
+	}
+
+	this->entries.resize(h.noOfEntries);
+	in.seekg(h.entryOffset);
+	in.read(reinterpret_cast<char *>(this->entries.data()), h.noOfEntries * sizeof(PolicyTableEntry));
+	if (!in.good()){
+		cerr << "Reading " << fileName << " failed!" << endl;
+		terminate();
+	}
+}
+
+const PolicyTableHeader &PolicyTable::getHeader() const{
+	return this->header;
+}
+
+int PolicyTable::getSize() const{
+	return this->entries.size();
+}
+
+const PolicyTableEntry &PolicyTable::getEntry(int index) const{
+	return this->entries.at(index);
+}
+
+void PolicyTable::setEntry(int index, const PolicyTableEntry &entry){
+	this->entries.at(index) = entry;
+}
+
+int PolicyTable::nearest(double rho) const{
+	double position = round((rho - this->header.rhoMin) / this->header.rhoStep);
+	return static_cast<int>(min(max(position, 0.0), static_cast<double>(this->entries.size() - 1)));
+}
+
+PolicyTableEntry PolicyTable::lookup(double rho) const{
+
+	int last = this->entries.size() - 1;
+	double position = (rho - this->header.rhoMin) / this->header.rhoStep;
+	position = min(max(position, 0.0), static_cast<double>(last));
+
+	int lower = min(static_cast<int>(position), max(last - 1, 0));
+	int upper = min(lower + 1, last);
+	double weight = position - lower;
+
+	const PolicyTableEntry &low = this->entries.at(lower);
+	const PolicyTableEntry &high = this->entries.at(upper);
+
+	PolicyTableEntry entry = weight > 0 ? high : low;
+	entry.rho = rho;
+	if (weight > 0 && strncmp(low.idle, high.idle, sizeof(low.idle)) != 0){
+		return entry; // Frequencies of different idle states do not mix. The higher entry's policy meets the target here.
+	}
+	entry.freq = low.freq + weight * (high.freq - low.freq);
+	entry.EP = low.EP + weight * (high.EP - low.EP);
+	entry.ER = low.ER + weight * (high.ER - low.ER);
+	entry.feasible = low.feasible && high.feasible;
+	return entry;
+}
+
+bool isPolicyTable(const string fileName){
+	char magic[sizeof(POLICY_TABLE_MAGIC)] = {};
+	ifstream in(fileName, ios::binary);
+	in.read(magic, sizeof(magic));
+	return in.gcount() == sizeof(magic) && memcmp(magic, POLICY_TABLE_MAGIC, sizeof(magic)) == 0;
+}
+
+uint64_t policyConfigHash(const Config &config){
+
+	// FNV-1a over the values as they are logged
+	uint64_t hash = 14695981039346656037ULL;
+	for (auto name : { "slowdown", "ser_time", "no_freq", "run_as", "core_act_max_pwr", "plat_idle_pwr", "plat_act_max_pwr", "wakeup_c0i", 
+		"wakeup_c1", "wakeup_c3", "wakeup_c6" }){
+		string field = string(name) + "=" + config.get(name) + "|";
+		for (unsigned char c : field){
+			hash = (hash ^ c) * 1099511628211ULL;
+		}
+	}
+
+	// So is a percentile target, only when set, so that tables compiled for the mean keep their hash
+	if (config.sloPercentile > 0){
+		string field = "slo_percentile=" + config.get("slo_percentile") + "|";
+		for (unsigned char c : field){
+			hash = (hash ^ c) * 1099511628211ULL;
+		}
+	}
+
+	// A platform file is hashed by its contents, so tables without one keep their hash
+	if (!config.platform.empty()){
+		ifstream in(config.platform, ios::binary);
+		string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		for (unsigned char c : "platform=" + contents + "|"){
+			hash = (hash ^ c) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+void writePolicyTable(const string fileName, const PolicyTableHeader &fields, const vector<PolicyTableEntry> &entries){
+
+	PolicyTableHeader header = fields;
+	memcpy(header.magic, POLICY_TABLE_MAGIC, sizeof(POLICY_TABLE_MAGIC));
+	header.version = POLICY_TABLE_VERSION;
+	header.headerSize = sizeof(PolicyTableHeader);
+	header.noOfEntries = entries.size();
+	header.entryOffset = POLICY_TABLE_ALIGN * ((sizeof(PolicyTableHeader) + POLICY_TABLE_ALIGN - 1) / POLICY_TABLE_ALIGN);
+
+	ofstream out(fileName, ios::binary);
+	if (!out.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	vector<char> padding(POLICY_TABLE_ALIGN, 0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(padding.data(), header.entryOffset - sizeof(header));
+	out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(PolicyTableEntry));
+
+	if (!out.good()){
+		cerr << "Writing " << fileName << " failed!" << endl;
+		terminate();
+	}
+}
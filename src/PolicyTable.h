@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Policy table. The best policy for a fixed pair of CDFs is mostly a function of the predicted utilization, so tools/policycompile.cpp sweeps 
+a grid of utilizations once, simulating every policy on a job log drawn at each of them, and writes the winners to a binary file. With 
+policy_table set, doSleepScale looks the estimate up in it instead of simulating (see Server::tablePolicy). Layout, in native byte order: 
+
+	PolicyTableHeader (160 bytes)   magic, version, grid, and the configuration and workload the table was compiled for
+	entries                         noOfEntries PolicyTableEntry at entryOffset, at utilizations rhoMin + i * rhoStep
+
+Entries start on a 64-byte boundary. A table only holds for the parameters that decide the pick (policyConfigHash); a server refuses one 
+compiled for other parameters. 
+*/
+
+#ifndef POLICYTABLE_H
+#define POLICYTABLE_H
+
+#include "Config.h"
+#include<string>
+#include<vector>
+#include<cstdint>
+using namespace std;
+
+struct PolicyTableHeader{
+	char magic[8]; // POLICY_TABLE_MAGIC
+	uint32_t version;
+	uint32_t headerSize; // sizeof(PolicyTableHeader)
+	uint64_t noOfEntries;
+	uint64_t entryOffset; // Bytes from the start of the file
+	double rhoMin; // Utilization of the first entry
+	double rhoStep; // Utilization between consecutive entries
+	uint64_t configHash; // policyConfigHash of the configuration it was compiled for
+	uint64_t seed; // Seed of the compiled job logs
+	uint32_t jobsPerEntry; // Jobs simulated at each utilization
+	uint32_t noFreq;
+	double slowdown;
+	double serTime;
+	char runAs[24];
+	char serviceCdf[24]; // Base names of the CDFs
+	char arrivalCdf[24];
+};
+
+struct PolicyTableEntry{
+	double rho; // Utilization
+	double freq; // Best policy
+	double EP; // Its power and mean response time
+	double ER;
+	char idle[16]; // Low-power state name
+	uint32_t feasible; // 0 if no policy met the response time target. freq and idle are then those of the fastest policy.
+	uint32_t refreshed; // Set when a server re-derived the entry from its job log
+};
+
+#define POLICY_TABLE_MAGIC "SSPOL01"
+#define POLICY_TABLE_VERSION 1
+#define POLICY_TABLE_ALIGN 64
+
+class PolicyTable{
+
+private:
+	string fileName;
+	PolicyTableHeader header;
+	vector<PolicyTableEntry> entries;
+
+public:
+	PolicyTable(const string); // Read a policy table. Terminates if the file is not one.
+
+	const PolicyTableHeader &getHeader() const;
+	int getSize() const;
+	const PolicyTableEntry &getEntry(int) const;
+	void setEntry(int, const PolicyTableEntry &);
+	int nearest(double) const; // Entry closest to a utilization
+	
+	/*
+	Interpolate between the two entries around a utilization, clamped to the grid. If both entries have the same idle state, freq, EP 
+	and ER are interpolated linearly. Otherwise the entry of the higher utilization is returned unchanged: its policy meets the target 
+	there, while a frequency between the two would belong to neither idle state. 
+	*/
+	PolicyTableEntry lookup(double) const;
+};
+
+bool isPolicyTable(const string); // Does the file start with the policy table magic?
+uint64_t policyConfigHash(const Config &); // Hash of the parameters that decide the best policy
+void writePolicyTable(const string, const PolicyTableHeader &, const vector<PolicyTableEntry> &); // Output, header fields to keep, entries
+
+#endif
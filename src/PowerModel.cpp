@@ -0,0 +1,354 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "PowerModel.h"
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<algorithm>
+#include<exception>
+
+static const char *cstateNames[NO_OF_C_STATES] = { "C0i", "C1", "C3", "C6" };
+
+PowerModel::PowerModel(const Config &config){
+
+	if (config.platform.empty()){
+		// The built-in platform
+		this->name = "built-in";
+		double freqIncrement = static_cast<double>(1) / config.noFreq;
+		for (int i = config.noFreq; i >= 1; i--){
+			this->pstateFreq.push_back(freqIncrement * i);
+		}
+		this->coreActMaxPwr = config.coreActMaxPwr;
+		this->platActMaxPwr = config.platActMaxPwr;
+		this->platIdlePwr = config.platIdlePwr;
+		this->cstates[IDLE_C0I] = { true, 75, 1, 2, 0, config.wakeUpC0i, 0 };
+		this->cstates[IDLE_C1] = { true, 47, 1, 1, 0, config.wakeUpC1, 0 };
+		this->cstates[IDLE_C3] = { true, 22, 0, 0, 0, config.wakeUpC3, 0 };
+		this->cstates[IDLE_C6] = { true, 15, 0, 0, 0, config.wakeUpC6, 0 };
+	}
+	else {
+		this->loadFile(config.platform);
+	}
+
+	this->baselineAlwaysOn = config.baseline.compare("NO_PWR_CNTRL") == 0;
+	this->baselineState = config.baseline.compare("R2H_C3") == 0 ? IDLE_C3 : IDLE_C6;
+	if (!this->baselineAlwaysOn && !this->hasIdleState(this->baselineState)){
+		cerr << "Platform " << this->name << " has no " << cstateNames[this->baselineState] << " for the baseline " << config.baseline << endl;
+		terminate();
+	}
+}
+
+static void badLine(const string &fileName, int lineNo, const string &line, const string &what){
+	cerr << fileName << ":" << lineNo << ": " << what << " in \"" << line << "\"" << endl;
+	terminate();
+}
+
+void PowerModel::loadFile(const string fileName){
+
+	ifstream platformIn(fileName);
+	if (!platformIn.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+
+	this->name = fileName.substr(fileName.find_last_of('/') + 1);
+	this->coreActMaxPwr = -1;
+	this->platActMaxPwr = -1;
+	this->platIdlePwr = -1;
+	int uniform = 0;
+	vector<pair<double, double>> pstates; // MHz, V
+
+	string line;
+	int lineNo = 0;
+	while (getline(platformIn, line)){
+		lineNo++;
+		string record = line.substr(0, line.find('#'));
+		if (record.find_first_not_of(" \t\r") == string::npos){
+			continue;
+		}
+		size_t equal = record.find('=');
+		if (equal == string::npos){
+			badLine(fileName, lineNo, line, "expected key = value");
+		}
+
+		// Trim blanks around the key
+		string key = record.substr(0, equal);
+		key.erase(0, key.find_first_not_of(" \t"));
+		key.erase(key.find_last_not_of(" \t\r") + 1);
+		istringstream value(record.substr(equal + 1));
+		string rest;
+
+		if (key == "name"){
+			getline(value >> ws, this->name);
+			this->name.erase(this->name.find_last_not_of(" \t\r") + 1);
+			continue;
+		}
+		else if (key == "core_act_max_pwr"){
+			value >> this->coreActMaxPwr;
+		}
+		else if (key == "plat_act_max_pwr"){
+			value >> this->platActMaxPwr;
+		}
+		else if (key == "plat_idle_pwr"){
+			value >> this->platIdlePwr;
+		}
+		else if (key == "uniform_pstates"){
+			value >> uniform;
+			if (value && uniform < 1){
+				badLine(fileName, lineNo, line, "need at least one P-state");
+			}
+		}
+		else if (key == "pstate"){
+			double mhz, volt;
+			value >> mhz >> volt;
+			if (value && (mhz <= 0 || volt <= 0)){
+				badLine(fileName, lineNo, line, "frequency and voltage must be positive");
+			}
+			pstates.push_back(make_pair(mhz, volt));
+		}
+		else if (key == "cstate"){
+			string state;
+			CStateModel model;
+			value >> state >> model.power >> model.freqExponent >> model.voltageExponent >> model.entryLatency >> model.exitLatency >> model.transitionEnergy;
+			int c = find(cstateNames, cstateNames + NO_OF_C_STATES, state) - cstateNames;
+			if (c == NO_OF_C_STATES){
+				badLine(fileName, lineNo, line, "unknown C-state (C0i, C1, C3 or C6)");
+			}
+			if (this->cstates[c].defined){
+				badLine(fileName, lineNo, line, "C-state defined twice");
+			}
+			if (value && (model.power < 0 || model.freqExponent < 0 || model.voltageExponent < 0 || model.entryLatency < 0 || 
+				model.exitLatency < 0 || model.transitionEnergy < 0)){
+				badLine(fileName, lineNo, line, "power, exponents, latencies and energy must not be negative");
+			}
+			model.defined = true;
+			this->cstates[c] = model;
+		}
+		else if (key == "parked_pwr"){
+			value >> this->parkedPwr;
+			if (value && this->parkedPwr < 0){
+				badLine(fileName, lineNo, line, "power must not be negative");
+			}
+		}
+		else if (key == "package"){
+			if (this->package){
+				badLine(fileName, lineNo, line, "package C-state defined twice");
+			}
+			value >> this->packageIdlePwr >> this->packageExitLatency >> this->packageTransitionEnergy;
+			if (value && (this->packageIdlePwr < 0 || this->packageExitLatency < 0 || this->packageTransitionEnergy < 0)){
+				badLine(fileName, lineNo, line, "power, latency and energy must not be negative");
+			}
+			this->package = true;
+		}
+		else {
+			badLine(fileName, lineNo, line, "unknown key " + key);
+		}
+
+		if (!value || (value >> rest)){
+			badLine(fileName, lineNo, line, "malformed value");
+		}
+	}
+
+	if (this->coreActMaxPwr < 0 || this->platActMaxPwr < 0 || this->platIdlePwr < 0){
+		cerr << "Platform " << fileName << " needs core_act_max_pwr, plat_act_max_pwr and plat_idle_pwr" << endl;
+		terminate();
+	}
+	if ((uniform > 0) == !pstates.empty()){
+		cerr << "Platform " << fileName << " needs either uniform_pstates or pstate lines" << endl;
+		terminate();
+	}
+
+	if (uniform > 0){
+		// As the built-in platform
+		double freqIncrement = static_cast<double>(1) / uniform;
+		for (int i = uniform; i >= 1; i--){
+			this->pstateFreq.push_back(freqIncrement * i);
+		}
+	}
+	else {
+		sort(pstates.begin(), pstates.end(), greater<pair<double, double>>());
+		for (int p = 0; p < pstates.size(); p++){
+			if (p > 0 && pstates.at(p).first == pstates.at(p - 1).first){
+				cerr << "Platform " << fileName << " lists " << pstates.at(p).first << " MHz twice" << endl;
+				terminate();
+			}
+			this->pstateFreq.push_back(pstates.at(p).first / pstates.front().first);
+			this->pstateVoltage.push_back(pstates.at(p).second / pstates.front().second);
+		}
+	}
+}
+
+const string &PowerModel::getName() const{
+	return this->name;
+}
+
+const vector<double> &PowerModel::getFrequencies() const{
+	return this->pstateFreq;
+}
+
+bool PowerModel::hasIdleState(IdleState state) const{
+	if (state == IDLE_DVFS_ONLY || state == IDLE_BASELINE){
+		return true;
+	}
+	return this->cstates[state].defined;
+}
+
+double PowerModel::voltage(double freq) const{
+
+	if (this->pstateVoltage.empty()){
+		return freq;
+	}
+
+	// P-states are in descending frequency. Below the lowest one the voltage stays at its floor.
+	int last = this->pstateFreq.size() - 1;
+	if (freq >= this->pstateFreq.front()){
+		return this->pstateVoltage.front();
+	}
+	if (freq <= this->pstateFreq.at(last)){
+		return this->pstateVoltage.at(last);
+	}
+	int p = 0;
+	while (this->pstateFreq.at(p + 1) > freq){
+		p++;
+	}
+	double weight = (this->pstateFreq.at(p) - freq) / (this->pstateFreq.at(p) - this->pstateFreq.at(p + 1));
+	return this->pstateVoltage.at(p) + weight * (this->pstateVoltage.at(p + 1) - this->pstateVoltage.at(p));
+}
+
+double PowerModel::activePower(double freq) const{
+	return this->coreActivePower(freq) + this->platActMaxPwr;
+}
+
+double PowerModel::idlePower(IdleState state, double freq) const{
+
+	if (state == IDLE_DVFS_ONLY){
+		return this->activePower(freq);
+	}
+	if (state == IDLE_BASELINE){
+		return this->baselineAlwaysOn ? this->activePower(freq) : this->idlePower(this->baselineState, freq);
+	}
+	return this->coreIdlePower(state, freq) + this->platIdlePwr;
+}
+
+double PowerModel::coreActivePower(double freq) const{
+	double v = this->voltage(freq);
+	return this->coreActMaxPwr * freq * v * v;
+}
+
+double PowerModel::coreIdlePower(IdleState state, double freq) const{
+
+	if (state == IDLE_DVFS_ONLY){
+		return this->coreActivePower(freq);
+	}
+	if (state == IDLE_BASELINE){
+		return this->baselineAlwaysOn ? this->coreActivePower(freq) : this->coreIdlePower(this->baselineState, freq);
+	}
+
+	const CStateModel &cstate = this->cstates[state];
+	double v = this->voltage(freq);
+	double power = cstate.power;
+	for (int k = 0; k < cstate.freqExponent; k++){
+		power = power * freq;
+	}
+	for (int k = 0; k < cstate.voltageExponent; k++){
+		power = power * v;
+	}
+	return power;
+}
+
+double PowerModel::parkedPower() const{
+
+	if (this->parkedPwr >= 0){
+		return this->parkedPwr;
+	}
+	for (int c = NO_OF_C_STATES - 1; c >= 0; c--){
+		if (this->cstates[c].defined){
+			return this->coreIdlePower(static_cast<IdleState>(c), this->pstateFreq.back());
+		}
+	}
+	return this->coreActivePower(this->pstateFreq.back()); // No C-state: idle at the lowest P-state
+}
+
+double PowerModel::platformActivePower() const{
+	return this->platActMaxPwr;
+}
+
+double PowerModel::platformIdlePower() const{
+	return this->platIdlePwr;
+}
+
+bool PowerModel::packageSleeps(IdleState state) const{
+
+	if (state == IDLE_BASELINE){
+		if (this->baselineAlwaysOn){
+			return false;
+		}
+		state = this->baselineState;
+	}
+	return this->package && (state == IDLE_C3 || state == IDLE_C6);
+}
+
+double PowerModel::packageIdlePower() const{
+	return this->packageIdlePwr;
+}
+
+double PowerModel::packageWakeUpLatency() const{
+	return this->packageExitLatency;
+}
+
+double PowerModel::packageWakeUpEnergy() const{
+	return this->packageTransitionEnergy;
+}
+
+double PowerModel::wakeUpLatency(IdleState state) const{
+
+	if (state == IDLE_DVFS_ONLY){
+		return WAKEUP_DVFS_ONLY;
+	}
+	if (state == IDLE_BASELINE){
+		return this->baselineAlwaysOn ? 0 : this->wakeUpLatency(this->baselineState);
+	}
+	return this->cstates[state].entryLatency + this->cstates[state].exitLatency;
+}
+
+double PowerModel::wakeUpEnergy(IdleState state) const{
+
+	if (state == IDLE_DVFS_ONLY){
+		return 0;
+	}
+	if (state == IDLE_BASELINE){
+		return this->baselineAlwaysOn ? 0 : this->wakeUpEnergy(this->baselineState);
+	}
+	return this->cstates[state].transitionEnergy;
+}
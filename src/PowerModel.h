@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Platform power model. Everything the policies need to know about the processor: its P-states (frequency and voltage), the active 
+power, and for every C-state the idle power, entry and exit latency and the energy of one round trip. Policies copy the numbers once 
+(PowerState.h); nothing here is looked up while simulating. 
+
+Without a platform file the model is the built-in one of const.h: no_freq equally spaced P-states with voltage proportional to the 
+frequency, and the power constants and wake-up latencies of the configuration. With platform set, it is read from a file of 
+"key = value" lines ('#' starts a comment): 
+
+	name = <text>
+	core_act_max_pwr = <W>      core power when active in the highest P-state
+	plat_act_max_pwr = <W>      rest of the platform when active
+	plat_idle_pwr = <W>         rest of the platform when idle
+	uniform_pstates = <N>       N equally spaced P-states, voltage proportional to frequency, or else one line per P-state: 
+	pstate = <MHz> <V>
+	cstate = <name> <W> <f exponent> <V exponent> <entry ms> <exit ms> <transition mJ>
+	package = <W> <exit ms> <transition mJ>     optional package C-state
+	parked_pwr = <W>            optional power of a core that is not used, e.g. power-gated
+
+A C-state named C0i, C1, C3 or C6 draws core power W * f^a * V^b plus plat_idle_pwr, with f and V relative to the highest P-state. 
+Active power is core_act_max_pwr * f * V^2 plus plat_act_max_pwr. A job that finds the core idle waits entry plus exit latency, the 
+worst case of a wake-up during entry, and the round trip costs the transition energy on top. ../platforms/default.platform is the 
+built-in model written out. 
+
+On a multi-core server (cores > 1, MultiCore.h) the core_ and cstate powers are per core and the plat_ powers per package. The package 
+C-state replaces plat_idle_pwr while every active core idles in C3 or C6; the job that ends it waits its exit latency on top of the 
+core's. Cores that are not used are parked: they draw parked_pwr, or the power of the deepest C-state without it. The built-in model 
+has no package C-state. 
+*/
+
+#ifndef POWERMODEL_H
+#define POWERMODEL_H
+
+#include "PowerState.h"
+#include "Config.h"
+#include<string>
+#include<vector>
+using namespace std;
+
+#define NO_OF_C_STATES 4 // C0i, C1, C3 and C6, numbered as in IdleState
+
+struct CStateModel{
+	bool defined = false; // Does the platform have this state?
+	double power = 0; // Core power at the highest P-state, W
+	int freqExponent = 0; // Core power scales with f^freqExponent * V^voltageExponent
+	int voltageExponent = 0;
+	double entryLatency = 0; // ms
+	double exitLatency = 0; // ms
+	double transitionEnergy = 0; // Energy of one entry and exit on top of the power above, mJ
+};
+
+class PowerModel{
+
+private:
+	string name;
+	vector<double> pstateFreq; // P-state frequencies relative to the highest, descending
+	vector<double> pstateVoltage; // Their voltages relative to that of the highest. Empty if proportional to the frequency.
+	double coreActMaxPwr;
+	double platActMaxPwr;
+	double platIdlePwr;
+	CStateModel cstates[NO_OF_C_STATES];
+	bool baselineAlwaysOn; // Baseline policy: always on, or race to halt into baselineState
+	IdleState baselineState;
+	bool package = false; // Is there a package C-state?
+	double packageIdlePwr = 0; // Platform power in it, W
+	double packageExitLatency = 0; // ms
+	double packageTransitionEnergy = 0; // mJ
+	double parkedPwr = -1; // Core power when parked, W. Negative for that of the deepest C-state.
+
+	void loadFile(const string);
+
+public:
+	PowerModel(const Config &); // Built-in model or the platform file of the configuration. Terminates on a malformed file.
+
+	const string &getName() const;
+	const vector<double> &getFrequencies() const; // Supported frequencies, descending, the first is 1
+	bool hasIdleState(IdleState) const;
+
+	double voltage(double) const; // Relative voltage at a frequency, interpolated between P-states
+	double activePower(double) const; // At a frequency, W
+	double idlePower(IdleState, double) const; // In an idle state at a frequency, W
+	double wakeUpLatency(IdleState) const; // ms
+	double wakeUpEnergy(IdleState) const; // mJ
+
+	// Multi-core server. activePower and idlePower are these plus the platform power.
+	double coreActivePower(double) const; // One core at a frequency, W
+	double coreIdlePower(IdleState, double) const; // One core in an idle state at a frequency, W
+	double parkedPower() const; // One core that is not used, W
+	double platformActivePower() const; // While any core is busy, W
+	double platformIdlePower() const; // While every core is idle, W
+	bool packageSleeps(IdleState) const; // Can the package enter its C-state while every core idles in this state?
+	double packageIdlePower() const; // W
+	double packageWakeUpLatency() const; // ms
+	double packageWakeUpEnergy() const; // mJ
+};
+
+#endif
@@ -31,66 +31,39 @@
 
 
 #include "PowerState.h"
-#include "const.h"
-#include "config.h"
+#include "PowerModel.h"
 
-PowerState::PowerState(const double freq, const string idle){
+static const char *idleStateNames[] = { "C0i", "C1", "C3", "C6", "DVFS_only", "Baseline" };
 
-	assert(freq > 0 && freq <= 1);
-
-	this->freq = freq;
-	this->idle = idle;
-	this->ER = 0;
-	this->EP = 0;
+IdleState parseIdleState(const string &idle){
+	for (int state = IDLE_C0I; state <= IDLE_BASELINE; state++){
+		if (idle.compare(idleStateNames[state]) == 0){
+			return static_cast<IdleState>(state);
+		}
+	}
+	cout << "Invalid power state!" << endl;
+	terminate();
+}
 
-	actPwr = CORE_ACT_MAX_PWR * freq * freq * freq + PLAT_ACT_MAX_PWR;
+string idleStateName(IdleState state){
+	return idleStateNames[state];
+}
 
-	if (idle.compare("C0i") == 0){
-		idlePwr = 75 * freq * freq * freq + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C0i;
-	}
-	else if (idle.compare("C1") == 0){
-		idlePwr = 47 * freq * freq + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C1; // ms
-	}
-	else if (idle.compare("C3") == 0){
-		idlePwr = 22 + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C3; // ms
-	}
-	else if (idle.compare("C6") == 0){
-		idlePwr = 15 + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C6; // ms
-	}
-	else if (idle.compare("DVFS_only") == 0){
-		idlePwr = actPwr;
-		wakeUp = WAKEUP_DVFS_ONLY;
-	} 
-	else if (idle.compare("Baseline") == 0){
-		// The baseline must have frequency = 1. 
-		assert(freq == 1);
-		
-		/* Always on */
-#ifdef BASE_USE_NO_PWR_CNTRL
-		idlePwr = actPwr;
-		wakeUp = 0;
-#endif
-		
-		/* Race to halt using C3 */
-#ifdef BASE_USE_R2H_C3
-		idlePwr = 22 + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C3; // ms
-#endif
+PowerState::PowerState(const double freq, const IdleState idleState, const PowerModel &model, const int cores){
 
-		/* Race to halt using C6 */
-#ifdef BASE_USE_R2H_C6
-		idlePwr = 15 + PLAT_IDLE_PWR;
-		wakeUp = WAKEUP_C6; // ms
-#endif
+	assert(freq > 0 && freq <= 1 && cores >= 1);
+	assert(idleState != IDLE_BASELINE || freq == 1); // The baseline must have frequency = 1. 
 
+	this->freq = freq;
+	this->idle = idleStateName(idleState);
+	this->cores = cores;
+	this->idleState = idleState;
+	this->ER = 0;
+	this->EP = 0;
+	this->overTarget = 0;
 
-	}
-	else {
-		cout << "Invalid power state!" << endl;
-		terminate();
-	}
+	this->actPwr = model.activePower(freq);
+	this->idlePwr = model.idlePower(idleState, freq);
+	this->wakeUp = model.wakeUpLatency(idleState);
+	this->wakeEnergy = model.wakeUpEnergy(idleState);
 }
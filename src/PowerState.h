@@ -31,7 +31,8 @@
 
 
 /*
-What's the server power under each low power state. 
+What's the server power under each low power state. The numbers come from the platform's power model (PowerModel.h) once, when the 
+policy is made. 
 */
 
 #ifndef POWERSTATE_H
@@ -41,20 +42,46 @@ What's the server power under each low power state.
 #include<assert.h>
 using namespace std;
 
+class PowerModel;
+
+// Idle states. Policies compare these instead of the names.
+enum IdleState{ IDLE_C0I, IDLE_C1, IDLE_C3, IDLE_C6, IDLE_DVFS_ONLY, IDLE_BASELINE };
+
+IdleState parseIdleState(const string &); // "C0i", "C1", "C3", "C6", "DVFS_only" or "Baseline". Terminates on anything else.
+string idleStateName(IdleState);
+
 class PowerState{
 
 public:
 	double actPwr; // Actual active power under a state
 	double idlePwr; // Actual idle power under a state
 	double wakeUp; // Wake-up latency
+	double wakeEnergy; // Energy of one trip into the idle state and back, on top of the power above
 	double ER; // To store response time
 	double EP; // To store best power
+	double overTarget; // Share of the response times above the target, if slo_percentile is set
 	double freq; // Frequency setting;
 	string idle; // Idle low power state setting;
+	IdleState idleState; // The same, as an enum
+	int cores; // Active cores of a multi-core server (MultiCore.h), 1 otherwise
 
 	PowerState() = default; // Should not be used.
-	PowerState(const double, const string);
+	PowerState(const double, const IdleState, const PowerModel &, const int = 1); // Frequency, idle state, platform, active cores
+
+	// Energy of a run with the given busy time, idle time and number of wake-ups
+	double energy(double opLength, double offLength, double wakeUps) const{
+		return opLength * this->actPwr + offLength * this->idlePwr + wakeUps * this->wakeEnergy;
+	}
 
 };
 
+/*
+Outcome of simulating a policy. simQueue writes into one of these instead of the shared PowerState, so policies can be simulated concurrently. 
+*/
+struct PolicyResult{
+	double ER = 0; // Mean response time
+	double EP = 0; // Mean power
+	double overTarget = 0; // Share of the response times above slowdown * ser_time, only counted if slo_percentile is set
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "Profiler.h"
+#include<cstring>
+#include<algorithm>
+#include<iomanip>
+#include<sstream>
+#include<unistd.h>
+#include<sys/ioctl.h>
+#include<sys/syscall.h>
+#include<linux/perf_event.h>
+
+static const char *phaseNames[NO_OF_PHASES] = { "estimate", "observe", "generate", "add_workload", "do_queue", "do_queue_base", "sleepscale", 
+	"simulate" };
+
+const char *phaseName(Phase phase){
+	return phaseNames[phase];
+}
+
+// One counter of the calling thread, in the group of leader, or a new group if leader is -1
+static int openCounter(uint64_t config, int leader){
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0); // This thread, any CPU
+}
+
+/*
+The counters run from the first call of a thread on, and a sample is their current values, so a call costs one read(2). A thread whose 
+counters cannot be opened does not try again. 
+*/
+bool readPerfCounters(PerfSample &sample){
+
+	thread_local int leader = -2; // -2 until opened, -1 if not available
+
+	if (leader == -2){
+		int fds[3];
+		fds[0] = openCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+		fds[1] = fds[0] < 0 ? -1 : openCounter(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+		fds[2] = fds[1] < 0 ? -1 : openCounter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+		leader = fds[0];
+		if (fds[2] < 0){
+			for (int fd : fds){
+				if (fd >= 0){
+					close(fd);
+				}
+			}
+			leader = -1;
+		}
+	}
+	if (leader < 0){
+		return false;
+	}
+
+	uint64_t values[4]; // Number of counters, then their values in the order they were opened
+	if (read(leader, values, sizeof(values)) != sizeof(values) || values[0] != 3){
+		return false;
+	}
+	sample.cycles = values[1];
+	sample.instructions = values[2];
+	sample.cacheMisses = values[3];
+	return true;
+}
+
+void PhaseProfile::add(Phase phase, double ms){
+	lock_guard<mutex> guard(this->lock);
+	PhaseStats &stats = this->phases[phase];
+	stats.calls++;
+	stats.totalMs = stats.totalMs + ms;
+	stats.times.record(ms);
+}
+
+void PhaseProfile::addCounters(const PerfSample &before, const PerfSample &after){
+	lock_guard<mutex> guard(this->lock);
+	this->counters.cycles = this->counters.cycles + after.cycles - before.cycles;
+	this->counters.instructions = this->counters.instructions + after.instructions - before.instructions;
+	this->counters.cacheMisses = this->counters.cacheMisses + after.cacheMisses - before.cacheMisses;
+	this->countedCalls++;
+}
+
+void PhaseProfile::counterFailure(){
+	lock_guard<mutex> guard(this->lock);
+	this->countersFailed = true;
+}
+
+double PhaseProfile::getTotal(Phase phase) const{
+	lock_guard<mutex> guard(this->lock);
+	return this->phases[phase].totalMs;
+}
+
+uint64_t PhaseProfile::getCalls(Phase phase) const{
+	lock_guard<mutex> guard(this->lock);
+	return this->phases[phase].calls;
+}
+
+void PhaseProfile::report(Logger &logOut) const{
+
+	lock_guard<mutex> guard(this->lock);
+
+	// Shares are of the phases run on the stepping thread, i.e. all but simulate
+	double total = 0;
+	for (int p = 0; p < NO_OF_PHASES; p++){
+		total = total + (p == PHASE_SIMULATE ? 0 : this->phases[p].totalMs);
+	}
+
+	LOG_TO(logOut, LOG_SUMMARY) << "";
+	LOG_TO(logOut, LOG_SUMMARY) << "==========================Phase Profile============================";
+	LOG_TO(logOut, LOG_SUMMARY) << "phase          calls       total ms   share   mean ms    p50 ms    p99 ms    max ms";
+	for (int p = 0; p < NO_OF_PHASES; p++){
+		const PhaseStats &stats = this->phases[p];
+		ostringstream line;
+		line << left << setw(14) << phaseNames[p] << right << setw(6) << stats.calls << fixed << setprecision(1) << setw(15) << stats.totalMs;
+		if (p == PHASE_SIMULATE || total == 0){
+			line << setw(8) << "-";
+		}
+		else {
+			line << setw(7) << 100 * stats.totalMs / total << "%";
+		}
+		line << setprecision(4) << setw(10) << (stats.calls > 0 ? stats.totalMs / stats.calls : 0) << setw(10) << stats.times.percentile(50) << 
+			setw(10) << stats.times.percentile(99) << setw(10) << stats.times.max();
+		LOG_TO(logOut, LOG_SUMMARY) << line.str();
+	}
+	LOG_TO(logOut, LOG_SUMMARY) << "simulate is summed over the sweep threads and overlaps sleepscale";
+
+#ifdef PROFILE_PERF_COUNTERS
+	if (this->countedCalls > 0){
+		LOG_TO(logOut, LOG_SUMMARY) << "simulate counters over " << this->countedCalls << " calls: " << this->counters.cycles << " cycles, " << 
+			this->counters.instructions << " instructions (IPC " << static_cast<double>(this->counters.instructions) / max<uint64_t>(this->counters.cycles, 1) << 
+			"), " << this->counters.cacheMisses << " cache misses";
+	}
+	if (this->countersFailed){
+		LOG_TO(logOut, LOG_SUMMARY) << "Hardware counters were not available for some or all simulate calls (perf_event_open)";
+	}
+#endif
+}
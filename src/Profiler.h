@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Phase profiling. With PROFILE_PHASES defined (config.h) each Server times the phases of a minute with scoped timers: 
+
+	estimate        Estimator::estimateRho
+	observe         Estimator::observeRho, including the wait for the trace or feed
+	generate        drawing the jobs of a minute from the CDFs
+	add_workload    queueing them and adding them to the job log
+	do_queue        doQueue, running the jobs under the chosen policy
+	do_queue_base   doQueueBaseline
+	sleepscale      doSleepScale, the policy decision
+	simulate        simQueue, simQueueBlock and simMultiCore, summed over the sweep threads, so it can exceed sleepscale
+
+Each phase keeps its number of calls, its total time and a LatencyHistogram of its call times. With PROFILE_PERF_COUNTERS also defined, 
+every simulate call reads the cycles, instructions and cache misses of its thread (perf_event_open). If the kernel refuses the counters 
+(perf_event_paranoid, containers) they are reported as unavailable and the timers still work. The breakdown goes to showReport and to 
+the results table of batches and sweeps. 
+
+Without PROFILE_PHASES, PROFILE_PHASE expands to nothing, so the timers cost nothing. 
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "config.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include<chrono>
+#include<mutex>
+#include<cstdint>
+#include<ostream>
+using namespace std;
+
+enum Phase{ PHASE_ESTIMATE, PHASE_OBSERVE, PHASE_GENERATE, PHASE_ADD_WORKLOAD, PHASE_DO_QUEUE, PHASE_DO_QUEUE_BASELINE, PHASE_SLEEPSCALE, 
+	PHASE_SIMULATE, NO_OF_PHASES };
+
+const char *phaseName(Phase);
+
+// Hardware counters of one thread
+struct PerfSample{
+	uint64_t cycles = 0;
+	uint64_t instructions = 0;
+	uint64_t cacheMisses = 0;
+};
+
+bool readPerfCounters(PerfSample &); // Counters of the calling thread, opened on its first call. False if they are not available.
+
+class PhaseProfile{
+
+private:
+	struct PhaseStats{
+		uint64_t calls = 0;
+		double totalMs = 0;
+		LatencyHistogram times; // ms
+	};
+
+	mutable mutex lock; // simulate is timed from the sweep threads
+	PhaseStats phases[NO_OF_PHASES];
+	PerfSample counters; // Summed over the simulate calls
+	uint64_t countedCalls = 0; // simulate calls that read the counters
+	bool countersFailed = false;
+
+public:
+	void add(Phase, double); // Phase, ms
+	void addCounters(const PerfSample &, const PerfSample &); // Before and after a call
+	void counterFailure();
+
+	double getTotal(Phase) const; // ms
+	uint64_t getCalls(Phase) const;
+	void report(Logger &) const; // Table of the phases at LOG_SUMMARY
+};
+
+class ScopedPhase{
+
+private:
+	PhaseProfile &profile;
+	Phase phase;
+	chrono::steady_clock::time_point start;
+#ifdef PROFILE_PERF_COUNTERS
+	PerfSample before;
+	bool counting = false;
+#endif
+
+public:
+	ScopedPhase(PhaseProfile &profile, Phase phase) : profile(profile), phase(phase){
+#ifdef PROFILE_PERF_COUNTERS
+		if (phase == PHASE_SIMULATE){
+			this->counting = readPerfCounters(this->before);
+		}
+#endif
+		this->start = chrono::steady_clock::now();
+	}
+
+	~ScopedPhase(){
+		this->profile.add(this->phase, chrono::duration<double, milli>(chrono::steady_clock::now() - this->start).count());
+#ifdef PROFILE_PERF_COUNTERS
+		PerfSample after;
+		if (this->counting && readPerfCounters(after)){
+			this->profile.addCounters(this->before, after);
+		}
+		else if (phase == PHASE_SIMULATE){
+			this->profile.counterFailure();
+		}
+#endif
+	}
+
+	ScopedPhase(const ScopedPhase &) = delete;
+	ScopedPhase &operator=(const ScopedPhase &) = delete;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PROFILE_PHASES
+#define PROFILE_PHASE(profile, phase) ScopedPhase PROFILE_CONCAT(scopedPhase, __LINE__)(profile, phase) // Times the rest of the scope
+#else
+#define PROFILE_PHASE(profile, phase)
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "QueueKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL
+#include<immintrin.h>
+#endif
+
+
+/*
+Scalar path. Advances up to 4 lanes per pass over the jobs. 
+*/
+static void simQueueLanesScalar(const double *arrival, const double *service, int noOfJobs, const double *freq, int noOfLanes, double wakeUp, 
+	double *ER, double *opLength, double *offLength, double *wakeUps, double target, double *overTarget){
+
+	double prevDepart[4], er[4], op[4], off[4], wakes[4], over[4];
+
+	for (int l = 0; l < noOfLanes; l++){
+		prevDepart[l] = arrival[0] + service[0] / freq[l];
+		er[l] = prevDepart[l] - arrival[0];
+		op[l] = 0 + prevDepart[l] - arrival[0];
+		off[l] = 0 + arrival[0];
+		wakes[l] = 0;
+		over[l] = er[l] > target ? 1 : 0;
+	}
+
+	for (int job = 1; job < noOfJobs; job++){
+		double a = arrival[job];
+		double s = service[job];
+		for (int l = 0; l < noOfLanes; l++){
+			double x = s / freq[l];
+			bool busy = a <= prevDepart[l];
+			op[l] = op[l] + x + (busy ? 0.0 : wakeUp);
+			off[l] = busy ? off[l] : off[l] + a - prevDepart[l];
+			prevDepart[l] = busy ? prevDepart[l] + x : a + x + wakeUp;
+			er[l] = er[l] + prevDepart[l] - a;
+			wakes[l] = busy ? wakes[l] : wakes[l] + 1;
+			over[l] = prevDepart[l] - a > target ? over[l] + 1 : over[l];
+		}
+	}
+
+	for (int l = 0; l < noOfLanes; l++){
+		ER[l] = er[l];
+		opLength[l] = op[l];
+		offLength[l] = off[l];
+		if (wakeUps != nullptr){
+			wakeUps[l] = wakes[l];
+		}
+		if (overTarget != nullptr){
+			overTarget[l] = over[l];
+		}
+	}
+}
+
+
+#ifdef HAVE_AVX2_KERNEL
+
+/*
+AVX2 path. V registers of 4 lanes each, so 4, 8 or 16 frequencies per pass. Several independent registers hide the latency of the 
+recursion, which is a dependency chain across jobs. The count of jobs over the target is off that chain. 
+*/
+template<int V, bool COUNT_WAKEUPS, bool COUNT_OVER>
+__attribute__((target("avx2")))
+static void simQueueLanesAVX2(const double *arrival, const double *service, int noOfJobs, const double *freq, double wakeUp, 
+	double *ER, double *opLength, double *offLength, double *wakeUps, double target, double *overTarget){
+
+	__m256d f[V], prevDepart[V], er[V], op[V], off[V], wakes[V], over[V];
+	const __m256d w = _mm256_set1_pd(wakeUp);
+	const __m256d t = _mm256_set1_pd(target);
+	const __m256d one = _mm256_set1_pd(1);
+	const __m256d a0 = _mm256_set1_pd(arrival[0]);
+	const __m256d s0 = _mm256_set1_pd(service[0]);
+
+	for (int v = 0; v < V; v++){
+		f[v] = _mm256_loadu_pd(freq + 4 * v);
+		prevDepart[v] = _mm256_add_pd(a0, _mm256_div_pd(s0, f[v]));
+		er[v] = _mm256_sub_pd(prevDepart[v], a0);
+		op[v] = er[v];
+		off[v] = a0;
+		wakes[v] = _mm256_setzero_pd();
+		over[v] = _mm256_and_pd(_mm256_cmp_pd(er[v], t, _CMP_GT_OQ), one);
+	}
+
+	for (int job = 1; job < noOfJobs; job++){
+		const __m256d a = _mm256_set1_pd(arrival[job]);
+		const __m256d s = _mm256_set1_pd(service[job]);
+		for (int v = 0; v < V; v++){
+			__m256d x = _mm256_div_pd(s, f[v]);
+			__m256d busy = _mm256_cmp_pd(a, prevDepart[v], _CMP_LE_OQ);
+
+			// Busy lanes add 0 instead of the wake-up latency, which leaves their sum unchanged. 
+			op[v] = _mm256_add_pd(_mm256_add_pd(op[v], x), _mm256_andnot_pd(busy, w));
+			off[v] = _mm256_blendv_pd(_mm256_sub_pd(_mm256_add_pd(off[v], a), prevDepart[v]), off[v], busy);
+			prevDepart[v] = _mm256_blendv_pd(_mm256_add_pd(_mm256_add_pd(a, x), w), _mm256_add_pd(prevDepart[v], x), busy);
+			er[v] = _mm256_sub_pd(_mm256_add_pd(er[v], prevDepart[v]), a);
+			if (COUNT_WAKEUPS){
+				wakes[v] = _mm256_add_pd(wakes[v], _mm256_andnot_pd(busy, one));
+			}
+			if (COUNT_OVER){
+				over[v] = _mm256_add_pd(over[v], _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(prevDepart[v], a), t, _CMP_GT_OQ), one));
+			}
+		}
+	}
+
+	for (int v = 0; v < V; v++){
+		_mm256_storeu_pd(ER + 4 * v, er[v]);
+		_mm256_storeu_pd(opLength + 4 * v, op[v]);
+		_mm256_storeu_pd(offLength + 4 * v, off[v]);
+		if (COUNT_WAKEUPS){
+			_mm256_storeu_pd(wakeUps + 4 * v, wakes[v]);
+		}
+		if (COUNT_OVER){
+			_mm256_storeu_pd(overTarget + 4 * v, over[v]);
+		}
+	}
+}
+
+static bool cpuHasAVX2(){
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	return hasAVX2;
+}
+
+#endif // HAVE_AVX2_KERNEL
+
+
+#ifdef HAVE_AVX2_KERNEL
+template<bool COUNT_WAKEUPS, bool COUNT_OVER>
+static int simQueueMultiFreqAVX2(const double *arrival, const double *service, int noOfJobs, const double *freq, int noOfLanes, double wakeUp, 
+	double *ER, double *opLength, double *offLength, double *wakeUps, double target, double *overTarget){
+
+	// Lanes simulated. wakeUps and overTarget are only offset when they are counted.
+	int lane = 0;
+	for (; lane + 16 <= noOfLanes; lane += 16){
+		simQueueLanesAVX2<4, COUNT_WAKEUPS, COUNT_OVER>(arrival, service, noOfJobs, freq + lane, wakeUp, ER + lane, opLength + lane, offLength + lane, 
+			COUNT_WAKEUPS ? wakeUps + lane : nullptr, target, COUNT_OVER ? overTarget + lane : nullptr);
+	}
+	for (; lane + 8 <= noOfLanes; lane += 8){
+		simQueueLanesAVX2<2, COUNT_WAKEUPS, COUNT_OVER>(arrival, service, noOfJobs, freq + lane, wakeUp, ER + lane, opLength + lane, offLength + lane, 
+			COUNT_WAKEUPS ? wakeUps + lane : nullptr, target, COUNT_OVER ? overTarget + lane : nullptr);
+	}
+	for (; lane + 4 <= noOfLanes; lane += 4){
+		simQueueLanesAVX2<1, COUNT_WAKEUPS, COUNT_OVER>(arrival, service, noOfJobs, freq + lane, wakeUp, ER + lane, opLength + lane, offLength + lane, 
+			COUNT_WAKEUPS ? wakeUps + lane : nullptr, target, COUNT_OVER ? overTarget + lane : nullptr);
+	}
+	return lane;
+}
+#endif
+
+void simQueueMultiFreq(const double *arrival, const double *service, int noOfJobs, const double *freq, int noOfLanes, double wakeUp, 
+	double *ER, double *opLength, double *offLength, double *wakeUps, double target, double *overTarget){
+
+	int lane = 0;
+
+#ifdef HAVE_AVX2_KERNEL
+	if (cpuHasAVX2()){
+		if (overTarget != nullptr){
+			if (wakeUps != nullptr){
+				lane = simQueueMultiFreqAVX2<true, true>(arrival, service, noOfJobs, freq, noOfLanes, wakeUp, ER, opLength, offLength, wakeUps, target, overTarget);
+			}
+			else {
+				lane = simQueueMultiFreqAVX2<false, true>(arrival, service, noOfJobs, freq, noOfLanes, wakeUp, ER, opLength, offLength, wakeUps, target, overTarget);
+			}
+		}
+		else if (wakeUps != nullptr){
+			lane = simQueueMultiFreqAVX2<true, false>(arrival, service, noOfJobs, freq, noOfLanes, wakeUp, ER, opLength, offLength, wakeUps, target, overTarget);
+		}
+		else {
+			lane = simQueueMultiFreqAVX2<false, false>(arrival, service, noOfJobs, freq, noOfLanes, wakeUp, ER, opLength, offLength, wakeUps, target, overTarget);
+		}
+	}
+#endif
+
+	for (; lane < noOfLanes; lane += 4){
+		simQueueLanesScalar(arrival, service, noOfJobs, freq + lane, min(4, noOfLanes - lane), wakeUp, ER + lane, opLength + lane, offLength + lane, 
+			wakeUps == nullptr ? nullptr : wakeUps + lane, target, overTarget == nullptr ? nullptr : overTarget + lane);
+	}
+}
+
+string queueKernelName(){
+#ifdef HAVE_AVX2_KERNEL
+	if (cpuHasAVX2()){
+		return "AVX2";
+	}
+#endif
+	return "scalar";
+}
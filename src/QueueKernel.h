@@ -0,0 +1,187 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+FCFS kernels. 
+
+The single-policy kernel (fcfsKernel) is the one loop behind simQueue, doQueue, doQueueBaseline and the parallel scan. It is a template 
+over the job stream (the job log as parallel arrays, or queued Job records) and is specialized at compile time for whether response 
+times are counted (not during the warm-up) and whether the idle state has a wake-up latency. fcfsQueue picks the specialization. 
+The single-policy kernel can record every response time into a histogram (LatencyHistogram.h) for the report. For a percentile target, 
+both kernels count the response times above it instead, which decides the target exactly at the cost of a compare. 
+
+The multi-frequency kernel simulates one job stream under a block of frequencies that share the same idle state, one lane per 
+frequency, so the job stream is read once per block instead of once per policy. The busy/idle branch of simQueue becomes a blend. 
+Per lane, every floating-point operation is the same as in simQueue and in the same order, so the results match it bit for bit. 
+The AVX2 path is picked at runtime when the processor supports it. Otherwise a scalar path is used. 
+*/
+
+#ifndef QUEUEKERNEL_H
+#define QUEUEKERNEL_H
+
+#include "Job.h"
+#include "LatencyHistogram.h"
+#include<string>
+#include<algorithm>
+#include<cmath>
+using namespace std;
+
+/*
+Sums of an FCFS run of one policy. 
+*/
+struct QueueTotals{
+	double ER = 0; // Sum of response times
+	double opLength = 0; // Busy time, including wake-ups
+	double offLength = 0; // Idle time
+	double prevDepart = 0; // Departure before the first job on input, of the last job on output
+	double wakeUps = 0; // Jobs that found the server idle
+	double target = INFINITY; // Response time above which a counted job adds to overTarget. Only read.
+	double overTarget = 0; // Counted jobs with a longer response time than target
+};
+
+// Job stream as parallel arrays, e.g., the job log rescaled by doSleepScale
+struct JobArrays{
+	const double *arrivals;
+	const double *services;
+	double arrival(int job) const { return this->arrivals[job]; }
+	double service(int job) const { return this->services[job]; }
+};
+
+// Job stream as Job records, e.g., the job queue run by doQueue
+struct JobRecords{
+	const Job *jobs;
+	double arrival(int job) const { return this->jobs[job].arrival; }
+	double service(int job) const { return this->jobs[job].service; }
+};
+
+/*
+First job of a server that starts empty at time 0. It does not pay the wake-up latency. Sets totals.ER and totals.prevDepart, and adds 
+to the busy and idle time. Its response time goes to latencies unless that is null. 
+*/
+template<class Jobs>
+inline void fcfsStart(const Jobs &jobs, double freq, QueueTotals &totals, LatencyHistogram *latencies = nullptr){
+	totals.prevDepart = jobs.arrival(0) + jobs.service(0) / freq;
+	totals.ER = totals.prevDepart - jobs.arrival(0);
+	totals.overTarget = totals.ER > totals.target ? totals.overTarget + 1 : totals.overTarget;
+	if (latencies != nullptr){
+		latencies->record(totals.ER);
+	}
+	totals.opLength = totals.opLength + totals.prevDepart - jobs.arrival(0);
+	totals.offLength = totals.offLength + jobs.arrival(0);
+}
+
+/*
+Run jobs[first, last) at frequency freq after a departure at totals.prevDepart and add to the sums in totals. Without COUNTED the 
+response times are not summed. Without WAKE_UP the latency is left out, and busy and idle jobs differ only in selects, so the loop has 
+no branch. Every floating-point operation is the one of the general case (adding a zero latency leaves a sum unchanged), so all 
+specializations give the same results, bit for bit. Unless latencies is null, every response time is recorded in it, counted or not. 
+*/
+template<bool COUNTED, bool WAKE_UP, class Jobs>
+inline void fcfsKernel(const Jobs &jobs, int first, int last, double freq, double wakeUp, QueueTotals &totals, LatencyHistogram *latencies = nullptr){
+
+	double ER = totals.ER;
+	double opLength = totals.opLength;
+	double offLength = totals.offLength;
+	double prevDepart = totals.prevDepart;
+	double wakeUps = totals.wakeUps;
+	double target = totals.target;
+	double overTarget = totals.overTarget;
+
+	for (int job = first; job < last; job++){
+		double arrival = jobs.arrival(job);
+		double busy = jobs.service(job) / freq;
+
+		if (!WAKE_UP){
+			bool idle = arrival > prevDepart;
+			offLength = idle ? offLength + arrival - prevDepart : offLength;
+			opLength = opLength + busy;
+			prevDepart = (idle ? arrival : prevDepart) + busy;
+			wakeUps = idle ? wakeUps + 1 : wakeUps;
+		}
+		else if (arrival <= prevDepart){
+			opLength = opLength + busy;
+			prevDepart = prevDepart + busy;
+		}
+		else {
+			offLength = offLength + arrival - prevDepart;
+			opLength = opLength + busy + wakeUp;
+			prevDepart = arrival + busy + wakeUp;
+			wakeUps = wakeUps + 1;
+		}
+
+		if (COUNTED){
+			ER = ER + prevDepart - arrival;
+			overTarget = prevDepart - arrival > target ? overTarget + 1 : overTarget;
+		}
+		if (latencies != nullptr){
+			latencies->record(prevDepart - arrival);
+		}
+	}
+
+	totals.ER = ER;
+	totals.opLength = opLength;
+	totals.offLength = offLength;
+	totals.prevDepart = prevDepart;
+	totals.wakeUps = wakeUps;
+	totals.overTarget = overTarget;
+}
+
+// fcfsKernel, specialized for the given run
+template<class Jobs>
+inline void fcfsQueue(const Jobs &jobs, int first, int last, double freq, double wakeUp, bool counted, QueueTotals &totals, 
+	LatencyHistogram *latencies = nullptr){
+	if (counted && wakeUp != 0){
+		fcfsKernel<true, true>(jobs, first, last, freq, wakeUp, totals, latencies);
+	}
+	else if (counted){
+		fcfsKernel<true, false>(jobs, first, last, freq, wakeUp, totals, latencies);
+	}
+	else if (wakeUp != 0){
+		fcfsKernel<false, true>(jobs, first, last, freq, wakeUp, totals, latencies);
+	}
+	else {
+		fcfsKernel<false, false>(jobs, first, last, freq, wakeUp, totals, latencies);
+	}
+}
+
+/*
+Simulate noOfLanes frequencies freq[0..noOfLanes) with wake-up latency wakeUp over noOfJobs jobs. The first job starts the system, 
+as in simQueue. For every lane, ER receives the sum of response times, opLength/offLength the busy and idle time, and wakeUps the 
+number of jobs that found the server idle. wakeUps may be null when the idle state has no transition energy, which saves a register. 
+Unless overTarget is null, it receives the number of jobs of each lane with a response time above target. 
+*/
+void simQueueMultiFreq(const double *arrival, const double *service, int noOfJobs, const double *freq, int noOfLanes, double wakeUp, 
+	double *ER, double *opLength, double *offLength, double *wakeUps, double target = INFINITY, double *overTarget = nullptr);
+
+string queueKernelName(); // Which kernel simQueueMultiFreq dispatches to, "AVX2" or "scalar"
+
+#endif
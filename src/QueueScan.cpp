@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "QueueScan.h"
+#include<algorithm>
+
+// One FCFS step, exactly as in doQueue
+static inline void stepJob(const Job &job, double freq, double wakeUp, QueueTotals &totals, LatencyHistogram *latencies){
+	fcfsKernel<true, true>(JobRecords{ &job }, 0, 1, freq, wakeUp, totals, latencies);
+}
+
+// First job of a chunk that starts with an empty server. Its idle time is unknown until the true start is, so it is not counted.
+static inline void stepFirstJobEmpty(const Job &job, double freq, double wakeUp, QueueTotals &totals, LatencyHistogram *latencies){
+	totals.opLength = totals.opLength + job.service / freq + wakeUp;
+	totals.prevDepart = job.arrival + job.service / freq + wakeUp;
+	totals.wakeUps = totals.wakeUps + 1;
+	totals.ER = totals.ER + totals.prevDepart - job.arrival;
+	totals.overTarget = totals.prevDepart - job.arrival > totals.target ? totals.overTarget + 1 : totals.overTarget;
+	if (latencies != nullptr){
+		latencies->record(totals.prevDepart - job.arrival);
+	}
+}
+
+void simQueueSequential(const Job *jobs, int noOfJobs, double freq, double wakeUp, QueueTotals &totals, LatencyHistogram *latencies){
+	fcfsQueue(JobRecords{ jobs }, 0, noOfJobs, freq, wakeUp, true, totals, latencies);
+}
+
+void simQueueScan(const Job *jobs, int noOfJobs, double freq, double wakeUp, ThreadPool &pool, QueueTotals &totals, LatencyHistogram *latencies){
+
+	int noOfChunks = min(pool.getSize(), noOfJobs);
+	if (noOfChunks <= 1){
+		simQueueSequential(jobs, noOfJobs, freq, wakeUp, totals, latencies);
+		return;
+	}
+
+	// Histograms of the chunks and of the prefixes of the second pass, only if response times are recorded
+	bool record = latencies != nullptr;
+	vector<LatencyHistogram> chunkLatencies(record ? noOfChunks : 0);
+	vector<LatencyHistogram> prefixLatencies(record ? 2 : 0);
+
+	vector<int> chunkStart(noOfChunks + 1);
+	for (int c = 0; c <= noOfChunks; c++){
+		chunkStart.at(c) = static_cast<int>(static_cast<long>(noOfJobs) * c / noOfChunks);
+	}
+
+	// Pass 1: chunk 0 from the true start, the others from an empty server
+	vector<QueueTotals> speculative(noOfChunks);
+	for (auto &sums : speculative){
+		sums.target = totals.target;
+	}
+	speculative.at(0).prevDepart = totals.prevDepart;
+	pool.parallelFor(noOfChunks, [&](int c){
+		const Job *chunk = jobs + chunkStart.at(c);
+		int length = chunkStart.at(c + 1) - chunkStart.at(c);
+		QueueTotals &sums = speculative.at(c);
+		LatencyHistogram *chunkRecord = record ? &chunkLatencies.at(c) : nullptr;
+		if (c == 0){
+			simQueueSequential(chunk, length, freq, wakeUp, sums, chunkRecord);
+		}
+		else {
+			stepFirstJobEmpty(chunk[0], freq, wakeUp, sums, chunkRecord);
+			simQueueSequential(chunk + 1, length - 1, freq, wakeUp, sums, chunkRecord);
+		}
+	});
+
+	// Pass 2: in order, redo each chunk from its true start until it meets the speculative run
+	QueueTotals chunkSums = speculative.at(0);
+	totals.ER = totals.ER + chunkSums.ER;
+	totals.opLength = totals.opLength + chunkSums.opLength;
+	totals.offLength = totals.offLength + chunkSums.offLength;
+	totals.prevDepart = chunkSums.prevDepart;
+	totals.wakeUps = totals.wakeUps + chunkSums.wakeUps;
+	totals.overTarget = totals.overTarget + chunkSums.overTarget;
+	if (record){
+		latencies->merge(chunkLatencies.at(0));
+	}
+
+	for (int c = 1; c < noOfChunks; c++){
+		const Job *chunk = jobs + chunkStart.at(c);
+		int length = chunkStart.at(c + 1) - chunkStart.at(c);
+
+		QueueTotals truePrefix; // From the true start
+		QueueTotals emptyPrefix; // The same jobs of the speculative run
+		truePrefix.prevDepart = totals.prevDepart;
+		truePrefix.target = totals.target;
+		emptyPrefix.target = totals.target;
+		LatencyHistogram *trueRecord = nullptr;
+		LatencyHistogram *emptyRecord = nullptr;
+		if (record){
+			trueRecord = &prefixLatencies.at(0);
+			emptyRecord = &prefixLatencies.at(1);
+			trueRecord->clear();
+			emptyRecord->clear();
+		}
+
+		bool met = false;
+		for (int job = 0; job < length; job++){
+			stepJob(chunk[job], freq, wakeUp, truePrefix, trueRecord);
+			if (job == 0){
+				stepFirstJobEmpty(chunk[job], freq, wakeUp, emptyPrefix, emptyRecord);
+			}
+			else {
+				stepJob(chunk[job], freq, wakeUp, emptyPrefix, emptyRecord);
+			}
+			if (truePrefix.prevDepart == emptyPrefix.prevDepart){
+				met = true;
+				break;
+			}
+		}
+
+		const QueueTotals &spec = speculative.at(c);
+		if (met){
+			chunkSums.ER = spec.ER - emptyPrefix.ER + truePrefix.ER;
+			chunkSums.opLength = spec.opLength - emptyPrefix.opLength + truePrefix.opLength;
+			chunkSums.offLength = spec.offLength - emptyPrefix.offLength + truePrefix.offLength;
+			chunkSums.wakeUps = spec.wakeUps - emptyPrefix.wakeUps + truePrefix.wakeUps;
+			chunkSums.overTarget = spec.overTarget - emptyPrefix.overTarget + truePrefix.overTarget;
+			chunkSums.prevDepart = spec.prevDepart;
+			if (record){
+				latencies->merge(chunkLatencies.at(c));
+				latencies->subtract(*emptyRecord);
+				latencies->merge(*trueRecord);
+			}
+		}
+		else {
+			chunkSums = truePrefix;
+			if (record){
+				latencies->merge(*trueRecord);
+			}
+		}
+
+		totals.ER = totals.ER + chunkSums.ER;
+		totals.opLength = totals.opLength + chunkSums.opLength;
+		totals.offLength = totals.offLength + chunkSums.offLength;
+		totals.prevDepart = chunkSums.prevDepart;
+		totals.wakeUps = totals.wakeUps + chunkSums.wakeUps;
+		totals.overTarget = totals.overTarget + chunkSums.overTarget;
+	}
+}
@@ -0,0 +1,75 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Chunked parallel scan of the FCFS recursion 
+
+	departure_i = departure_{i-1} + service_i / f               if arrival_i <= departure_{i-1}
+	departure_i = arrival_i + service_i / f + wakeUp            otherwise
+
+for one very long job stream, e.g., a minute of a high-rate trace in doQueue. 
+
+Job i's departure depends on the past only through departure_{i-1}, so two runs of the same jobs from different starts are identical 
+from the first job whose departure is the same in both. That is the invariant the scan relies on; it is checked by comparing 
+departures, never assumed. The departure is not monotone in departure_{i-1}: with a wake-up latency, a job that finds the server idle 
+leaves after arrival_i + service_i / f + wakeUp, which can be later than if it had queued behind a slightly later departure_{i-1}. 
+
+The stream is cut into one chunk per thread. Every chunk except the first is first simulated in parallel as if the server were empty 
+when it starts. A second, sequential pass then walks each chunk from its true starting departure until a job departs at the same 
+time as in the speculative run, typically a job that finds both runs idle, and corrects the chunk's sums by the difference over that 
+prefix. Under moderate load the prefix is a handful of jobs, so the second pass is short; in the worst case (the runs never meet) it 
+walks the whole chunk again and its own sums are used. 
+
+Response times go to a histogram the same way: each chunk records into its own, and the second pass swaps the prefix recorded by the 
+speculative run for the true one before the chunk is merged. Results are exact for any wake-up latency, but sums are added chunk by 
+chunk, so they can differ from the sequential loop in the last bits. doQueue therefore only uses the scan for queues of at least 
+PARALLEL_SCAN_MIN_JOBS jobs (config.h). 
+*/
+
+#ifndef QUEUESCAN_H
+#define QUEUESCAN_H
+
+#include "Job.h"
+#include "ThreadPool.h"
+#include "QueueKernel.h"
+
+/*
+Run jobs[0, noOfJobs) at frequency freq after a departure at totals.prevDepart, spreading the work over the pool. The sums are added 
+to totals and, unless latencies is null, the response times to latencies. 
+*/
+void simQueueScan(const Job *jobs, int noOfJobs, double freq, double wakeUp, ThreadPool &pool, QueueTotals &totals, LatencyHistogram *latencies = nullptr);
+
+// Same, in sequence. The reference the scan is checked against. 
+void simQueueSequential(const Job *jobs, int noOfJobs, double freq, double wakeUp, QueueTotals &totals, LatencyHistogram *latencies = nullptr);
+
+#endif
@@ -36,229 +36,592 @@ DO NOT TURN ON DO_SLEEPSCALE_ADV. IT IS STILL UNDER DEVELOPMENT
 #include "Server.h"
 #include "const.h"
 #include "config.h"
+#include "Checkpoint.h"
+#include<chrono>
+#include<cmath>
 
 
 void Server::run(const string rho_in, const string cdf_ser, const string cdf_arr){
 
+	// Sampling tables are built once and reused every minute. The CDFs may be text or compiled (CompiledCdf.h).
+	auto serDist = loadCdfTable(cdf_ser);
+	auto arrDist = loadCdfTable(cdf_arr);
+
+	this->run(rho_in, *serDist, *arrDist);
+}
+
+void Server::run(const string rho_in, const EmpiricalDistribution &serDist, const EmpiricalDistribution &arrDist){
+
 	/*
-	rho_in is the utilization log. cdf_ser and cdf_arr are cdf distributions used to generate workload. SleepScale is called every T mins
+	rho_in is the utilization log. serDist and arrDist are the service and inter-arrival distributions used to generate workload. 
+	They are only read, so one copy can be shared by several servers running at the same time. SleepScale is called every T mins
 	and only when job log has accumulated JOB_LOG_LENGTH = 10,000 jobs.
 	*/ 
 
-	// Open those files!
-	this->logOut << "[SLEEPSCALE] Preparing SleepScale..." << endl;
-	ifstream rhoIn;
-	openInputFile(rho_in, rhoIn);
+	this->start(rho_in);
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] CDFs are read! Mean service time is " << serDist.getMean() << 
+		" and mean inter-arrival time is " << arrDist.getMean();
 
-#ifdef DO_OFFLINE
-	ifstream rhoInOffline;
-	openInputFile(rho_in, rhoInOffline);
-#endif
+	bool checkpointing = !this->config.checkpoint.empty();
+	if (checkpointing && this->config.resume && ifstream(this->config.checkpoint).good()){
+		restoreCheckpoint(this->config.checkpoint);
+	}
+
+	while (this->isRunning()){
+		double newRho = this->stepMinute();
+
+		if (newRho >= 0){
+			// Generate workload by sampling CDFs. 
+			generateWorkloadCDF(serDist, arrDist, this->minute, newRho);
+
+			if (checkpointing && this->minute % this->config.checkpointInterval == 0){
+				saveCheckpoint(this->config.checkpoint);
+			}
+		}
+	}
+
+	this->finish();
+	return;
+}
 
-	// arr_sample and arr_prob stores the histogram of inter-arrival time. The probability of each entry in arr_sample is stored in arr_prob 
-	vector<double> CDF_arrSample;
-	vector<double> CDF_arrProb;
-	vector<double> CDF_serSample;
-	vector<double> CDF_serProb;
+/*
+Open the trace and set up the estimator. Afterwards call stepMinute until isRunning is false, handing the server every minute's workload 
+in between (generateWorkloadCDF or addWorkload), and then finish. run does exactly this. 
+*/
+void Server::start(const string rho_in){
 
-	ifstream arrCdfFile;
-	readBigHouseCDF(CDF_arrSample, CDF_arrProb, cdf_arr, arrCdfFile);
+	// Open those files!
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Preparing SleepScale...";
+#ifndef DO_OFFLINE
+	start(openTraceSource(rho_in, this->config.traceReader));
+#else
+	if (this->config.traceReader == TRACE_MMAP){
+		// The observer and the offline estimator walk the same mapping
+		auto trace = make_shared<const MappedTrace>(rho_in);
+		this->rhoInOffline = make_shared<MappedTraceReader>(trace);
+		start(make_shared<MappedTraceReader>(trace));
+	}
+	else {
+		this->rhoInOffline = openTraceSource(rho_in, this->config.traceReader);
+		start(openTraceSource(rho_in, this->config.traceReader));
+	}
+#endif
+}
 
-	ifstream serCdfFile;	
-	readBigHouseCDF(CDF_serSample, CDF_serProb, cdf_ser, serCdfFile);
-	this->logOut << "[SLEEPSCALE] All files are open. CDFs are read!" << endl;
+void Server::start(shared_ptr<TraceSource> rho_in){
 
-	this->logOut << "[SLEEPSCALE] Constructing the estimator..." << endl;
+	this->rhoIn = rho_in;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] All files are open.";
+
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Constructing the estimator...";
 	// Construct the estimator
-	this->estimator = make_shared<Estimator>(EST_LOOKBACK, rhoIn, this->logOut);
+	this->estimator = make_shared<Estimator>(this->config.estLookback, this->logOut);
 
-	this->logOut << "[SlEEPSCALE] Ensuring the clock is reset -- current minute # is " << this->minute << endl;
-	this->logOut << "[SLEEPSCALE] SleepScale is ready!" << endl;
-	this->logOut << "[SLEEPSCALE] Starting SleepScale..." << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SlEEPSCALE] Ensuring the clock is reset -- current minute # is " << this->minute;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] SleepScale is ready!";
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Starting SleepScale...";
 
 	// Initialize the first policy
-	shared_ptr<PowerState> lastBestPolicy = this->allPolicy.at(0);
+	this->lastBestPolicy = this->allPolicy.at(0);
+}
+
+// Observe the utilization of this minute
+double Server::observe(){
+	PROFILE_PHASE(this->profile, PHASE_OBSERVE);
+	return this->estimator->observeRho(*this->rhoIn, this->logOut);
+}
+
+bool Server::isRunning() const{
+	return this->estimator->estimatorStatus && this->estimator->observorStatus;
+}
+
+/*
+One minute of operation: estimate the utilization, run the server on the jobs queued so far and pick the next policy when it is time to, 
+then observe the utilization of this minute from the trace. Returns it, or a negative number once the trace ends, in which case the 
+remaining jobs are run and the report is written. The caller then generates the jobs of this minute. 
+*/
+double Server::stepMinute(){
 
-	while (this->estimator->estimatorStatus && this->estimator->observorStatus){
+	LOG_TO(this->logOut, LOG_INFO) << "";
+	// cout << "====== MINUTE # " << this->minute << endl;
 
-		this->logOut << endl;
-		// cout << "====== MINUTE # " << this->minute << endl;
+	LOG_TO(this->logOut, LOG_INFO) << "====== STARTING MINUTE # " << this->minute;
 
-		this->logOut << "====== STARTING MINUTE # " << this->minute << endl;
+	if (this->metrics == nullptr && !this->config.metrics.empty()){
+		this->metrics = make_shared<MetricsWriter>(this->config.metrics);
+	}
+	this->minuteMetrics = MinuteMetrics();
+	this->minuteMetrics.minute = this->minute;
 
-		// Estimate rho
-		this->logOut << "[SLEEPSCALE] Estimating the utilization for minute # " << this->minute << endl;
+	// Estimate rho
+	LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Estimating the utilization for minute # " << this->minute;
 
+	{
+		PROFILE_PHASE(this->profile, PHASE_ESTIMATE);
 #ifndef DO_OFFLINE
 		this->estimator->estimateRho(this->logOut);
 #else
-		this->estimator->estimateRho(this->logOut, rhoInOffline);
+		this->estimator->estimateRho(this->logOut, *this->rhoInOffline);
 #endif
+	}
 
-		// Run SleepScale only after job log size reaches JOB_LOG_LENGTH and every UPDATE_INTERVAL minutes
-		if (this->minute > 0 && this->minute % UPDATE_INTERVAL == 0 && this->jobLog.readyForSleepScale()){
+	this->minuteMetrics.estimatedRho = this->estimator->est;
 
-			assert(this->jobLog.getSize() == this->jobLog.size);
+	double newRho;
 
-			this->logOut << "+++++++++++++++ Time to adjust policy at minute # " << this->minute << endl;
-			
-			/* 
-			Run the server in SleepScale. The server is ran at the end of every UPDATE_INTERVAL minutes, before calling SleepScale. 
-			The policy it uses to run is calculated by the previous SleepScale process. 
-			*/
-			this->logOut << "[SLEEPSCALE] Run the server" << endl;
-			this->doQueue(lastBestPolicy, this->jobQueue);			
+	// Run SleepScale only after job log size reaches JOB_LOG_LENGTH and every update interval
+	if (this->minute > 0 && this->minute % this->config.updateInterval == 0 && this->jobLog.readyForSleepScale()){
 
-			// Run the server using baseline. 
-			this->logOut << "[SLEEPSCALE] Run the baseline" << endl;
-			this->doQueueBaseline(this->allPolicy.at(0), this->jobQueue);
+		assert(this->jobLog.getSize() == this->jobLog.size);
 
-			// Workload queue is cleared. 
-			this->jobQueue.clear(); // Clear job queue
+		LOG_TO(this->logOut, LOG_INFO) << "+++++++++++++++ Time to adjust policy at minute # " << this->minute;
+		
+		/* 
+		Run the server in SleepScale. The server is ran at the end of every update interval, before calling SleepScale. 
+		The policy it uses to run is calculated by the previous SleepScale process. 
+		*/
+		LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Run the server";
+		this->doQueue(this->lastBestPolicy, this->jobQueue);			
 
-			// Then do SleepScale. SleepScale only has access to the job log. It has to adjust their 
-			// inter-arrival time to match the predicted utilization. 
-			this->logOut << "++++++++++++++++++++++++++++++ Now do SleepScale!" << endl;
-			
-			// Do SleepScale
-			lastBestPolicy = this->doSleepScale();
+		// Run the server using baseline. 
+		LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Run the baseline";
+		this->doQueueBaseline(this->allPolicy.at(0), this->jobQueue);
+
+		// Workload queue is cleared. 
+		this->jobQueue.clear(); // Clear job queue
+
+		// Then do SleepScale. SleepScale only has access to the job log. It has to adjust their 
+		// inter-arrival time to match the predicted utilization. 
+		LOG_TO(this->logOut, LOG_DEBUG) << "++++++++++++++++++++++++++++++ Now do SleepScale!";
 		
-			// Observe a new rho for the next minute. 
-			this->logOut << "[SLEEPSCALE] Observe the utilization of minute # " << this->minute << endl;
-			double newRho = this->estimator->observeRho(rhoIn, this->logOut);
-
-			if (newRho >= 0){
-				// Generate workload by sampling CDFs. 
-				this->logOut << "[SLEEPSCALE] Generate workload for minute # " << this->minute << " under utilization " << newRho << "." << endl;
-				generateWorkloadCDF(CDF_serProb, CDF_serSample, CDF_arrProb, CDF_arrSample, this->minute, newRho);
-				++this->minute;
-			}
-			else {
-				this->logOut << "[SLEEPSCALE] Observer reached the EoF. Preparing to terminate!" << endl;
+		// Do SleepScale
+		auto decisionStart = chrono::steady_clock::now();
+		this->lastBestPolicy = this->doSleepScale();
+		this->minuteMetrics.computeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - decisionStart).count();
+		if (this->onDecision){
+			this->onDecision(*this->lastBestPolicy, this->minuteMetrics.computeMs);
+		}
+	
+		// Observe a new rho for the next minute. 
+		LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Observe the utilization of minute # " << this->minute;
+		newRho = observe();
 
-				showReport();
-			}
+		if (newRho < 0){
+			LOG_TO(this->logOut, LOG_INFO) << "[SLEEPSCALE] Observer reached the EoF. Preparing to terminate!";
 
+			showReport();
 		}
-		else{ 
-			// If SleepScale is not done in this minute, observe a new rho for the next minute. 
-			
-			this->logOut << "[SLEEPSCALE] Observe the utilization of minute # " << this->minute << endl;
-			double newRho = this->estimator->observeRho(rhoIn, this->logOut);
-
-			if (newRho >= 0){
-				// Generate workload by sampling CDFs. Remember to keep track of the utilization
-				this->logOut << "[SLEEPSCALE] Generate workload for minute # " << this->minute << " under utilization " << newRho << "." << endl;
-				generateWorkloadCDF(CDF_serProb, CDF_serSample, CDF_arrProb, CDF_arrSample, this->minute, newRho);
-				++this->minute;
-			}
-			else { // If reaches the EoF, then run the server and terminate. 
-				this->logOut << "[SLEEPSCALE] Observer reached the EoF. Preparing to terminate!" << endl;
 
-				this->logOut << "[SLEEPSCALE] Run the server" << endl;
-				this->doQueue(lastBestPolicy, this->jobQueue);
+	}
+	else{ 
+		// If SleepScale is not done in this minute, observe a new rho for the next minute. 
+		
+		LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Observe the utilization of minute # " << this->minute;
+		newRho = observe();
 
-				this->bestFreqUsed.push_back(lastBestPolicy->freq);
-				this->bestLowpowerUsed.push_back(lastBestPolicy->idle);
+		if (newRho < 0){ // If reaches the EoF, then run the server and terminate. 
+			LOG_TO(this->logOut, LOG_INFO) << "[SLEEPSCALE] Observer reached the EoF. Preparing to terminate!";
 
-				// Run the server using baseline. 
-				this->logOut << "[SLEEPSCALE] Run the baseline" << endl;
-				this->doQueueBaseline(this->allPolicy.at(0), this->jobQueue);
+			LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Run the server";
+			this->doQueue(this->lastBestPolicy, this->jobQueue);
 
-				showReport();
-			}
+			this->bestFreqUsed.push_back(this->lastBestPolicy->freq);
+			this->bestLowpowerUsed.push_back(this->lastBestPolicy->idle);
+			this->bestCoresUsed.push_back(this->lastBestPolicy->cores);
+
+			// Run the server using baseline. 
+			LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Run the baseline";
+			this->doQueueBaseline(this->allPolicy.at(0), this->jobQueue);
+
+			showReport();
 		}
+	}
 
+	if (newRho >= 0){
+		LOG_TO(this->logOut, LOG_DEBUG) << "[SLEEPSCALE] Generate workload for minute # " << this->minute << " under utilization " << newRho << ".";
 	}
 
-	rhoIn.close();
-	return;
+	if (this->metrics != nullptr){
+		this->minuteMetrics.observedRho = newRho >= 0 ? newRho : NAN;
+		this->minuteMetrics.freq = this->lastBestPolicy->freq;
+		this->minuteMetrics.idleState = this->lastBestPolicy->idleState;
+		this->minuteMetrics.cores = this->lastBestPolicy->cores;
+		this->metrics->append(this->minuteMetrics);
+		if (newRho < 0){
+			this->metrics->flush();
+		}
+	}
+
+	return newRho;
+}
+
+void Server::finish(){
+	this->rhoIn.reset();
+#ifdef DO_OFFLINE
+	this->rhoInOffline.reset();
+#endif
+}
+
+/*
+Write everything the run carries into the next minute to a checkpoint (Checkpoint.h). Called between minutes, after the jobs of the 
+minute just observed were added. 
+*/
+void Server::saveCheckpoint(const string fileName){
+
+	CheckpointHeader header = {};
+	header.configHash = checkpointConfigHash(this->config);
+	header.seed = this->config.seed;
+	header.minute = this->minute;
+	CheckpointWriter out(fileName, header);
+
+	// Sums of the run and the baseline
+	out.put(this->totalNoOfJobs);
+	out.put(this->totalNoOfJobs_baseline);
+	out.put(this->ER);
+	out.put(this->ER_baseline);
+	out.put(this->EP);
+	out.put(this->EP_baseline);
+	out.put(this->totalRunTime);
+	out.put(this->totalRunTime_baseline);
+	out.put(this->opLength);
+	out.put(this->opLength_baseline);
+	out.put(this->offLength);
+	out.put(this->offLength_baseline);
+	out.put(this->overProvision);
+	out.put(this->overProvisionBaseline);
+	out.put(this->prevDepart);
+	out.put(this->prevDepart_baseline);
+	out.put(this->latencies);
+	out.put(this->latenciesBaseline);
+	this->multiCore.save(out);
+	this->multiCoreBaseline.save(out);
+	out.put(this->residency);
+	out.put(this->residencyBaseline);
+
+	// Policies picked so far, and the last simulated numbers of every policy
+	int lastBest = find(this->allPolicy.begin(), this->allPolicy.end(), this->lastBestPolicy) - this->allPolicy.begin();
+	out.put(lastBest);
+	vector<PolicyResult> results;
+	for (auto &policy : this->allPolicy){
+		PolicyResult result;
+		result.ER = policy->ER;
+		result.EP = policy->EP;
+		result.overTarget = policy->overTarget;
+		results.push_back(result);
+	}
+	out.put(results);
+	out.put(this->bestFreqUsed);
+	out.put(this->bestLowpowerUsed);
+	out.put(this->bestCoresUsed);
+	out.put(this->p50Used);
+	out.put(this->p95Used);
+	out.put(this->p99Used);
+
+	// Counters of the report
+	out.put(this->forceSearch);
+	out.put(this->searchDisagreements);
+	out.put(this->reusedSweeps);
+	out.put(this->noOfSleepScale);
+	out.put(this->incrementalDisagreements);
+	out.put(this->incrementalMaxError);
+	out.put(this->tableRefreshMinute);
+	out.put(this->noOfTableLookups);
+	out.put(this->noOfTableRefreshes);
+	vector<PolicyTableEntry> entries; // Refreshed entries differ from the file
+	for (int i = 0; this->policyTable != nullptr && i < this->policyTable->getSize(); i++){
+		entries.push_back(this->policyTable->getEntry(i));
+	}
+	out.put(entries);
+
+	// Jobs waiting to be run, the job log, the estimator, and how far the trace was read
+	out.put(this->jobQueue);
+	this->jobLog.save(out);
+	this->estimator->save(out);
+	out.put(this->rhoIn->getLineNo());
+#ifdef DO_OFFLINE
+	out.put(this->rhoInOffline->getLineNo());
+#endif
+
+	// Metrics written so far, so that a resume drops the minutes after the checkpoint
+	uint64_t metricsBytes = 0;
+	if (this->metrics != nullptr){
+		this->metrics->flush();
+		metricsBytes = this->metrics->getBytesWritten();
+	}
+	out.put(metricsBytes);
+
+	// Likewise for the log
+	out.put(this->logOut.sync());
+
+	out.commit();
+	LOG_TO(this->logOut, LOG_INFO) << "[CHECKPOINT] Saved the state before minute # " << this->minute << " to " << fileName;
+}
+
+/*
+Continue the run from a checkpoint. Called after start, before the first stepMinute. The trace is read up to where the checkpoint was 
+taken. Terminates if the checkpoint was taken with other parameters. 
+*/
+void Server::restoreCheckpoint(const string fileName){
+
+	CheckpointReader in(fileName);
+	const CheckpointHeader &header = in.getHeader();
+	if (header.configHash != checkpointConfigHash(this->config)){
+		cerr << "Checkpoint " << fileName << " was taken with other parameters. Remove it or run with the configuration it was taken with." << endl;
+		terminate();
+	}
+	this->config.seed = header.seed; // The workload of the resumed minutes must continue that of the saved ones
+	this->minute = header.minute;
+
+	in.get(this->totalNoOfJobs);
+	in.get(this->totalNoOfJobs_baseline);
+	in.get(this->ER);
+	in.get(this->ER_baseline);
+	in.get(this->EP);
+	in.get(this->EP_baseline);
+	in.get(this->totalRunTime);
+	in.get(this->totalRunTime_baseline);
+	in.get(this->opLength);
+	in.get(this->opLength_baseline);
+	in.get(this->offLength);
+	in.get(this->offLength_baseline);
+	in.get(this->overProvision);
+	in.get(this->overProvisionBaseline);
+	in.get(this->prevDepart);
+	in.get(this->prevDepart_baseline);
+	in.get(this->latencies);
+	in.get(this->latenciesBaseline);
+	this->multiCore.restore(in);
+	this->multiCoreBaseline.restore(in);
+	in.get(this->residency);
+	in.get(this->residencyBaseline);
+
+	int lastBest;
+	in.get(lastBest);
+	vector<PolicyResult> results;
+	in.get(results);
+	if (results.size() != this->allPolicy.size() || lastBest < 0 || lastBest >= this->allPolicy.size()){
+		cerr << "Checkpoint " << fileName << " has " << results.size() << " policies, this server has " << this->allPolicy.size() << "!" << endl;
+		terminate();
+	}
+	this->lastBestPolicy = this->allPolicy.at(lastBest);
+	for (int i = 0; i < results.size(); i++){
+		this->allPolicy.at(i)->ER = results.at(i).ER;
+		this->allPolicy.at(i)->EP = results.at(i).EP;
+		this->allPolicy.at(i)->overTarget = results.at(i).overTarget;
+	}
+	in.get(this->bestFreqUsed);
+	in.get(this->bestLowpowerUsed);
+	in.get(this->bestCoresUsed);
+	in.get(this->p50Used);
+	in.get(this->p95Used);
+	in.get(this->p99Used);
+
+	in.get(this->forceSearch);
+	in.get(this->searchDisagreements);
+	in.get(this->reusedSweeps);
+	in.get(this->noOfSleepScale);
+	in.get(this->incrementalDisagreements);
+	in.get(this->incrementalMaxError);
+	in.get(this->tableRefreshMinute);
+	in.get(this->noOfTableLookups);
+	in.get(this->noOfTableRefreshes);
+	vector<PolicyTableEntry> entries;
+	in.get(entries);
+	for (int i = 0; this->policyTable != nullptr && i < entries.size(); i++){
+		this->policyTable->setEntry(i, entries.at(i));
+	}
+
+	in.get(this->jobQueue);
+	this->jobLog.restore(in);
+	this->estimator->restore(in);
+
+	// Skip what was read of the trace
+	long lineNo;
+	double rho;
+	in.get(lineNo);
+	while (this->rhoIn->getLineNo() < lineNo && this->rhoIn->next(rho));
+#ifdef DO_OFFLINE
+	in.get(lineNo);
+	while (this->rhoInOffline->getLineNo() < lineNo && this->rhoInOffline->next(rho));
+#endif
+
+	uint64_t metricsBytes;
+	in.get(metricsBytes);
+	if (!this->config.metrics.empty()){
+		this->metrics = make_shared<MetricsWriter>(this->config.metrics, metricsBytes);
+	}
+
+	// Drop what the stopped run logged after the checkpoint, and what this run logged before reading it
+	uint64_t logBytes;
+	in.get(logBytes);
+	this->logOut.resumeAt(logBytes);
+
+	LOG_TO(this->logOut, LOG_SUMMARY) << "[CHECKPOINT] Resumed from " << fileName << " at minute # " << this->minute << ", line " << 
+		this->rhoIn->getLineNo() << " of the trace, seed " << this->config.seed;
 }
 
 void Server::showReport(){
-	this->logOut << endl;
-	this->logOut << "==========================SleepScale Summary============================" << endl;
-	this->logOut << "Total number of jobs simulated: " << this->totalNoOfJobs << endl;
-	this->logOut << "Total running time: " << this->totalRunTime << " ms" << endl;
-	this->logOut << "Total operation time: " << this->opLength << " ms" << endl;
-	this->logOut << "Total idle time: " << this->offLength << " ms" << endl;
-	this->logOut << "Average power consumption: " << this->EP / this->totalRunTime << " Watt" << endl;
-	this->logOut << "Average response time: " << this->ER / this->totalNoOfJobs << " ms" << endl;
-
-	this->logOut << endl;
-	this->logOut << "==========================Baseline Summary============================" << endl;
-	this->logOut << "Total number of jobs simulated: " << this->totalNoOfJobs_baseline << endl;
-	this->logOut << "Total running time: " << this->totalRunTime_baseline << " ms" << endl;
-	this->logOut << "Total operation time: " << this->opLength_baseline << " ms" << endl;
-	this->logOut << "Total idle time: " << this->offLength_baseline << " ms" << endl;
-	this->logOut << "Average power consumption: " << this->EP_baseline / this->totalRunTime_baseline << " Watt" << endl;
-	this->logOut << "Average response time: " << this->ER_baseline / this->totalNoOfJobs_baseline << " ms" << endl;
-
-	this->logOut << endl;
-
-	this->logOut << "Best policies used are:" << endl;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "==========================SleepScale Summary============================";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total number of jobs simulated: " << this->totalNoOfJobs;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total running time: " << this->totalRunTime << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total operation time: " << this->opLength << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total idle time: " << this->offLength << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Average power consumption: " << this->EP / this->totalRunTime << " Watt";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Average response time: " << this->ER / this->totalNoOfJobs << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Response time percentiles: p50 " << this->latencies.percentile(50) << ", p95 " << this->latencies.percentile(95) << 
+		", p99 " << this->latencies.percentile(99) << ", max " << this->latencies.max() << " ms";
+
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "==========================Baseline Summary============================";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total number of jobs simulated: " << this->totalNoOfJobs_baseline;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total running time: " << this->totalRunTime_baseline << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total operation time: " << this->opLength_baseline << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Total idle time: " << this->offLength_baseline << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Average power consumption: " << this->EP_baseline / this->totalRunTime_baseline << " Watt";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Average response time: " << this->ER_baseline / this->totalNoOfJobs_baseline << " ms";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Response time percentiles: p50 " << this->latenciesBaseline.percentile(50) << ", p95 " << 
+		this->latenciesBaseline.percentile(95) << ", p99 " << this->latenciesBaseline.percentile(99) << ", max " << this->latenciesBaseline.max() << " ms";
+
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+
+#ifdef SLEEPSCALE_SEARCH_VERIFY
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Minutes where the policy search disagreed with the exhaustive sweep: " << this->searchDisagreements;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+#endif
+
+#ifdef SLEEPSCALE_INCREMENTAL
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Incremental sweeps: " << this->incremental->reused << " updated, " << this->incremental->rebuilt << 
+		" rebuilt, " << this->incremental->jobsSimulated << " jobs simulated over all policies, " << this->incremental->pruned << 
+		" policy simulations skipped by the work bound";
+#ifdef SLEEPSCALE_INCREMENTAL_VERIFY
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Minutes where the incremental sweep disagreed with the full sweep: " << this->incrementalDisagreements << 
+		". Largest relative difference in ER or EP: " << this->incrementalMaxError;
+#endif
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+#endif
+
+	if (this->policyTable != nullptr){
+		LOG_TO(this->logOut, LOG_SUMMARY) << "Policy table: " << this->noOfTableLookups << " lookups, " << this->noOfTableRefreshes << 
+			" entries refreshed from the job log";
+		LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	}
+
+	if (this->config.cores > 1){
+		for (auto sums : { &this->residency, &this->residencyBaseline }){
+			double coreTime = sums->length * this->config.cores;
+			LOG_TO(this->logOut, LOG_SUMMARY) << (sums == &this->residency ? "SleepScale" : "Baseline") << " core residency: " << 
+				100 * sums->busy / coreTime << "% busy, " << 100 * sums->idle / coreTime << "% idle, " << 100 * sums->parked / coreTime << 
+				"% parked. Package: " << 100 * sums->allIdle / sums->length << "% idle, " << 100 * sums->packageSleep / sums->length << "% in its C-state";
+		}
+		LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	}
+
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Best policies used are:";
 	for (int i = 0; i < this->bestFreqUsed.size(); i++){
-		this->logOut << this->bestFreqUsed.at(i) << ", " << this->bestLowpowerUsed.at(i) << endl;
+		if (this->config.cores > 1){
+			LOG_TO(this->logOut, LOG_SUMMARY) << this->bestFreqUsed.at(i) << ", " << this->bestLowpowerUsed.at(i) << ", " << this->bestCoresUsed.at(i) << " cores";
+		}
+		else {
+			LOG_TO(this->logOut, LOG_SUMMARY) << this->bestFreqUsed.at(i) << ", " << this->bestLowpowerUsed.at(i);
+		}
+	}
+
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Response time percentiles per minute (p50, p95, p99), ms:";
+	for (int i = 0; i < this->p50Used.size(); i++){
+		LOG_TO(this->logOut, LOG_SUMMARY) << this->p50Used.at(i) << ", " << this->p95Used.at(i) << ", " << this->p99Used.at(i);
 	}
 
-	this->logOut << endl;
-	this->logOut << "The estimation abs error is: " << this->estimator->estErrorAbs / this->estimator->noOfObserved << endl;
-	this->logOut << "The estimation perc error is: " << this->estimator->estErrorPerc / this->estimator->noOfObserved << endl;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "";
+	LOG_TO(this->logOut, LOG_SUMMARY) << "The estimation abs error is: " << this->estimator->estErrorAbs / this->estimator->noOfObserved;
+	LOG_TO(this->logOut, LOG_SUMMARY) << "The estimation perc error is: " << this->estimator->estErrorPerc / this->estimator->noOfObserved;
 
 	cout << "The estimation abs error is: " << this->estimator->estErrorAbs / this->estimator->noOfObserved << endl;
 	cout << "The estimation perc error is: " << this->estimator->estErrorPerc / this->estimator->noOfObserved << endl;
+
+#ifdef EST_ENSEMBLE
+	LOG_TO(this->logOut, LOG_SUMMARY) << "Minutes the ensemble estimated with each predictor:";
+	for (int p = 0; p < NO_OF_PREDICTORS; p++){
+		LOG_TO(this->logOut, LOG_SUMMARY) << estPredictorName(p) << ": " << this->estimator->picks[p];
+	}
+#endif
+
+#ifdef PROFILE_PHASES
+	this->profile.report(this->logOut);
+#endif
 }
 
 
 /*
 This function generates a stream of jobs under a particular utilization newRho using BigHouse cdf input. 
-The cdf files must be in BigHouse format. The parameter offset specifies in which minute the jobs are generated
+The distributions are built once from the BigHouse cdf files. The parameter offset specifies in which minute the jobs are generated
 thus their arrivals are within that minute. 
 */
-void Server::generateWorkloadCDF(const vector<double> &ser_prob, const vector<double> &ser_sample, const vector<double> &arr_prob, const vector<double> &arr_sample, const int &offset, const double &newRho){
-	this->logOut << "[GEN_CDF] Generating workload from CDFs." << endl;
+void Server::generateWorkloadCDF(const EmpiricalDistribution &serDist, const EmpiricalDistribution &arrDist, const int &offset, const double &newRho){
+	LOG_TO(this->logOut, LOG_DEBUG) << "[GEN_CDF] Generating workload from CDFs.";
+
+	vector<Job> newJobs;
+	{
+		PROFILE_PHASE(this->profile, PHASE_GENERATE);
+		drawWorkloadCDF(serDist, arrDist, offset, newRho * this->config.cores, this->config.seed, newJobs); // The trace gives the utilization per core
+	}
+	this->addWorkload(newJobs);
+}
+
+/*
+The jobs of the current minute arrive: queue them for the server, push them into the job log that SleepScale is going to simulate on, 
+and move the clock to the next minute. 
+*/
+void Server::addWorkload(const vector<Job> &newJobs){
+
+	PROFILE_PHASE(this->profile, PHASE_ADD_WORKLOAD);
+
+	double localSumService = 0;
+	double localSumInterArrival = 0;
+	for (auto &job : newJobs){
+		localSumService = localSumService + job.service;
+		localSumInterArrival = localSumInterArrival + job.gapFromPrevious;
+	}
+	double totalJobCreated = newJobs.size();
+
+	this->jobQueue.insert(this->jobQueue.end(), newJobs.begin(), newJobs.end());
+	this->jobLog.insertNewJobVector(newJobs, 0, newJobs.size());
+
+	LOG_TO(this->logOut, LOG_INFO) << "[GEN_CDF] Workload generated successfully! Total number of jobs generated: " << totalJobCreated <<
+		". Empirical utilization for this minute is " << localSumService / localSumInterArrival << ". Mean service time is " <<
+		localSumService / totalJobCreated;
+
+	++this->minute;
+}
+
+/*
+Draw the jobs of minute offset under utilization newRho from the CDFs and append them to jobStream. The random numbers come from the 
+streams of (seed, offset), so the jobs of a minute do not depend on any other minute. 
+*/
+void drawWorkloadCDF(const EmpiricalDistribution &serDist, const EmpiricalDistribution &arrDist, const int &offset, const double &newRho, 
+	const uint64_t seed, vector<Job> &jobStream){
 
 	// Do inverse transform sampling
-	random_device rd; // Random seed
-	default_random_engine eng(rd()); // Random engine
-	uniform_real_distribution<double> genUniform(0.0, 1.0); // Generate uniform distribution
+	RandomStream serStream(seed, offset, STREAM_SERVICE);
+	RandomStream arrStream(seed, offset, STREAM_ARRIVAL);
 
-	double newServiceProb = 0; // A sample from the uniform distribution
-	double newInterArrivalProb = 0; // A sample from the uniform distribution
 	double newService; // A sample from service time CDF
 	double newInterArrival; // A sample from inter-arrival time CDF
 	double localSumService = 0; // Keep track of the sum of service times. 
 	double localSumInterArrival = 0; // Keep track of the arrival time. 
-	double totalJobCreated = 0;
 
-	vector<double> newServiceVector;
-	vector<double> newInterArrVector;
+	const int noOfPilotJobs = 200;
+	double newServiceVector[noOfPilotJobs];
+	double newInterArrVector[noOfPilotJobs];
 
 	// First generate 200 jobs to estimate the empirical utilization
-	// This part is done repeatedly -- bad. 
-	for (int i = 0; i < 200; i++){
-		newServiceProb = genUniform(eng); // Sample uniform distribution
-		newInterArrivalProb = genUniform(eng);
+	serDist.drawBatch(serStream, newServiceVector, noOfPilotJobs, CDF_SAMPLER);
+	arrDist.drawBatch(arrStream, newInterArrVector, noOfPilotJobs, CDF_SAMPLER);
 
-		/*
-		Finding the corresponding value via look-up is done in linear way. It should be done in binary search. 
-		*/
-		// Then find the corresponding service time value via lookup
-		for (unsigned int i = 0; i < ser_prob.size() && ser_prob.at(i) < newServiceProb; i++) {
-			int j = min(i + 1, ser_sample.size() - 1);
-			newService = (ser_sample.at(i) + ser_sample.at(j)) / 2;
-		}
-		localSumService = localSumService + newService;
-		newServiceVector.push_back(newService);
-
-		// Then find the corresponding inter-arrival time value via lookup
-		for (unsigned int i = 0; i < arr_prob.size() && arr_prob.at(i) < newInterArrivalProb; i++) {
-			int j = min(i + 1, ser_sample.size() - 1);
-			newInterArrival = (arr_sample.at(i) + arr_sample.at(j)) / 2;
-		}
-
-		localSumInterArrival = localSumInterArrival + newInterArrival;
-		newInterArrVector.push_back(newInterArrival);
+	for (int i = 0; i < noOfPilotJobs; i++){
+		localSumService = localSumService + newServiceVector[i];
+		localSumInterArrival = localSumInterArrival + newInterArrVector[i];
 	}
 
 	// Compute empirical utilization and the scale
@@ -266,69 +629,33 @@ void Server::generateWorkloadCDF(const vector<double> &ser_prob, const vector<do
 
 	// Now for these jobs, push back into the jobStream with the scale until this minute is filled up
 	localSumInterArrival = 0; // Reset
-	localSumService = 0; // Reset
 	int i = 0;
 
-	while (i < newInterArrVector.size() && localSumInterArrival + newInterArrVector.at(i) * scale < 60 * 1000){
-		totalJobCreated++;
-		Job newJob(offset * 60 * 1000 + localSumInterArrival + newInterArrVector.at(i) * scale, newServiceVector.at(i), newInterArrVector.at(i) * scale, newRho); // Has to enforce offset minute
-		this->jobQueue.push_back(newJob); // Push into job queue that server is going to run on.
-		this->jobLog.insertNewJob(newJob); // Push into job log that SleepScale is going to simulate on.
-		localSumService = localSumService + newServiceVector.at(i);
-		localSumInterArrival = localSumInterArrival + newInterArrVector.at(i) * scale;
+	while (i < noOfPilotJobs && localSumInterArrival + newInterArrVector[i] * scale < 60 * 1000){
+		Job newJob(offset * 60 * 1000 + localSumInterArrival + newInterArrVector[i] * scale, newServiceVector[i], newInterArrVector[i] * scale, newRho); // Has to enforce offset minute
+		jobStream.push_back(newJob);
+		localSumInterArrival = localSumInterArrival + newInterArrVector[i] * scale;
 		i++;
 	}
 
 	// If this minute is not filled up. Generate more jobs
-	newServiceProb = genUniform(eng); // Sample uniform distribution
-	newInterArrivalProb = genUniform(eng);
-
-	// This is lazy! Should do a binary search!
-	for (unsigned int i = 0; i < ser_prob.size() && ser_prob.at(i) < newServiceProb; i++) {
-		int j = min(i + 1, ser_sample.size() - 1);
-		newService = (ser_sample.at(i) + ser_sample.at(j)) / 2;
-	}
-
-	for (unsigned int i = 0; i < arr_prob.size() && arr_prob.at(i) < newInterArrivalProb; i++) {
-		int j = min(i + 1, arr_sample.size() - 1);
-		newInterArrival = (arr_sample.at(i) + arr_sample.at(j)) / 2;
-	}
+	newService = serDist.draw(serStream, CDF_SAMPLER);
+	newInterArrival = arrDist.draw(arrStream, CDF_SAMPLER);
 
 	while (localSumInterArrival + newInterArrival * scale < 60 * 1000){
-		
-		totalJobCreated++;
 		Job newJob(offset * 60 * 1000 + localSumInterArrival + newInterArrival * scale, newService, newInterArrival * scale, newRho); // Has to enforce offset minute
-		this->jobQueue.push_back(newJob);
-		this->jobLog.insertNewJob(newJob);
+		jobStream.push_back(newJob);
 		localSumInterArrival = localSumInterArrival + newInterArrival * scale;
-		localSumService = localSumService + newService;
-
-		newServiceProb = genUniform(eng); // Sample uniform distribution
-		newInterArrivalProb = genUniform(eng); 
-
-		// This is lazy! Should do a binary search!
-		for (unsigned int i = 0; i < ser_prob.size() && ser_prob.at(i) < newServiceProb; i++) {
-			int j = min(i + 1, ser_sample.size() - 1);
-			newService = (ser_sample.at(i) + ser_sample.at(j)) / 2;
-		}
-
-		for (unsigned int i = 0; i < arr_prob.size() && arr_prob.at(i) < newInterArrivalProb; i++) {
-			int j = min(i + 1, arr_sample.size() - 1);
-			newInterArrival = (arr_sample.at(i) + arr_sample.at(j)) / 2;
-		}
 
+		newService = serDist.draw(serStream, CDF_SAMPLER);
+		newInterArrival = arrDist.draw(arrStream, CDF_SAMPLER);
 	}
 
-
-	this->logOut << "[GEN_CDF] Workload generated successfully! Total number of jobs generated: " << totalJobCreated <<
-		". Empirical utilization for this minute is " << localSumService / localSumInterArrival << ". Mean service time is " <<
-		localSumService / totalJobCreated << endl;
-
 }
 
 
-// M/M/1 workload generator to generate a stream of jobs. 
-void generateWorkloadMM1(const double serviceTime, const double utilization, vector<Job> &jobStream){
+// M/M/1 workload generator to generate a stream of jobs. The random numbers come from the M/M/1 streams of (seed, minute). 
+void generateWorkloadMM1(const double serviceTime, const double utilization, const uint64_t seed, const int minute, vector<Job> &jobStream){
 	
 	// this->logOut << "[GEN_MM1] Generating M/M/1 workload..." << endl;
 
@@ -338,15 +665,15 @@ void generateWorkloadMM1(const double serviceTime, const double utilization, vec
 	double arrTime = 0;
 	const int noOfJobs = JOB_LOG_LENGTH;
 
-	random_device rd; // Random seed
-	default_random_engine eng(rd()); // Random engine
-
-	exponential_distribution<double> distriSer(1.0 / serviceTime); // Service time distribution
-	exponential_distribution<double> distriArr(1.0 / interArrival); // Arrival time interval distribution
+	// Exponential samples by inversion of uniforms in [0, 1)
+	vector<double> uniformSer(noOfJobs);
+	vector<double> uniformArr(noOfJobs);
+	RandomStream(seed, minute, STREAM_MM1_SERVICE).uniform(uniformSer.data(), noOfJobs);
+	RandomStream(seed, minute, STREAM_MM1_ARRIVAL).uniform(uniformArr.data(), noOfJobs);
 
 	for (int i = 0; i < noOfJobs; i++){
-		newService = distriSer(eng);
-		newArrival = distriArr(eng); // Draw an arrival time interval sample
+		newService = -serviceTime * log(1 - uniformSer.at(i));
+		newArrival = -interArrival * log(1 - uniformArr.at(i)); // Draw an arrival time interval sample
 		arrTime = arrTime + newArrival; // Actual arrival time
 
 		Job newJob(arrTime, newService, newArrival, utilization);
@@ -406,298 +733,267 @@ void Server::simQueue(const shared_ptr<PowerState> policy, const vector<Job> &jo
 #ifdef DO_SLEEPSCALE
 
 /* 
-The function doSleepScale will call for every policy. The jobStream is starting from time 0. 
+The function doSleepScale will call for every policy. The jobStream is starting from time 0. It only reads the server and the policy, 
+so several policies can be simulated at the same time as long as each has its own result slot. 
 */
-void Server::simQueue(const shared_ptr<PowerState> policy, const vector<Job> &jobStream){
+void Server::simQueue(const shared_ptr<PowerState> policy, const JobStreamView &jobStream, PolicyResult &result) const{
 
-	// Have to reset policy
-	policy->ER = 0;
-	policy->EP = 0;
+	PROFILE_PHASE(this->profile, PHASE_SIMULATE);
 
-	double opLength = 0;
-	double offLength = 0;
-
-	double prevDepart = 0;
-
-	int noOfJobs = jobStream.size();
+	int noOfJobs = jobStream.noOfJobs;
+	JobArrays jobs = { jobStream.arrival, jobStream.service };
 
 	assert(noOfJobs == JOB_LOG_LENGTH);
 
-	prevDepart = jobStream.at(0).arrival + jobStream.at(0).service / policy->freq;
-	policy->ER = prevDepart - jobStream.at(0).arrival;
-	opLength = opLength + prevDepart - jobStream.at(0).arrival;
-	offLength = offLength + jobStream.at(0).arrival;
+	QueueTotals totals;
+	totals.target = this->config.serTime * this->config.slowdown;
+	fcfsStart(jobs, policy->freq, totals);
+	fcfsQueue(jobs, 1, noOfJobs, policy->freq, policy->wakeUp, true, totals);
 
-	for (int job = 1; job < noOfJobs; job++){
-		if (jobStream.at(job).arrival <= prevDepart){
-			opLength = opLength + jobStream.at(job).service / policy->freq;
-			prevDepart = prevDepart + jobStream.at(job).service / policy->freq;
-			policy->ER = policy->ER + prevDepart - jobStream.at(job).arrival;
-		}
-		else {
-			offLength = offLength + jobStream.at(job).arrival - prevDepart;
-			opLength = opLength + jobStream.at(job).service / policy->freq + policy->wakeUp;
-			prevDepart = jobStream.at(job).arrival + jobStream.at(job).service / policy->freq + policy->wakeUp;
-			policy->ER = policy->ER + prevDepart - jobStream.at(job).arrival;
-		}
-	}
-
-	double totalLength = opLength + offLength; // Total operation length
-	policy->EP = (opLength * policy->actPwr + offLength * policy->idlePwr) / totalLength; // Power consumption of this policy
-	policy->ER = policy->ER / noOfJobs; // Response time of this policy
+	double totalLength = totals.opLength + totals.offLength; // Total operation length
+	result.EP = policy->energy(totals.opLength, totals.offLength, totals.wakeUps) / totalLength; // Power consumption of this policy
+	result.ER = totals.ER / noOfJobs; // Response time of this policy
+	result.overTarget = totals.overTarget / noOfJobs;
 
 	return;
 }
 
-#endif
-
 /*
-This is where the server actually "runs" the jobs using policy selected by SleepScale. 
+Simulate a policy on the cores of a multi-core server (MultiCore.h), starting from idle cores at time 0. 
 */
-void Server::doQueue(const shared_ptr<PowerState> policy, const vector<Job> &jobStream){
+void Server::simMultiCore(const shared_ptr<PowerState> policy, const JobStreamView &jobStream, PolicyResult &result) const{
 
-	double freq = 0;
-	freq = policy->freq;
+	PROFILE_PHASE(this->profile, PHASE_SIMULATE);
 
-#ifdef DO_OVER_PROV
-	if (this->overProvision = true){
-		freq = min(policy->freq * (1 + OVER_PROV_AMOUNT), 1.0);
-		this->overProvision = false;
-	}
-#endif // DO_OVER_PROV
+	int noOfJobs = jobStream.noOfJobs;
+	JobArrays jobs = { jobStream.arrival, jobStream.service };
+	double packageWakeUp = this->powerModel->packageSleeps(policy->idleState) ? this->powerModel->packageWakeUpLatency() : -1;
 
+	MultiCoreQueue queue(policy->cores, this->config.coreQueue);
+	MultiCoreTotals totals;
+	totals.target = this->config.serTime * this->config.slowdown;
+	queue.run(jobs, 0, noOfJobs, policy->freq, policy->wakeUp, packageWakeUp, totals);
 
-	this->logOut << "[DO_QUEUE] Running workload using frequency " << freq << " and low-power state " << policy->idle << endl;
-	this->bestFreqUsed.push_back(freq);
-	this->bestLowpowerUsed.push_back(policy->idle);
+	double totalLength = totals.end - totals.start; // Total operation length
+	result.EP = multiCoreEnergy(*this->powerModel, *policy, policy->freq, this->config.cores, totals) / totalLength; // Power consumption of this policy
+	result.ER = totals.ER / noOfJobs; // Response time of this policy
+	result.overTarget = totals.overTarget / noOfJobs;
+}
 
+#endif
 
-	double curER = 0;
-	double opLength = 0;
-	double offLength = 0;
+/*
+Simulate the policies allPolicy[first, first + count) on a job stream with the multi-frequency kernel. 
+All policies of a block share an idle state, so only their frequencies differ. Results go to sweepResults and match simQueue exactly. 
+*/
+void Server::simQueueBlock(const pair<int, int> &block, const JobStreamView &jobStream){
 
-	int noOfJobs = jobStream.size();
+	PROFILE_PHASE(this->profile, PHASE_SIMULATE);
 
+	double freq[SWEEP_BLOCK];
+	double ER[SWEEP_BLOCK];
+	double opLength[SWEEP_BLOCK];
+	double offLength[SWEEP_BLOCK];
+	double wakeUps[SWEEP_BLOCK];
 
-	if (this->prevDepart < 0){
-		// Job hasn't arrived yet. System just up.
-		assert(this->totalNoOfJobs == 0 && this->prevDepart == -1);
-
-		this->prevDepart = jobStream.at(0).arrival + jobStream.at(0).service / freq;
-		this->ER = this->prevDepart - jobStream.at(0).arrival;
-		curER = this->prevDepart - jobStream.at(0).arrival;
-		opLength = opLength + this->prevDepart - jobStream.at(0).arrival;
-		offLength = offLength + jobStream.at(0).arrival;
-
-		for (int job = 1; job < noOfJobs; job++){
-			if (jobStream.at(job).arrival <= this->prevDepart){
-				opLength = opLength + jobStream.at(job).service / freq;
-				this->prevDepart = this->prevDepart + jobStream.at(job).service / freq;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart - jobStream.at(job).arrival;
-				}
-#else // CUT_THE_FIRST_120_MINS
-				this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart - jobStream.at(job).arrival;
-#endif // CUT_THE_FIRST_120_MINS
-			}
-			else {
-				offLength = offLength + jobStream.at(job).arrival - this->prevDepart;
-				opLength = opLength + jobStream.at(job).service / freq + policy->wakeUp;
-				this->prevDepart = jobStream.at(job).arrival + jobStream.at(job).service / freq + policy->wakeUp;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart - jobStream.at(job).arrival;
-				}
-#else // CUT_THE_FIRST_120_MINS
-				this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart - jobStream.at(job).arrival;
-#endif // CUT_THE_FIRST_120_MINS
+	int first = block.first;
+	int count = block.second;
+	assert(count <= SWEEP_BLOCK);
 
-			}
-		}
+	for (int l = 0; l < count; l++){
+		freq[l] = this->allPolicy.at(first + l)->freq;
+	}
 
+	// Wake-ups are only counted if they cost energy
+	const PowerState &state = *this->allPolicy.at(first);
+	bool countWakeUps = state.wakeEnergy != 0;
+	if (!countWakeUps){
+		fill(wakeUps, wakeUps + count, 0.0);
+	}
 
+	// Jobs over the response time target are only counted for a percentile target
+	double overTarget[SWEEP_BLOCK];
+	bool countOverTarget = this->config.sloPercentile > 0;
+	if (!countOverTarget){
+		fill(overTarget, overTarget + count, 0.0);
 	}
-	else{
-		// FCFS dynamics
 
-		this->logOut << "[DO_QUEUE] Previous departure time is " << this->prevDepart << endl;
-		this->logOut << "[DO_QUEUE] Arrival is " << jobStream.at(0).arrival << endl;
-
-		for (int job = 0; job < noOfJobs; job++){
-			if (jobStream.at(job).arrival <= this->prevDepart){
-				opLength = opLength + jobStream.at(job).service / freq;
-				this->prevDepart = this->prevDepart + jobStream.at(job).service / freq;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart - jobStream.at(job).arrival;
-				}
-#else // CUT_THE_FIRST_120_MINS
-				this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart - jobStream.at(job).arrival;
-#endif // CUT_THE_FIRST_120_MINS
-			}
-			else {
-				offLength = offLength + jobStream.at(job).arrival - this->prevDepart;
-				opLength = opLength + jobStream.at(job).service / freq + policy->wakeUp;
-				this->prevDepart = jobStream.at(job).arrival + jobStream.at(job).service / freq + policy->wakeUp;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart - jobStream.at(job).arrival;
-				}
-#else // CUT_THE_FIRST_120_MINS
-				this->ER = this->ER + this->prevDepart - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart - jobStream.at(job).arrival;
-#endif // CUT_THE_FIRST_120_MINS
+	int noOfJobs = jobStream.noOfJobs;
+	simQueueMultiFreq(jobStream.arrival, jobStream.service, noOfJobs, freq, count, state.wakeUp, ER, opLength, offLength, 
+		countWakeUps ? wakeUps : nullptr, this->config.serTime * this->config.slowdown, countOverTarget ? overTarget : nullptr);
+
+	for (int l = 0; l < count; l++){
+		const shared_ptr<PowerState> policy = this->allPolicy.at(first + l);
+		PolicyResult &result = this->sweepResults.at(first + l);
+		double totalLength = opLength[l] + offLength[l]; // Total operation length
+		result.EP = policy->energy(opLength[l], offLength[l], wakeUps[l]) / totalLength; // Power consumption of this policy
+		result.ER = ER[l] / noOfJobs; // Response time of this policy
+		result.overTarget = overTarget[l] / noOfJobs;
+	}
+}
 
-			}
+/*
+This is where the server actually "runs" the jobs using policy selected by SleepScale. 
+*/
+void Server::doQueue(const shared_ptr<PowerState> policy, const vector<Job> &jobStream){
+
+	PROFILE_PHASE(this->profile, PHASE_DO_QUEUE);
 
+	double freq = 0;
+	freq = policy->freq;
+
+	if (this->config.overProvision){
+		if (this->overProvision = true){
+			freq = min(policy->freq * (1 + this->config.overProvAmount), 1.0);
+			this->overProvision = false;
 		}
 	}
 
-	this->logOut << "[DO_QUEUE] The last job's departure time is " << this->prevDepart << endl;
 
-#ifdef CUT_THE_FIRST_120_MINS
-	if (this->minute > 120){
-		this->totalRunTime = this->totalRunTime + opLength + offLength; // Total operation length
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE] Running workload using frequency " << freq << " and low-power state " << policy->idle;
+	this->bestFreqUsed.push_back(freq);
+	this->bestLowpowerUsed.push_back(policy->idle);
+	this->bestCoresUsed.push_back(policy->cores);
 
-#ifndef DO_OVER_PROV
-		this->EP = this->EP + (opLength * policy->actPwr + offLength * policy->idlePwr); // Power consumption of this policy
-#else // DO_OVER_PROV
-		// Have to recompute the power numbers if over-provisioning is used.
 
-		double actPwr = CORE_ACT_MAX_PWR * freq * freq * freq + PLAT_ACT_MAX_PWR;
-		string idle = policy->idle;
-		double idlePwr;
-		if (idle.compare("C0i") == 0){
-			idlePwr = 75 * freq * freq * freq + PLAT_IDLE_PWR;
-		}
-		else if (idle.compare("C1") == 0){
-			idlePwr = 47 * freq * freq + PLAT_IDLE_PWR;
+	int noOfJobs = jobStream.size();
+	bool counted = this->minute > this->config.warmUp; // Minutes of the warm-up are run but not counted
+
+	if (this->prevDepart >= 0){
+		// FCFS dynamics
+
+		LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE] Previous departure time is " << this->prevDepart;
+		LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE] Arrival is " << jobStream.at(0).arrival;
+	}
+	else {
+		assert(this->totalNoOfJobs == 0);
+	}
+
+	this->minuteLatencies.clear();
+	double curER, opLength, offLength, energy;
+	if (this->config.cores > 1){
+		MultiCoreTotals run; // Sums of this run
+		runMultiCore(*policy, freq, jobStream, this->multiCore, run, this->minuteLatencies);
+		this->prevDepart = run.end;
+		if (counted){
+			this->ER = this->ER + run.ER;
+			this->residency.add(run, policy->cores, this->config.cores);
+			this->totalRunTime = this->totalRunTime + run.end - run.start; // Total operation length
 		}
-		else if (idle.compare("C3") == 0){
-			idlePwr = 22 + PLAT_IDLE_PWR;
+		curER = run.ER;
+		opLength = run.busy;
+		offLength = policy->cores * (run.end - run.start) - run.busy;
+		energy = multiCoreEnergy(*this->powerModel, *policy, freq, this->config.cores, run);
+		LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE] The last job's departure time on " << policy->cores << " cores is " << this->prevDepart;
+	}
+	else {
+		QueueTotals run; // Sums of this run
+		if (runQueue(*policy, freq, jobStream, counted, this->prevDepart, run, this->minuteLatencies)){
+			this->ER = run.ER; // System just up. The first job is counted even during the warm-up.
 		}
-		else if (idle.compare("C6") == 0){
-			idlePwr = 15 + PLAT_IDLE_PWR;
+		else if (counted){
+			this->ER = this->ER + run.ER;
 		}
-		else if (idle.compare("DVFS_only") == 0){
-			idlePwr = actPwr;
+		curER = run.ER;
+		opLength = run.opLength;
+		offLength = run.offLength;
+		if (counted){
+			this->totalRunTime = this->totalRunTime + opLength + offLength; // Total operation length
 		}
-		else if (idle.compare("Baseline") == 0){ 
-			// Will not be executed because doQueue will never use "Baseline". 
-			// The baseline must have frequency = 1. 
-			assert(freq == 1);
-
-			/* Always on */
-#ifdef BASE_USE_NO_PWR_CNTRL
-			idlePwr = actPwr;
-#endif
-
-			/* Race to halt using C3 */
-#ifdef BASE_USE_R2H_C3
-			idlePwr = 22 + PLAT_IDLE_PWR;
-#endif
-
-			/* Race to halt using C6 */
-#ifdef BASE_USE_R2H_C6
-			idlePwr = 15 + PLAT_IDLE_PWR;
-#endif
-
 
+		if (!this->config.overProvision){
+			energy = policy->energy(opLength, offLength, run.wakeUps); // Power consumption of this policy
 		}
 		else {
-			cout << "Invalid power state!" << endl;
-			terminate();
+			// Have to recompute the power numbers if over-provisioning is used. doQueue never runs "Baseline", so freq < 1 is fine.
+			energy = opLength * this->powerModel->activePower(freq) + offLength * this->powerModel->idlePower(policy->idleState, freq) + 
+				run.wakeUps * policy->wakeEnergy;
 		}
-		this->EP = this->EP + (opLength * actPwr + offLength * idlePwr);
-#endif // DO_OVER_PROV
+		LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE] The last job's departure time is " << this->prevDepart;
+	}
 
+	if (counted){
+		this->EP = this->EP + energy;
 		this->opLength = this->opLength + opLength;
 		this->offLength = this->offLength + offLength;
 		this->totalNoOfJobs = this->totalNoOfJobs + noOfJobs;
+		this->latencies.merge(this->minuteLatencies);
 	}
 
-#else // CUT_THE_FIRST_120_MINS
-	this->totalNoOfJobs = this->totalNoOfJobs + noOfJobs;
-	this->totalRunTime = this->totalRunTime + opLength + offLength; // Total operation length
+	this->minuteMetrics.noOfJobs = noOfJobs;
+	this->minuteMetrics.ER = counted && noOfJobs > 0 ? curER / noOfJobs : NAN; // Response times of the warm-up are not summed
+	this->minuteMetrics.energy = energy;
+	this->minuteMetrics.busy = opLength;
+	this->minuteMetrics.idle = offLength;
 
-#ifndef DO_OVER_PROV
-	this->EP = this->EP + (opLength * policy->actPwr + offLength * policy->idlePwr); // Power consumption of this policy
-#else // DO_OVER_PROV
-	// Have to recompute the power numbers
-	double actPwr = CORE_ACT_MAX_PWR * freq * freq * freq + PLAT_ACT_MAX_PWR;
-	string idle = policy->idle;
-	double idlePwr;
-	if (idle.compare("C0i") == 0){
-		idlePwr = 75 * freq * freq * freq + PLAT_IDLE_PWR;
-	}
-	else if (idle.compare("C1") == 0){
-		idlePwr = 47 * freq * freq + PLAT_IDLE_PWR;
-	}
-	else if (idle.compare("C3") == 0){
-		idlePwr = 22 + PLAT_IDLE_PWR;
-	}
-	else if (idle.compare("C6") == 0){
-		idlePwr = 15 + PLAT_IDLE_PWR;
-	}
-	else if (idle.compare("DVFS_only") == 0){
-		idlePwr = actPwr;
+	this->p50Used.push_back(this->minuteLatencies.percentile(50));
+	this->p95Used.push_back(this->minuteLatencies.percentile(95));
+	this->p99Used.push_back(this->minuteLatencies.percentile(99));
+
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_QUEUE] Number of jobs ran is " << noOfJobs << ". Total number of jobs ran from minute 0 is " << this->totalNoOfJobs;
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_QUEUE] Average response time so far is: " << this->ER / this->totalNoOfJobs;
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_QUEUE] Response time percentiles this minute: p50 " << this->p50Used.back() << ", p95 " << this->p95Used.back() << 
+		", p99 " << this->p99Used.back();
+
+	if (this->config.overProvision && curER < this->config.slowdown * this->config.serTime){
+		this->overProvision = true;
 	}
-	else if (idle.compare("Baseline") == 0){ // Will not be executed because doQueue will not use "Baseline"
-		// The baseline must have frequency = 1. 
-		assert(freq == 1);
 
-		/* Always on */
-#ifdef BASE_USE_NO_PWR_CNTRL
-		idlePwr = actPwr;
-#endif
+	return;
+}
 
-		/* Race to halt using C3 */
-#ifdef BASE_USE_R2H_C3
-		idlePwr = 22 + PLAT_IDLE_PWR;
-#endif
 
-		/* Race to halt using C6 */
-#ifdef BASE_USE_R2H_C6
-		idlePwr = 15 + PLAT_IDLE_PWR;
-#endif 
+/*
+Run the queued jobs at frequency freq after the departure prevDepart, which is -1 until the server has run a job, and put the sums of 
+the run into totals. Response times are only summed if counted, except for the job that starts the server. Returns true if this run 
+started the server. Every response time, counted or not, is recorded in latencies. Shared by doQueue and doQueueBaseline. 
+*/
+bool Server::runQueue(const PowerState &policy, double freq, const vector<Job> &jobStream, bool counted, double &prevDepart, QueueTotals &totals, 
+	LatencyHistogram &latencies){
 
+	JobRecords jobs = { jobStream.data() };
+	int noOfJobs = jobStream.size();
+	int firstJob = 0; // First job run by the FCFS kernel
 
+	if (prevDepart < 0){
+		// Job hasn't arrived yet. System just up.
+		assert(prevDepart == -1);
+		fcfsStart(jobs, freq, totals, &latencies);
+		firstJob = 1;
 	}
 	else {
-		cout << "Invalid power state!" << endl;
-		terminate();
+		totals.prevDepart = prevDepart;
 	}
-	this->EP = this->EP + (opLength * actPwr + offLength * idlePwr);
-#endif	// DO_OVER_PROV
-	
-	this->opLength = this->opLength + opLength;
-	this->offLength = this->offLength + offLength;
-#endif // CUT_THE_FIRST_120_MINS
-
-	this->logOut << "[DO_QUEUE] Number of jobs ran is " << noOfJobs << ". Total number of jobs ran from minute 0 is " << this->totalNoOfJobs << endl;
-	this->logOut << "[DO_QUEUE] Average response time so far is: " << this->ER / this->totalNoOfJobs << endl;
 
-#ifdef DO_OVER_PROV
-	if (curER < SLEEPSCALE_SLOWDOWN * SER_TIME){
-		this->overProvision = true;
+	if (noOfJobs - firstJob >= PARALLEL_SCAN_MIN_JOBS && this->sweepPool->getSize() > 1){
+		// A very long queue is split over the sweep threads (QueueScan.h)
+		double startER = totals.ER;
+		simQueueScan(jobStream.data() + firstJob, noOfJobs - firstJob, freq, policy.wakeUp, *this->sweepPool, totals, &latencies);
+		if (!counted){
+			totals.ER = startER;
+		}
+	}
+	else {
+		fcfsQueue(jobs, firstJob, noOfJobs, freq, policy.wakeUp, counted, totals, &latencies);
 	}
-#endif
 
-	return;
+	prevDepart = totals.prevDepart;
+	return firstJob == 1;
 }
 
+/*
+Run the queued jobs on the active cores of the policy at frequency freq and put the sums of the run into totals. The queue keeps the 
+state of the cores from one run to the next. The response times are recorded in latencies. 
+*/
+void Server::runMultiCore(const PowerState &policy, double freq, const vector<Job> &jobStream, MultiCoreQueue &queue, MultiCoreTotals &totals, 
+	LatencyHistogram &latencies){
+
+	JobRecords jobs = { jobStream.data() };
+	double packageWakeUp = this->powerModel->packageSleeps(policy.idleState) ? this->powerModel->packageWakeUpLatency() : -1;
+
+	queue.setCores(policy.cores);
+	queue.run(jobs, 0, jobStream.size(), freq, policy.wakeUp, packageWakeUp, totals, &latencies);
+}
 
 /*
 This is where the server actually "runs" the jobs using the baseline policy -- maximum frequency. Over-provisioning 
@@ -705,129 +1001,73 @@ does not apply here.
 */
 void Server::doQueueBaseline(const shared_ptr<PowerState> policy, const vector<Job> &jobStream){
 
+	PROFILE_PHASE(this->profile, PHASE_DO_QUEUE_BASELINE);
+
 	double freq = 0;
 	freq = policy->freq;
-#ifdef DO_OVER_PROV
-	if (this->overProvisionBaseline = true){
-		freq = min(policy->freq * (1 + OVER_PROV_AMOUNT), 1.0); // This does nothing...
-		this->overProvisionBaseline = false;
+	if (this->config.overProvision){
+		if (this->overProvisionBaseline = true){
+			freq = min(policy->freq * (1 + this->config.overProvAmount), 1.0); // This does nothing...
+			this->overProvisionBaseline = false;
+		}
 	}
-#endif
-
-	this->logOut << "[DO_QUEUE_BL] Running workload using the baseline policy..." << endl;
 
-	double curER = 0;
-	double opLength = 0;
-	double offLength = 0;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_QUEUE_BL] Running workload using the baseline policy...";
 
 	int noOfJobs = jobStream.size();
+	bool counted = this->minute > this->config.warmUp; // Minutes of the warm-up are run but not counted
 
 	if (this->prevDepart_baseline < 0){
-		// Job hasn't arrived yet
-		assert(this->totalNoOfJobs_baseline == 0 && this->prevDepart_baseline == -1);
-
-		this->prevDepart_baseline = jobStream.at(0).arrival + jobStream.at(0).service / freq;
-		this->ER_baseline = this->prevDepart_baseline - jobStream.at(0).arrival;
-		curER = curER + this->prevDepart_baseline - jobStream.at(0).arrival;
-		opLength = opLength + this->prevDepart_baseline - jobStream.at(0).arrival;
-		offLength = offLength + jobStream.at(0).arrival;
-
-		for (int job = 1; job < noOfJobs; job++){
-			if (jobStream.at(job).arrival <= this->prevDepart_baseline){
-				opLength = opLength + jobStream.at(job).service / freq;
-				this->prevDepart_baseline = this->prevDepart_baseline + jobStream.at(job).service / freq;
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-				}
-
-#else
-				this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-#endif
+		assert(this->totalNoOfJobs_baseline == 0);
+	}
 
-			}
-			else {
-				offLength = offLength + jobStream.at(job).arrival - this->prevDepart_baseline;
-				opLength = opLength + jobStream.at(job).service / freq + policy->wakeUp;
-				this->prevDepart_baseline = jobStream.at(job).arrival + jobStream.at(job).service / freq + policy->wakeUp;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-				}
-#else
-				this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-#endif
-			}
+	this->minuteLatenciesBaseline.clear();
+	double curER, opLength, offLength, energy;
+	if (this->config.cores > 1){
+		MultiCoreTotals run; // Sums of this run
+		runMultiCore(*policy, freq, jobStream, this->multiCoreBaseline, run, this->minuteLatenciesBaseline);
+		this->prevDepart_baseline = run.end;
+		if (counted){
+			this->ER_baseline = this->ER_baseline + run.ER;
+			this->residencyBaseline.add(run, policy->cores, this->config.cores);
+			this->totalRunTime_baseline = this->totalRunTime_baseline + run.end - run.start; // Total operation length
 		}
-
-
+		curER = run.ER;
+		opLength = run.busy;
+		offLength = policy->cores * (run.end - run.start) - run.busy;
+		energy = multiCoreEnergy(*this->powerModel, *policy, freq, this->config.cores, run);
 	}
-	else{
-		// FCFS dynamics
-
-		for (int job = 0; job < noOfJobs; job++){
-			if (jobStream.at(job).arrival <= this->prevDepart_baseline){
-				opLength = opLength + jobStream.at(job).service / freq;
-				this->prevDepart_baseline = this->prevDepart_baseline + jobStream.at(job).service / freq;
-
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-				}
-#else
-				this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-#endif
-			}
-			else {
-				offLength = offLength + jobStream.at(job).arrival - this->prevDepart_baseline;
-				opLength = opLength + jobStream.at(job).service / freq + policy->wakeUp;
-				this->prevDepart_baseline = jobStream.at(job).arrival + jobStream.at(job).service / freq + policy->wakeUp;
-				
-#ifdef CUT_THE_FIRST_120_MINS
-				if (this->minute > 120){
-					this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-					curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-				}
-#else
-				this->ER_baseline = this->ER_baseline + this->prevDepart_baseline - jobStream.at(job).arrival;
-				curER = curER + this->prevDepart_baseline - jobStream.at(job).arrival;
-#endif
-			}
+	else {
+		QueueTotals run; // Sums of this run
+		if (runQueue(*policy, freq, jobStream, counted, this->prevDepart_baseline, run, this->minuteLatenciesBaseline)){
+			this->ER_baseline = run.ER; // System just up. The first job is counted even during the warm-up.
+		}
+		else if (counted){
+			this->ER_baseline = this->ER_baseline + run.ER;
+		}
+		curER = run.ER;
+		opLength = run.opLength;
+		offLength = run.offLength;
+		if (counted){
+			this->totalRunTime_baseline = this->totalRunTime_baseline + opLength + offLength; // Total operation length
 		}
+		energy = policy->energy(opLength, offLength, run.wakeUps); // Power consumption of this policy
 	}
 
-
-#ifdef CUT_THE_FIRST_120_MINS
-	if (this->minute > 120){
-		this->totalRunTime_baseline = this->totalRunTime_baseline + opLength + offLength; // Total operation length
-		this->EP_baseline = this->EP_baseline + (opLength * policy->actPwr + offLength * policy->idlePwr); // Power consumption of this policy
+	if (counted){
+		this->EP_baseline = this->EP_baseline + energy;
 		this->opLength_baseline = this->opLength_baseline + opLength;
 		this->offLength_baseline = this->offLength_baseline + offLength;
 		this->totalNoOfJobs_baseline = this->totalNoOfJobs_baseline + noOfJobs;
+		this->latenciesBaseline.merge(this->minuteLatenciesBaseline);
 	}
-#else
-	this->totalNoOfJobs_baseline = this->totalNoOfJobs_baseline + noOfJobs;
-	this->totalRunTime_baseline = this->totalRunTime_baseline + opLength + offLength; // Total operation length
-	this->EP_baseline = this->EP_baseline + (opLength * policy->actPwr + offLength * policy->idlePwr); // Power consumption of this policy
-	this->opLength_baseline = this->opLength_baseline + opLength;
-	this->offLength_baseline = this->offLength_baseline + offLength;
-#endif
 
-	this->logOut << "[DO_QUEUE_BL] Number of jobs ran is " << noOfJobs << ". Total number of jobs ran from minute 0 is " << this->totalNoOfJobs_baseline << endl;
-	this->logOut << "[DO_QUEUE_BL] Average response time for baseline so far is: " << this->ER_baseline / this->totalNoOfJobs_baseline << endl;
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_QUEUE_BL] Number of jobs ran is " << noOfJobs << ". Total number of jobs ran from minute 0 is " << this->totalNoOfJobs_baseline;
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_QUEUE_BL] Average response time for baseline so far is: " << this->ER_baseline / this->totalNoOfJobs_baseline;
 
-#ifdef DO_OVER_PROV
-	if (curER < SLEEPSCALE_SLOWDOWN * SER_TIME){
+	if (this->config.overProvision && curER < this->config.slowdown * this->config.serTime){
 		this->overProvisionBaseline = true;
 	}
-#endif
 
 
 	return;
@@ -843,12 +1083,12 @@ shared_ptr<PowerState> Server::doSleepScale(){
 
 	shared_ptr<PowerState> bestPolicy;
 
-	this->logOut << "[DO_SLEEPSCALE] Adjusting the arrival times..." << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Adjusting the arrival times...";
 
 	// Adjusting the workload log. 
 
 	double scale = this->jobLog.getUtilization() / this->estimator->est; // Compute the scaling factor
-	this->logOut << "[DO_SLEEPSCALE] Empirical utilization in the log is " << this->jobLog.getUtilization() << ". Scaling factor is " << scale << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Empirical utilization in the log is " << this->jobLog.getUtilization() << ". Scaling factor is " << scale;
 
 	// Treat the past observed job stream as the future job stream, with offset increased by T minutes and utilization properly scaled. 
 	// This means we have to adjust the past observed job stream and store it in a new vector called jobStream
@@ -857,7 +1097,7 @@ shared_ptr<PowerState> Server::doSleepScale(){
 	double offset = this->minute * 60 * 1000 - this->jobLog.getArrAt(0);
 
 	double arrTimeNew = this->jobLog.getArrAt(0) + offset;
-	this->logOut << "[DO_SLEEPSCALE] Job start at " << arrTimeNew << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Job start at " << arrTimeNew;
 	double serTimeNew = this->jobLog.getSerAt(0);
 	Job newJob(arrTimeNew, serTimeNew);
 	jobStream.push_back(newJob);
@@ -875,18 +1115,18 @@ shared_ptr<PowerState> Server::doSleepScale(){
 		jobStream.push_back(newJob);
 	}
 
-	this->logOut << "[DO_SLEEPSCALE] ...Arrival time adjusted! " <<
-		"This new workload for SleepScale has utilization " << serSum / arrSum << " and first job starts at " << jobStream.at(0).arrival << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] ...Arrival time adjusted! " <<
+		"This new workload for SleepScale has utilization " << serSum / arrSum << " and first job starts at " << jobStream.at(0).arrival;
 
 	// Construct the baseline -- maximum speed
-	this->logOut << "[DO_SLEEPSCALE] Running the baseline..." << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Running the baseline...";
 	simQueue(this->allPolicy.at(0), jobStream);
-	this->logOut << "[DO_SLEEPSCALE] ...Baseline successfully constructed!" << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] ...Baseline successfully constructed!";
 
 	// Compute the baseline mean response time, if the system would run at maximum speed. 
 	double curBaselineER = (this->ER_baseline + this->allPolicy.at(0)->ER) / (this->totalNoOfJobs_baseline + jobStream.size());
-	this->logOut << "[DO_SLEEPSCALE] Current baseline ER is " << 
-		curBaselineER << ". Slowdown is " << this->slowDown << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Current baseline ER is " << 
+		curBaselineER << ". Slowdown is " << this->slowDown;
 
 	double curPolicyER = 0;
 	double curPolicyEP = MAX_NUM;
@@ -910,8 +1150,8 @@ shared_ptr<PowerState> Server::doSleepScale(){
 
 
 
-	this->logOut << "[DO_SLEEPSCALE] Best policy has ER: " << (this->ER + bestPolicy->ER) / (this->totalNoOfJobs + jobStream.size()) << endl;
-	this->logOut << "[DO_SLEEPSCALE] ...All policies simulated! SleepScale completes!" << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Best policy has ER: " << (this->ER + bestPolicy->ER) / (this->totalNoOfJobs + jobStream.size());
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] ...All policies simulated! SleepScale completes!";
 
 	return bestPolicy;
 
@@ -924,66 +1164,433 @@ shared_ptr<PowerState> Server::doSleepScale(){
 // All the magic happen here. First do a baseline queue simulation. Then do simulations for all policies.
 shared_ptr<PowerState> Server::doSleepScale(){
 
+	PROFILE_PHASE(this->profile, PHASE_SLEEPSCALE);
 	shared_ptr<PowerState> bestPolicy;
+	JobStreamView jobStream;
+	this->noOfSleepScale++;
+
+	if (this->policyTable != nullptr){
+		bestPolicy = tablePolicy();
+		LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] The best policy is f = " << bestPolicy->freq <<
+			" and low-power state = " << bestPolicy->idle;
+		return bestPolicy;
+	}
+
 #ifdef GEN_MM1 // If job stream simulated has to be perfect M/M/1
-	vector<Job> jobStream;
-	this->logOut << "[DO_SLEEPSCALE] Generating workload in perfect M/M/1 at utilization " << this->estimator->est << endl;
-	generateWorkloadMM1(SER_TIME, this->estimator->est, jobStream);
+	vector<Job> jobsMM1;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Generating workload in perfect M/M/1 at utilization " << this->estimator->est;
+	generateWorkloadMM1(this->config.serTime, this->estimator->est * this->config.cores, this->config.seed, this->minute, jobsMM1);
+
+	this->sweepArrival.resize(jobsMM1.size());
+	this->sweepService.resize(jobsMM1.size());
+	for (int job = 0; job < jobsMM1.size(); job++){
+		this->sweepArrival.at(job) = jobsMM1.at(job).arrival;
+		this->sweepService.at(job) = jobsMM1.at(job).service;
+	}
+	jobStream.arrival = this->sweepArrival.data();
+	jobStream.service = this->sweepService.data();
+	jobStream.noOfJobs = jobsMM1.size();
 
 #else // Adjust the job log such that it starts from time 0 and has utilization this->estimator->est
 
-	this->logOut << "[DO_SLEEPSCALE] Adjusting the arrival times..." << endl;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Adjusting the arrival times...";
 
-	vector<Job> jobStream;
-	double arrTimeNew = 0;
+	double logRho = rescaleJobLog(this->estimator->est * this->config.cores, jobStream); // Jobs of all cores
 
-	double interArrNew = this->jobLog.getInterArrAt(0) * (this->jobLog.getUtilizationAt(0) / this->estimator->est); // Scale the inter-arrival time
-	arrTimeNew = arrTimeNew + interArrNew;
-	double serTimeNew = this->jobLog.getSerAt(0);
-	Job newJob(arrTimeNew, serTimeNew, interArrNew, this->estimator->est);
-	jobStream.push_back(newJob);
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Job log adjusted! " <<
+		"This new workload for SleepScale has utilization " << logRho << " and first job starts at " << jobStream.arrival[0];
+
+#endif
+
+	if (this->config.cores > 1 || this->forceSearch){
+		// Policies on a multi-core server are searched; there are too many to sweep them all
+		bestPolicy = searchPolicies(jobStream);
+	}
+	else {
+#ifdef SLEEPSCALE_SEARCH
+		bestPolicy = searchPolicies(jobStream);
+
+#ifdef SLEEPSCALE_SEARCH_VERIFY
+		shared_ptr<PowerState> searchedPolicy = bestPolicy;
+		bestPolicy = sweepPolicies(jobStream);
+		if (searchedPolicy != bestPolicy){
+			this->searchDisagreements++;
+			LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] Search disagrees with the exhaustive sweep! Search picked f = " << searchedPolicy->freq << " and low-power state = " << 
+				searchedPolicy->idle << " with EP " << searchedPolicy->EP << ", the sweep picked f = " << bestPolicy->freq << " and low-power state = " << 
+				bestPolicy->idle << " with EP " << bestPolicy->EP;
+		}
+#endif // SLEEPSCALE_SEARCH_VERIFY
+
+#else // SLEEPSCALE_SEARCH
+		if (this->sweepLeader != nullptr && this->sweepLeader->sweepMinute == this->minute && this->sweepLeader->sweepEst == this->estimator->est){
+			// The leader already simulated the same policies on the same job stream this minute. Only the choice may differ.
+			LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Reusing the sweep of another server";
+			this->sweepResults = this->sweepLeader->sweepResults;
+			vector<int> candidates;
+			for (int i = 1; i != this->allPolicy.size(); ++i){
+				candidates.push_back(i);
+			}
+			bestPolicy = pickBestPolicy(candidates);
+			this->reusedSweeps++;
+		}
+		else {
+#ifdef SLEEPSCALE_INCREMENTAL
+			// The cached simulations only keep sums, so a percentile target takes the full sweep
+			bestPolicy = this->config.sloPercentile > 0 ? sweepPolicies(jobStream) : incrementalPolicies(jobStream);
+#else
+			bestPolicy = sweepPolicies(jobStream);
+#endif
+		}
+		this->sweepMinute = this->minute;
+		this->sweepEst = this->estimator->est;
+#endif // SLEEPSCALE_SEARCH
+	}
 
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] All policies simulated! SleepScale completes!";
+	LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] The best policy is f = " << bestPolicy->freq <<
+		" and low-power state = " << bestPolicy->idle;
+	if (this->config.cores > 1){
+		LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] The best policy runs " << bestPolicy->cores << " of " << this->config.cores << " cores";
+	}
+
+	return bestPolicy;
+
+}
+
+/*
+Scale the inter-arrival times of the job log such that the log has utilization est, starting from time 0. Only the arrival times change; 
+they go to sweepArrival, and service times are read in place from the job log. 
+*/
+double Server::rescaleJobLog(double est, JobStreamView &jobStream){
+
+	int noOfJobs = this->jobLog.getSize();
+	const double *interArr = this->jobLog.getInterArrivals();
+	const double *rho = this->jobLog.getUtilizations();
+	const double *service = this->jobLog.getServices();
+
+	this->sweepArrival.resize(noOfJobs);
+	double *arrival = this->sweepArrival.data();
+
+	double arrTimeNew = 0;
 	double serSum = 0; // Use to track empirical utilization in the job log.
 
-	for (auto i = 1; i < this->jobLog.getSize(); i++){
+	arrTimeNew = arrTimeNew + interArr[0] * (rho[0] / est); // Scale the inter-arrival time
+	arrival[0] = arrTimeNew;
 
-		interArrNew = this->jobLog.getInterArrAt(i) * (this->jobLog.getUtilizationAt(i) / this->estimator->est);
+	for (int i = 1; i < noOfJobs; i++){
+		arrTimeNew = arrTimeNew + interArr[i] * (rho[i] / est);
+		arrival[i] = arrTimeNew;
+		serSum = serSum + service[i];
+	}
 
-		arrTimeNew = arrTimeNew + interArrNew;
-		serTimeNew = this->jobLog.getSerAt(i);
-		serSum = serSum + serTimeNew;
-		Job newJob(arrTimeNew, serTimeNew, interArrNew, this->estimator->est);
-		jobStream.push_back(newJob);
+	assert(noOfJobs == JOB_LOG_LENGTH);
+
+	jobStream.arrival = arrival;
+	jobStream.service = service;
+	jobStream.noOfJobs = noOfJobs;
+
+	return serSum / arrTimeNew;
+}
+
+/*
+Table lookup (policy_table). The entries around the estimate give a frequency, which is rounded up to the next supported one in their 
+idle state, so the cost per step does not depend on the number of policies. Every policy_table_refresh minutes the entry nearest the 
+estimate is first re-derived from the job log. 
+*/
+shared_ptr<PowerState> Server::tablePolicy(){
+
+	double est = this->estimator->est;
+	if (this->config.policyTableRefresh > 0 && (this->tableRefreshMinute < 0 || this->minute - this->tableRefreshMinute >= this->config.policyTableRefresh)){
+		refreshPolicyTable(this->policyTable->nearest(est));
+		this->tableRefreshMinute = this->minute;
+	}
+
+	PolicyTableEntry entry = this->policyTable->lookup(est);
+	this->noOfTableLookups++;
+
+	// Policies of an idle state are in descending frequency. Keep the slowest one that is not slower than the table.
+	IdleState idleState = parseIdleState(entry.idle);
+	shared_ptr<PowerState> bestPolicy;
+	for (auto &range : this->stateRanges){
+		if (this->allPolicy.at(range.first)->idleState != idleState){
+			continue;
+		}
+		bestPolicy = this->allPolicy.at(range.first);
+		for (int i = range.first; i < range.first + range.second; i++){
+			if (this->allPolicy.at(i)->freq >= entry.freq - 1e-9){
+				bestPolicy = this->allPolicy.at(i);
+			}
+		}
 	}
+	assert(bestPolicy != nullptr); // Idle states are checked when the table is loaded
 
-	assert(jobStream.size() == JOB_LOG_LENGTH);
+	bestPolicy->ER = entry.ER;
+	bestPolicy->EP = entry.EP;
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Policy table gives f = " << entry.freq << " and low-power state = " << string(entry.idle) << 
+		" for utilization " << est << (entry.feasible ? "" : ". No policy meets the target there.");
 
-	this->logOut << "[DO_SLEEPSCALE] Job log adjusted! " <<
-		"This new workload for SleepScale has utilization " << serSum / arrTimeNew << " and first job starts at " << jobStream.at(0).arrival << endl;
+	return bestPolicy;
+}
 
+void Server::refreshPolicyTable(int index){
+
+	PolicyTableEntry entry = this->policyTable->getEntry(index);
+	JobStreamView jobStream;
+	rescaleJobLog(entry.rho, jobStream);
+	shared_ptr<PowerState> bestPolicy = sweepPolicies(jobStream);
+
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Refreshed the policy table at utilization " << entry.rho << ": f = " << entry.freq << 
+		" and low-power state = " << string(entry.idle) << " became f = " << bestPolicy->freq << " and low-power state = " << bestPolicy->idle;
+
+	entry.freq = bestPolicy->freq;
+	entry.EP = bestPolicy->EP;
+	entry.ER = bestPolicy->ER;
+	memset(entry.idle, 0, sizeof(entry.idle));
+	strncpy(entry.idle, bestPolicy->idle.c_str(), sizeof(entry.idle) - 1);
+	entry.feasible = meetsTarget(bestPolicy->ER, bestPolicy->overTarget);
+	entry.refreshed = 1;
+	this->policyTable->setEntry(index, entry);
+	this->noOfTableRefreshes++;
+}
+
+/*
+Exhaustive sweep. Simulate every policy and pick the one with the lowest power that meets the response time target. 
+*/
+shared_ptr<PowerState> Server::sweepPolicies(const JobStreamView &jobStream){
+
+	// Simulate all policies. Each task writes only its own result slots, so the order in which the threads finish does not matter.
+#ifdef USE_SIMD_KERNEL
+	this->sweepPool->parallelFor(this->sweepBlocks.size(), [&](int task){
+		simQueueBlock(this->sweepBlocks.at(task), jobStream);
+	});
+
+#ifdef CHECK_SIMD_KERNEL
+	for (int i = 1; i != this->allPolicy.size(); ++i){
+		PolicyResult check;
+		simQueue(this->allPolicy.at(i), jobStream, check);
+		if (check.ER != this->sweepResults.at(i).ER || check.EP != this->sweepResults.at(i).EP){
+			LOG_TO(this->logOut, LOG_SUMMARY) << "[DO_SLEEPSCALE] Kernel mismatch for f = " << this->allPolicy.at(i)->freq << " and low-power state = " << this->allPolicy.at(i)->idle <<
+				": ER " << this->sweepResults.at(i).ER << " vs " << check.ER << ", EP " << this->sweepResults.at(i).EP << " vs " << check.EP;
+			cout << "Multi-frequency kernel does not match simQueue!" << endl;
+			terminate();
+		}
+	}
+#endif // CHECK_SIMD_KERNEL
+
+#else // USE_SIMD_KERNEL
+	int noOfPolicies = this->allPolicy.size() - 1;
+	this->sweepPool->parallelFor(noOfPolicies, [&](int task){
+		simQueue(this->allPolicy.at(task + 1), jobStream, this->sweepResults.at(task + 1));
+	});
+#endif // USE_SIMD_KERNEL
+
+	vector<int> candidates;
+	for (int i = 1; i != this->allPolicy.size(); ++i){
+		candidates.push_back(i);
+	}
+
+	return pickBestPolicy(candidates);
+}
+
+/*
+Exhaustive sweep by updating the simulations of the last step with the same estimate (IncrementalSweep.h). jobStream is only used to 
+check the results against a full sweep. 
+*/
+shared_ptr<PowerState> Server::incrementalPolicies(const JobStreamView &jobStream){
+
+	bool updated = this->incremental->simulate(this->allPolicy, this->jobLog, this->estimator->est, this->config.serTime * this->config.slowdown, 
+		*this->sweepPool, this->sweepResults);
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] " << (updated ? "Updated" : "Rebuilt") << " the simulations of the job log for utilization " << 
+		this->estimator->est;
+
+	vector<int> candidates;
+	for (int i = 1; i != this->allPolicy.size(); ++i){
+		candidates.push_back(i);
+	}
+
+#ifdef SLEEPSCALE_INCREMENTAL_VERIFY
+	vector<PolicyResult> incrementalResults = this->sweepResults;
+	shared_ptr<PowerState> incrementalPolicy = pickBestPolicy(candidates);
+	shared_ptr<PowerState> bestPolicy = sweepPolicies(jobStream);
+
+	double maxER = this->config.serTime * this->config.slowdown;
+	for (auto i : candidates){
+		if (incrementalResults.at(i).ER > maxER){
+			// Pruned or infeasible. Its ER is at least a lower bound.
+			if (this->sweepResults.at(i).ER < incrementalResults.at(i).ER * (1 - 1e-9)){
+				this->incrementalMaxError = max(this->incrementalMaxError, (incrementalResults.at(i).ER - this->sweepResults.at(i).ER) / this->sweepResults.at(i).ER);
+			}
+			continue;
+		}
+		double errorER = abs(incrementalResults.at(i).ER - this->sweepResults.at(i).ER) / this->sweepResults.at(i).ER;
+		double errorEP = abs(incrementalResults.at(i).EP - this->sweepResults.at(i).EP) / this->sweepResults.at(i).EP;
+		this->incrementalMaxError = max(this->incrementalMaxError, max(errorER, errorEP));
+	}
+	if (incrementalPolicy != bestPolicy){
+		this->incrementalDisagreements++;
+		LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] Incremental sweep disagrees with the full sweep! It picked f = " << incrementalPolicy->freq << 
+			" and low-power state = " << incrementalPolicy->idle << ", the full sweep picked f = " << bestPolicy->freq << " and low-power state = " << 
+			bestPolicy->idle;
+	}
+	return bestPolicy;
+#else
+	(void)jobStream; // Only the check reads it
+	return pickBestPolicy(candidates);
 #endif
+}
+
+/*
+Pick the policy with the lowest power among the simulated candidates that meets the response time target. Candidates are visited in 
+policy order, so ties are broken exactly as in a serial sweep. The ER, EP and overTarget of every candidate are set from sweepResults. 
+
+If no candidate meets the target, the fastest policy, this->allPolicy.at(1) (the highest frequency of the first idle state), is 
+returned. Its numbers are this step's if it was among the candidates, which the sweep and the search make sure of (with the incremental 
+sweep, ER may be the lower bound it was pruned by), and NAN otherwise. 
+this->allPolicy.at(0) is the baseline policy and never a candidate. 
+*/
+shared_ptr<PowerState> Server::pickBestPolicy(const vector<int> &candidates){
 
-	double curPolicyER = 0;
 	double curPolicyEP = MAX_NUM;
-	bestPolicy = this->allPolicy.at(1); // this->allPolicy.at(0) is the baseline policy. DO NOT USE!
+	shared_ptr<PowerState> bestPolicy = nullptr;
 
-	// Simulate all policies
-	for (int i = 1; i != this->allPolicy.size(); ++i){
-		simQueue(this->allPolicy.at(i), jobStream);
+	for (auto i : candidates){
+		this->allPolicy.at(i)->ER = this->sweepResults.at(i).ER;
+		this->allPolicy.at(i)->EP = this->sweepResults.at(i).EP;
+		this->allPolicy.at(i)->overTarget = this->sweepResults.at(i).overTarget;
 
-		if (this->allPolicy.at(i)->EP <= curPolicyEP && this->allPolicy.at(i)->ER <= SER_TIME * SLEEPSCALE_SLOWDOWN){
+		if (this->allPolicy.at(i)->EP <= curPolicyEP && meetsTarget(this->allPolicy.at(i)->ER, this->allPolicy.at(i)->overTarget)){
 			bestPolicy = this->allPolicy.at(i);
 			curPolicyEP = this->allPolicy.at(i)->EP;
 		}
-
 	}
 
-	this->logOut << "[DO_SLEEPSCALE] All policies simulated! SleepScale completes!" << endl;
-	this->logOut << "[DO_SLEEPSCALE] The best policy is f = " << bestPolicy->freq <<
-		" and low-power state = " << bestPolicy->idle << endl;
+	if (bestPolicy == nullptr){
+		bestPolicy = this->allPolicy.at(1);
+		if (find(candidates.begin(), candidates.end(), 1) == candidates.end()){
+			bestPolicy->ER = NAN;
+			bestPolicy->EP = NAN;
+			bestPolicy->overTarget = NAN;
+		}
+		LOG_TO(this->logOut, LOG_INFO) << "[DO_SLEEPSCALE] No policy meets the response time target. Falling back to f = " << bestPolicy->freq << 
+			" and low-power state = " << bestPolicy->idle;
+	}
 
 	return bestPolicy;
+}
+
+/*
+The response time target is slowdown * ser_time. It bounds the mean, or the slo_percentile percentile if that is set. The percentile is 
+within the target exactly when at most 100 - slo_percentile percent of the jobs take longer, so the sweep only counts those jobs. 
+*/
+bool Server::meetsTarget(double ER, double overTarget) const{
+	if (this->config.sloPercentile > 0){
+		return overTarget * 100 <= 100 - this->config.sloPercentile + 1e-9; // Tolerates the rounding of the share
+	}
+	return ER <= this->config.serTime * this->config.slowdown;
+}
+
+/*
+Simulate allPolicy[first, first + count) and store their results in sweepResults. 
+*/
+void Server::simulatePolicies(int first, int count, const JobStreamView &jobStream){
+	if (this->config.cores > 1){
+		for (int i = first; i < first + count; i++){
+			simMultiCore(this->allPolicy.at(i), jobStream, this->sweepResults.at(i));
+		}
+		return;
+	}
+#ifdef USE_SIMD_KERNEL
+	for (int block = first; block < first + count; block += SWEEP_BLOCK){
+		simQueueBlock(make_pair(block, min(SWEEP_BLOCK, first + count - block)), jobStream);
+	}
+#else
+	for (int i = first; i < first + count; i++){
+		simQueue(this->allPolicy.at(i), jobStream, this->sweepResults.at(i));
+	}
+#endif
+}
+
+/*
+Monotone search. For a fixed idle state, every response time goes down as the frequency goes up, and so do their mean and the number 
+of jobs over the target. The feasible frequencies form an interval [f_min, 1]. Bisection finds f_min. Power is not monotone in the 
+frequency, so the SEARCH_WINDOW frequencies right above f_min are simulated too, and the window keeps moving up as long as the lowest 
+power sits at its upper edge. 
+*/
+void Server::searchIdleState(const pair<int, int> &range, const JobStreamView &jobStream, vector<int> &candidates, int &noOfSims){
+
+	// Frequencies descend from first to last
+	int first = range.first;
+	int last = range.first + range.second - 1;
 
+	simulatePolicies(first, 1, jobStream);
+	noOfSims = 1;
+	if (!meetsTarget(this->sweepResults.at(first).ER, this->sweepResults.at(first).overTarget)){
+		candidates.push_back(first); // Even the highest frequency misses the target. Kept as the fallback of pickBestPolicy.
+		return;
+	}
+
+	// Invariant: lo is feasible, hi is infeasible or past the last frequency.
+	int lo = first;
+	int hi = last + 1;
+	while (hi - lo > 1){
+		int mid = (lo + hi) / 2;
+		simulatePolicies(mid, 1, jobStream);
+		noOfSims++;
+		if (meetsTarget(this->sweepResults.at(mid).ER, this->sweepResults.at(mid).overTarget)){
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	candidates.push_back(lo);
+
+	int top = lo; // Highest frequency simulated so far above the boundary
+	while (top > first){
+		int newTop = max(first, top - SEARCH_WINDOW);
+		simulatePolicies(newTop, top - newTop, jobStream);
+		noOfSims = noOfSims + top - newTop;
+
+		int bestIdx = lo;
+		for (int i = newTop; i < top; i++){
+			candidates.push_back(i);
+		}
+		for (auto i : candidates){
+			if (this->sweepResults.at(i).EP < this->sweepResults.at(bestIdx).EP){
+				bestIdx = i;
+			}
+		}
+
+		top = newTop;
+		if (bestIdx != top){
+			break; // The lowest power is inside the window
+		}
+	}
+}
+
+shared_ptr<PowerState> Server::searchPolicies(const JobStreamView &jobStream){
+
+	int noOfStates = this->stateRanges.size();
+	vector<vector<int>> candidates(noOfStates);
+	vector<int> noOfSims(noOfStates, 0);
+
+	// Idle states are independent of each other
+	this->sweepPool->parallelFor(noOfStates, [&](int task){
+		searchIdleState(this->stateRanges.at(task), jobStream, candidates.at(task), noOfSims.at(task));
+	});
+
+	vector<int> allCandidates;
+	int totalSims = 0;
+	for (int s = 0; s < noOfStates; s++){
+		allCandidates.insert(allCandidates.end(), candidates.at(s).begin(), candidates.at(s).end());
+		totalSims = totalSims + noOfSims.at(s);
+	}
+	sort(allCandidates.begin(), allCandidates.end());
+
+	LOG_TO(this->logOut, LOG_DEBUG) << "[DO_SLEEPSCALE] Search simulated " << totalSims << " of " << this->allPolicy.size() - 1 << " policies";
+
+	return pickBestPolicy(allCandidates);
 }
 
 
@@ -994,47 +1601,125 @@ shared_ptr<PowerState> Server::doSleepScale(){
 
 
 /*
-Server constructor.
+Server constructor. The server keeps its own copy of the configuration. 
 */
 
-Server::Server(const string logOut, const string config) {
+Server::Server(const Config &config) : config(config) {
 
-	openOutputFile(logOut, this->logOut);
+	// Before the log is opened, which a refused configuration must leave alone
+	this->config.check();
 
-	assert(SLEEPSCALE_SLOWDOWN >= 1);
+	// A resumed run continues its log. restoreCheckpoint cuts it back to where the checkpoint was taken.
+	bool resuming = config.resume && !config.checkpoint.empty() && ifstream(config.checkpoint).good();
+	this->logOut.open(config.output, config.logLevel, config.logBinary, resuming);
 
-	this->N_FREQ = NO_FREQ; // Total number of frequency levels. 
-	double freqIncrement = static_cast<double>(1) / this->N_FREQ;
+	this->config.resolveSeed();
+	this->config.write(this->logOut);
 
-	for (int i = N_FREQ; i >= 1; i--){
-		frequency.push_back(freqIncrement * i);
-	}
+	this->powerModel = make_shared<const PowerModel>(this->config);
+	this->frequency = this->powerModel->getFrequencies();
+	this->N_FREQ = this->frequency.size(); // Total number of frequency levels. 
 
-	if (config.compare("DVFS_only") == 0){
+	if (config.runAs.compare("DVFS_only") == 0){
 		this->lowPowerState.push_back("DVFS_only");
 	}
-	else if (config.compare("SleepScale") == 0){
-		this->lowPowerState.push_back("C0i");
-		this->lowPowerState.push_back("C1");
-		this->lowPowerState.push_back("C3");
-		this->lowPowerState.push_back("C6");
+	else if (config.runAs.compare("SleepScale") == 0){
+		// Every C-state of the platform
+		for (auto state : { IDLE_C0I, IDLE_C1, IDLE_C3, IDLE_C6 }){
+			if (this->powerModel->hasIdleState(state)){
+				this->lowPowerState.push_back(idleStateName(state));
+			}
+		}
 	}
 	else {
-		this->lowPowerState.push_back(config);
+		if (!this->powerModel->hasIdleState(parseIdleState(config.runAs))){
+			cerr << "Platform " << this->powerModel->getName() << " has no low-power state " << config.runAs << endl;
+			terminate();
+		}
+		this->lowPowerState.push_back(config.runAs);
 	}
 
 
+	// A multi-core server can park cores: all of them, half of them, a quarter, ..., down to one
+	for (int cores = config.cores; cores >= 1; cores = cores / 2){
+		this->activeCores.push_back(cores);
+	}
+	this->multiCore = MultiCoreQueue(config.cores, config.coreQueue);
+	this->multiCoreBaseline = MultiCoreQueue(config.cores, config.coreQueue);
+
 	// The first policy 0 is the baseline, i.e., no power control at all
-	this->allPolicy.push_back(make_shared<PowerState>(1.0, "Baseline"));
+	this->allPolicy.push_back(make_shared<PowerState>(1.0, IDLE_BASELINE, *this->powerModel, config.cores));
 
 	// Then push back all policies
-	for (auto state : this->lowPowerState){
-		for (auto f : this->frequency){
-			this->allPolicy.push_back(make_shared<PowerState>(f, state));
+	for (auto cores : this->activeCores){
+		for (auto state : this->lowPowerState){
+			for (auto f : this->frequency){
+				this->allPolicy.push_back(make_shared<PowerState>(f, parseIdleState(state), *this->powerModel, cores));
+			}
+		}
+	}
+
+	// Policies of each idle state and number of active cores, with frequencies in descending order
+	for (int i = 1; i < this->allPolicy.size(); i++){
+		const PowerState &rangeFirst = *this->allPolicy.at(this->stateRanges.empty() ? i : this->stateRanges.back().first);
+		if (this->stateRanges.empty() || this->allPolicy.at(i)->idleState != rangeFirst.idleState || this->allPolicy.at(i)->cores != rangeFirst.cores){
+			this->stateRanges.push_back(make_pair(i, 0));
 		}
+		else{
+			assert(this->allPolicy.at(i)->freq < this->allPolicy.at(i - 1)->freq);
+		}
+		this->stateRanges.back().second++;
 	}
 
-	this->logOut << "[SERVER] Server is up! Server has " << this->allPolicy.size() - 1 << " policies" << endl;
+	// Group consecutive policies with the same idle state into blocks for the multi-frequency kernel
+	for (int i = 1; i < this->allPolicy.size(); i++){
+		if (this->sweepBlocks.empty() || this->sweepBlocks.back().second == SWEEP_BLOCK ||
+			this->allPolicy.at(i)->idleState != this->allPolicy.at(this->sweepBlocks.back().first)->idleState || 
+			this->allPolicy.at(i)->cores != this->allPolicy.at(this->sweepBlocks.back().first)->cores){
+			this->sweepBlocks.push_back(make_pair(i, 0));
+		}
+		this->sweepBlocks.back().second++;
+	}
+
+	this->sweepResults.resize(this->allPolicy.size());
+	this->sweepPool = make_shared<ThreadPool>(config.sweepThreads);
+#ifdef SLEEPSCALE_INCREMENTAL
+	this->incremental = make_shared<IncrementalSweep>(INCREMENTAL_CACHE_SIZE);
+#endif
+
+	if (!config.policyTable.empty()){
+		this->policyTable = make_shared<PolicyTable>(config.policyTable);
+		const PolicyTableHeader &table = this->policyTable->getHeader();
+		if (table.configHash != policyConfigHash(this->config)){
+			cerr << "Policy table " << config.policyTable << " was compiled for slowdown " << table.slowdown << ", ser_time " << table.serTime << 
+				", no_freq " << table.noFreq << " and run_as " << table.runAs << ", or other power parameters. Recompile it with tools/policycompile." << endl;
+			terminate();
+		}
+		for (int i = 0; i < this->policyTable->getSize(); i++){
+			string idle = this->policyTable->getEntry(i).idle;
+			if (find(this->lowPowerState.begin(), this->lowPowerState.end(), idle) == this->lowPowerState.end()){
+				cerr << "Policy table " << config.policyTable << " uses the low-power state " << idle << ", which this server does not have!" << endl;
+				terminate();
+			}
+		}
+		LOG_TO(this->logOut, LOG_INFO) << "[SERVER] Policies are looked up in " << config.policyTable << ": " << this->policyTable->getSize() << 
+			" utilizations from " << table.rhoMin << " in steps of " << table.rhoStep << ", compiled for " << string(table.serviceCdf) << " and " << string(table.arrivalCdf);
+	}
+
+	LOG_TO(this->logOut, LOG_INFO) << "[SERVER] Power model " << this->powerModel->getName() << " with " << this->N_FREQ << " P-states and " << 
+		this->lowPowerState.size() << " low-power states";
+	if (config.cores > 1){
+		LOG_TO(this->logOut, LOG_INFO) << "[SERVER] " << config.cores << " cores with " << config.get("core_queue") << " queueing. Policies run " << 
+			this->activeCores.back() << " to " << this->activeCores.front() << " of them in " << this->activeCores.size() << " steps";
+	}
+	if (config.sloPercentile > 0){
+		LOG_TO(this->logOut, LOG_INFO) << "[SERVER] Policies must keep the p" << config.sloPercentile << " response time within " << 
+			config.serTime * config.slowdown << " ms";
+	}
+	LOG_TO(this->logOut, LOG_INFO) << "[SERVER] Server is up! Server has " << this->allPolicy.size() - 1 << " policies and " << this->sweepPool->getSize() << " sweep threads";
+#ifdef USE_SIMD_KERNEL
+	LOG_TO(this->logOut, LOG_INFO) << "[SERVER] Policies are simulated in " << this->sweepBlocks.size() << " blocks by the " << queueKernelName() << " kernel";
+#endif
 
 
 }
@@ -1076,23 +1761,16 @@ void readBigHouseCDF(vector<double> &CDF_Sample, vector<double> &CDF_Prob, const
 
 	openInputFile(fileName, handle);
 
+	// BigHouse stores the Google search CDFs in seconds and for 16 servers. Matched on the base name, so paths work too. 
+	double scale = bigHouseCdfScale(fileName);
+
 	string line = "";
 	try{
 		while (getline(handle, line)){
 			istringstream record(line);
 			string last;
 			record >> last;
-			// BigHouse stores Google search CDF in "second" unit. Need to scale by 1000. 
-			if (fileName.compare("search.service.cdf") == 0){
-				CDF_Sample.push_back(1000 * stod(last));
-			}
-			else if (fileName.compare("search.arrival.cdf") == 0){
-				// Multiply by 16 because there are 16 servers. 
-				CDF_Sample.push_back(1000 * 16 * stod(last));
-			}
-			else{
-				CDF_Sample.push_back(stod(last));
-			}
+			CDF_Sample.push_back(scale * stod(last));
 			record >> last;
 			CDF_Prob.push_back(stod(last));
 		}
@@ -1102,4 +1780,18 @@ void readBigHouseCDF(vector<double> &CDF_Sample, vector<double> &CDF_Prob, const
 		handle.close();
 	}
 
-}
\ No newline at end of file
+}
+
+shared_ptr<const EmpiricalDistribution> loadCdfTable(const string fileName){
+
+	if (isCompiledCdf(fileName)){
+		CompiledCdf compiled(fileName);
+		return make_shared<const EmpiricalDistribution>(compiled.getSamples(), compiled.getProbs(), compiled.getSize());
+	}
+
+	vector<double> CDF_Sample;
+	vector<double> CDF_Prob;
+	ifstream cdfFile;
+	readBigHouseCDF(CDF_Sample, CDF_Prob, fileName, cdfFile);
+	return make_shared<const EmpiricalDistribution>(CDF_Sample, CDF_Prob);
+}
@@ -39,12 +39,27 @@ Server class.
 #define SERVER_H
 
 #include "PowerState.h"
+#include "PowerModel.h"
+#include "MultiCore.h"
+#include "LatencyHistogram.h"
 #include "Job.h"
 #include "JobHistory.h"
 #include "Estimator.h"
+#include "ThreadPool.h"
+#include "QueueKernel.h"
+#include "QueueScan.h"
+#include "IncrementalSweep.h"
+#include "PolicyTable.h"
+#include "EmpiricalDistribution.h"
+#include "Config.h"
+#include "CompiledCdf.h"
+#include "Philox.h"
+#include "MinuteMetrics.h"
+#include "Profiler.h"
 #include<iostream>
 #include<vector>
 #include<memory>
+#include<functional>
 #include<sstream>
 #include<fstream>
 #include<random>
@@ -56,13 +71,26 @@ public:
 	int N_FREQ; // Number of frequency levels
 	vector<string> lowPowerState; // A bunch of low power state names
 	vector<double> frequency; // Supported DVFS scaling level between 0 and 1
+	shared_ptr<const PowerModel> powerModel; // P-states and C-states of the platform (platform)
 	vector<shared_ptr<PowerState>> allPolicy;
 	vector<double> bestFreqUsed;
 	vector<string> bestLowpowerUsed;
-
-	ofstream logOut;
+	vector<int> bestCoresUsed;
+	vector<double> p50Used; // Response time percentiles of each minute run by doQueue, ms
+	vector<double> p95Used;
+	vector<double> p99Used;
+	vector<int> activeCores; // Numbers of active cores the policies choose from, descending (cores > 1)
+
+	Config config; // Parameters of this server
+	Logger logOut; // Asynchronous log (Logger.h)
 	int minute = 0;
 
+	shared_ptr<TraceSource> rhoIn; // Utilization trace
+#ifdef DO_OFFLINE
+	shared_ptr<TraceSource> rhoInOffline; // Same trace, read ahead by the offline estimator
+#endif
+	shared_ptr<PowerState> lastBestPolicy; // Policy picked by the last SleepScale step
+
 	int totalNoOfJobs = 0;
 	int totalNoOfJobs_baseline = 0;
 
@@ -87,22 +115,87 @@ public:
 	double prevDepart = -1;
 	double prevDepart_baseline = -1;
 
-	void simQueue(const shared_ptr<PowerState>, const vector<Job> &); 
+	void simQueue(const shared_ptr<PowerState>, const JobStreamView &, PolicyResult &) const; // Simulate a policy on a job stream. Results go to the given slot only. 
 	void doQueue(const shared_ptr<PowerState>, const vector<Job> &); // This function is the same as doQueueSim. It is simulating the "actual operation" of the server and does not edit the policy pointer.
 	void doQueueBaseline(const shared_ptr<PowerState>, const vector<Job> &);
+	bool runQueue(const PowerState &, double, const vector<Job> &, bool, double &, QueueTotals &, LatencyHistogram &); // Policy, frequency, jobs, counted, last departure, sums and response times of the run
+	void runMultiCore(const PowerState &, double, const vector<Job> &, MultiCoreQueue &, MultiCoreTotals &, LatencyHistogram &); // Policy, frequency, jobs, cores, sums and response times of the run
+	LatencyHistogram latencies; // Response times of the counted minutes
+	LatencyHistogram latenciesBaseline;
+	LatencyHistogram minuteLatencies; // Response times of the last minute run, merged into latencies if it is counted
+	LatencyHistogram minuteLatenciesBaseline;
+	MultiCoreQueue multiCore; // Cores of the server (cores > 1)
+	MultiCoreQueue multiCoreBaseline;
+	shared_ptr<MetricsWriter> metrics; // Per-minute metrics (metrics), opened by the first stepMinute or by restoreCheckpoint
+	MinuteMetrics minuteMetrics; // Those of the minute being stepped through
+#ifdef PROFILE_PHASES
+	mutable PhaseProfile profile; // Time per phase (Profiler.h). Simulations time themselves from the sweep threads.
+#endif
+	CoreResidency residency; // Where the cores spent the counted minutes
+	CoreResidency residencyBaseline;
 
 	shared_ptr<PowerState> doSleepScale(); // A queue simulation.
+	shared_ptr<ThreadPool> sweepPool; // Threads used to simulate policies in doSleepScale
+	vector<PolicyResult> sweepResults; // One result slot per policy in allPolicy
+	vector<pair<int, int>> sweepBlocks; // (first policy, number of policies) of consecutive policies sharing an idle state
+	vector<double> sweepArrival; // Rescaled arrival times of the job stream simulated by doSleepScale
+	vector<double> sweepService; // Service times, only used when the job stream does not come from the job log
+	void simQueueBlock(const pair<int, int> &, const JobStreamView &); // Simulate a block of policies with the multi-frequency kernel
+	void simMultiCore(const shared_ptr<PowerState>, const JobStreamView &, PolicyResult &) const; // Simulate a policy on the cores of a multi-core server
+	vector<pair<int, int>> stateRanges; // (first policy, number of policies) of each idle state and number of active cores
+	bool forceSearch = false; // Search the policies (searchPolicies) even on a single core, set by the daemon when a sweep is too slow
+	int searchDisagreements = 0; // Minutes where the search and the exhaustive sweep picked different policies
+
+	const Server *sweepLeader = nullptr; // Server with the same policies and job log whose sweep this server may reuse (ParameterSweep.h)
+	int sweepMinute = -1; // Minute of the exhaustive sweep held in sweepResults
+	double sweepEst = -1; // Utilization it was simulated for
+	int reusedSweeps = 0; // Sweeps copied from sweepLeader
+	int noOfSleepScale = 0; // Calls of doSleepScale
+	function<void(const PowerState &, double)> onDecision; // Called with each policy doSleepScale picks and the ms it took, if set (Daemon.h)
+
+	void simulatePolicies(int, int, const JobStreamView &); // Simulate a range of policies into sweepResults
+	shared_ptr<PowerState> pickBestPolicy(const vector<int> &); // Best feasible policy among the simulated candidates
+	bool meetsTarget(double, double) const; // Mean response time and share of the jobs over the target. Does the policy meet the response time target?
+	shared_ptr<PowerState> sweepPolicies(const JobStreamView &); // Simulate every policy
+	shared_ptr<PowerState> searchPolicies(const JobStreamView &); // Simulate only the policies near the lowest feasible frequency of each idle state
+	void searchIdleState(const pair<int, int> &, const JobStreamView &, vector<int> &, int &);
+	shared_ptr<IncrementalSweep> incremental; // Cached simulations of the sliding job log (SLEEPSCALE_INCREMENTAL)
+	shared_ptr<PowerState> incrementalPolicies(const JobStreamView &); // Simulate every policy by updating the cached simulations
+	int incrementalDisagreements = 0; // Steps where the incremental and the full sweep picked different policies
+	double incrementalMaxError = 0; // Largest relative difference of ER or EP between them
+	double rescaleJobLog(double, JobStreamView &); // Job log with the arrivals scaled to a utilization, in sweepArrival. Returns its empirical utilization.
+
+	shared_ptr<PolicyTable> policyTable; // Best policy per utilization, compiled offline (policy_table)
+	shared_ptr<PowerState> tablePolicy(); // Look the estimate up in the policy table
+	void refreshPolicyTable(int); // Re-derive an entry of the table by sweeping the job log at its utilization
+	int tableRefreshMinute = -1; // Minute of the last refresh
+	int noOfTableLookups = 0;
+	int noOfTableRefreshes = 0;
 
 	// void generateWorkloadMM1(const double, const double, vector<Job> &);
-	void generateWorkloadCDF(const vector<double> &, const vector<double> &, const vector<double> &, const vector<double> &, const int &, const double &);
+	void generateWorkloadCDF(const EmpiricalDistribution &, const EmpiricalDistribution &, const int &, const double &); // Service and inter-arrival distributions, minute, utilization
+	void addWorkload(const vector<Job> &); // Jobs of the current minute. Advances the clock to the next minute.
 	void showReport();
 	shared_ptr<Estimator> estimator;
 	~Server();
 
 public:
 	Server() = default;
-	Server(const string, const string); 
+	Server(const Config &); 
 	void run(const string, const string, const string); //  
+	void run(const string, const EmpiricalDistribution &, const EmpiricalDistribution &); // Trace, already built service and inter-arrival distributions
+
+	// run, one minute at a time
+	void start(const string); // Trace
+	void start(shared_ptr<TraceSource>); // Trace already open, e.g. a live feed (Daemon.h). The offline estimator needs rhoInOffline set too.
+	bool isRunning() const;
+	double stepMinute(); // Utilization observed for the current minute, negative at the end of the trace
+	void finish();
+	double observe(); // Utilization of the current minute from the trace, negative at its end
+
+	// Between minutes, after start (Checkpoint.h). run does both if checkpoint is set.
+	void saveCheckpoint(const string);
+	void restoreCheckpoint(const string);
 	
 };
 
@@ -110,6 +203,8 @@ public:
 void openOutputFile(const string, ofstream &);
 void openInputFile(const string, ifstream &);
 void readBigHouseCDF(vector<double> &, vector<double> &, const string, ifstream &);
-void generateWorkloadMM1(const double, const double, vector<Job> &);
+shared_ptr<const EmpiricalDistribution> loadCdfTable(const string); // Sampling table of a text or compiled CDF
+void generateWorkloadMM1(const double, const double, const uint64_t, const int, vector<Job> &); // Service time, utilization, seed, minute
+void drawWorkloadCDF(const EmpiricalDistribution &, const EmpiricalDistribution &, const int &, const double &, const uint64_t, vector<Job> &); // Jobs of one minute
 
 #endif
\ No newline at end of file
@@ -0,0 +1,165 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int noOfThreads){
+
+	if (noOfThreads <= 0){
+		noOfThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < noOfThreads; i++){
+		this->queues.push_back(make_shared<WorkQueue>());
+	}
+
+	// Worker 0 is the thread calling parallelFor.
+	for (int i = 1; i < noOfThreads; i++){
+		this->workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool(){
+	{
+		lock_guard<mutex> guard(this->poolLock);
+		this->stopping = true;
+	}
+	this->workReady.notify_all();
+
+	for (auto &worker : this->workers){
+		worker.join();
+	}
+}
+
+int ThreadPool::getSize(){
+	return this->queues.size();
+}
+
+void ThreadPool::parallelFor(int noOfTasks, const function<void(int)> &task){
+
+	if (noOfTasks <= 0){
+		return;
+	}
+
+	int noOfWorkers = this->queues.size();
+
+	if (noOfWorkers == 1 || noOfTasks == 1){
+		for (int i = 0; i < noOfTasks; i++){
+			task(i);
+		}
+		return;
+	}
+
+	// Hand every worker a contiguous block of tasks. Imbalance between blocks is fixed by stealing.
+	for (int w = 0; w < noOfWorkers; w++){
+		lock_guard<mutex> guard(this->queues.at(w)->lock);
+		for (int i = noOfTasks * w / noOfWorkers; i < noOfTasks * (w + 1) / noOfWorkers; i++){
+			this->queues.at(w)->tasks.push_back(i);
+		}
+	}
+
+	{
+		lock_guard<mutex> guard(this->poolLock);
+		this->job = &task;
+		this->remaining = noOfTasks;
+		this->activeWorkers = noOfWorkers - 1;
+		this->generation++;
+	}
+	this->workReady.notify_all();
+
+	this->runTasks(0);
+
+	// The task body lives on the caller's stack, so wait until every worker has let go of it.
+	unique_lock<mutex> guard(this->poolLock);
+	this->workDone.wait(guard, [this]{ return this->remaining == 0 && this->activeWorkers == 0; });
+	this->job = nullptr;
+}
+
+void ThreadPool::workerLoop(int self){
+
+	long seenGeneration = 0;
+
+	while (true){
+		{
+			unique_lock<mutex> guard(this->poolLock);
+			this->workReady.wait(guard, [&]{ return this->stopping || this->generation != seenGeneration; });
+			if (this->stopping){
+				return;
+			}
+			seenGeneration = this->generation;
+		}
+
+		this->runTasks(self);
+
+		{
+			lock_guard<mutex> guard(this->poolLock);
+			this->activeWorkers--;
+		}
+		this->workDone.notify_all();
+	}
+}
+
+void ThreadPool::runTasks(int self){
+	int task;
+	while (this->popTask(self, task)){
+		(*this->job)(task);
+		this->remaining--;
+	}
+}
+
+// Take a task from the back of our own queue, otherwise steal one from the front of another queue.
+bool ThreadPool::popTask(int self, int &task){
+
+	int noOfWorkers = this->queues.size();
+
+	{
+		auto &own = this->queues.at(self);
+		lock_guard<mutex> guard(own->lock);
+		if (!own->tasks.empty()){
+			task = own->tasks.back();
+			own->tasks.pop_back();
+			return true;
+		}
+	}
+
+	for (int k = 1; k < noOfWorkers; k++){
+		auto &victim = this->queues.at((self + k) % noOfWorkers);
+		lock_guard<mutex> guard(victim->lock);
+		if (!victim->tasks.empty()){
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+A small work-stealing thread pool used to spread independent simulations (e.g., the policy sweep in doSleepScale) over cores.
+Every worker owns a deque of task indices. It pops from the back of its own deque and steals from the front of the others once it runs dry.
+The calling thread takes part as worker 0, so a pool of size 1 runs everything inline without spawning threads.
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include<vector>
+#include<deque>
+#include<memory>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<atomic>
+#include<algorithm>
+using namespace std;
+
+class ThreadPool{
+
+private:
+	struct WorkQueue{
+		mutex lock;
+		deque<int> tasks;
+	};
+
+	vector<thread> workers;
+	vector<shared_ptr<WorkQueue>> queues; // One task queue per worker. queues.at(0) belongs to the calling thread.
+
+	const function<void(int)> *job = nullptr; // Task body of the current parallelFor
+	atomic<int> remaining{ 0 }; // Tasks not yet finished in the current parallelFor
+	int activeWorkers = 0; // Workers still inside the current parallelFor
+	long generation = 0; // Bumped for every parallelFor so sleeping workers know there is new work
+	bool stopping = false;
+
+	mutex poolLock;
+	condition_variable workReady;
+	condition_variable workDone;
+
+	void workerLoop(int);
+	void runTasks(int);
+	bool popTask(int, int &);
+
+public:
+	ThreadPool(int); // Number of workers including the calling thread. 0 uses all hardware threads.
+	~ThreadPool();
+
+	int getSize();
+	void parallelFor(int, const function<void(int)> &); // Run task(i) for i in [0, n) and return when all are done
+
+};
+
+#endif
@@ -0,0 +1,233 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+#include "TraceSource.h"
+#include<iostream>
+#include<cstring>
+#include<cerrno>
+#include<charconv>
+#include<exception>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+bool parseTraceLine(const char *first, const char *last, double &value, const string &fileName, long lineNo){
+
+	while (first < last && (*first == ' ' || *first == '\t' || *first == '\r')){
+		first++;
+	}
+	if (first == last){
+		return false;
+	}
+	if (*first == '+'){
+		first++; // stod accepts a leading plus, from_chars does not
+	}
+
+	auto parsed = from_chars(first, last, value);
+	if (parsed.ec != errc()){
+		cerr << "Line " << lineNo << " of trace " << fileName << " is not a number: " << string(first, last) << endl;
+		terminate();
+	}
+	return true;
+}
+
+MappedTrace::MappedTrace(const string fileName){
+
+	this->fileName = fileName;
+
+	int fd = open(fileName.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+	if (!S_ISREG(info.st_mode)){
+		cerr << "Trace " << fileName << " is not a regular file and cannot be mapped. Use trace_reader = buffered." << endl;
+		terminate();
+	}
+
+	this->length = info.st_size;
+	if (this->length > 0){
+		void *mapped = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED){
+			cerr << "File " << fileName << " cannot be mapped!" << endl;
+			terminate();
+		}
+		madvise(mapped, this->length, MADV_SEQUENTIAL);
+		this->data = static_cast<const char *>(mapped);
+	}
+	close(fd);
+}
+
+MappedTrace::~MappedTrace(){
+	if (this->data != nullptr){
+		munmap(const_cast<char *>(this->data), this->length);
+	}
+}
+
+const char *MappedTrace::begin() const{
+	return this->data;
+}
+
+const char *MappedTrace::end() const{
+	return this->data + this->length;
+}
+
+string MappedTrace::getName() const{
+	return this->fileName;
+}
+
+MappedTraceReader::MappedTraceReader(shared_ptr<const MappedTrace> trace){
+	this->trace = trace;
+	this->cur = trace->begin();
+}
+
+bool MappedTraceReader::next(double &value){
+
+	const char *end = this->trace->end();
+
+	while (this->cur < end){
+		const char *newline = static_cast<const char *>(memchr(this->cur, '\n', end - this->cur));
+		const char *lineEnd = newline != nullptr ? newline : end;
+		const char *lineStart = this->cur;
+
+		this->cur = newline != nullptr ? newline + 1 : end;
+		this->lineNo++;
+
+		if (parseTraceLine(lineStart, lineEnd, value, this->trace->getName(), this->lineNo)){
+			return true;
+		}
+	}
+
+	return false;
+}
+
+long MappedTraceReader::getLineNo() const{
+	return this->lineNo;
+}
+
+string MappedTraceReader::getName() const{
+	return this->trace->getName();
+}
+
+BufferedTraceReader::BufferedTraceReader(const string fileName){
+
+	this->fileName = fileName;
+	this->fd = open(fileName.c_str(), O_RDONLY);
+	if (this->fd < 0){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+	this->buffer.resize(CHUNK_SIZE);
+}
+
+BufferedTraceReader::~BufferedTraceReader(){
+	if (this->fd >= 0){
+		close(this->fd);
+	}
+}
+
+bool BufferedTraceReader::fill(){
+
+	if (this->endOfFile){
+		return false;
+	}
+
+	// Keep the unread part of the current line and grow the buffer if a single line fills it
+	if (this->head > 0){
+		memmove(this->buffer.data(), this->buffer.data() + this->head, this->tail - this->head);
+		this->tail = this->tail - this->head;
+		this->head = 0;
+	}
+	if (this->tail == this->buffer.size()){
+		this->buffer.resize(2 * this->buffer.size());
+	}
+
+	ssize_t got;
+	do {
+		got = read(this->fd, this->buffer.data() + this->tail, this->buffer.size() - this->tail);
+	} while (got < 0 && errno == EINTR);
+
+	if (got < 0){
+		cerr << "Reading trace " << this->fileName << " failed: " << strerror(errno) << endl;
+		terminate();
+	}
+	if (got == 0){
+		this->endOfFile = true;
+		return false;
+	}
+
+	this->tail = this->tail + got;
+	return true;
+}
+
+bool BufferedTraceReader::next(double &value){
+
+	while (true){
+		const char *start = this->buffer.data() + this->head;
+		const char *newline = static_cast<const char *>(memchr(start, '\n', this->tail - this->head));
+
+		if (newline == nullptr && this->fill()){
+			continue;
+		}
+		if (newline == nullptr && this->head == this->tail){
+			return false; // End of file, nothing left
+		}
+
+		// Either a complete line or the last line of the file without a newline
+		start = this->buffer.data() + this->head;
+		const char *lineEnd = newline != nullptr ? newline : this->buffer.data() + this->tail;
+		this->head = newline != nullptr ? newline + 1 - this->buffer.data() : this->tail;
+		this->lineNo++;
+
+		if (parseTraceLine(start, lineEnd, value, this->fileName, this->lineNo)){
+			return true;
+		}
+	}
+}
+
+long BufferedTraceReader::getLineNo() const{
+	return this->lineNo;
+}
+
+string BufferedTraceReader::getName() const{
+	return this->fileName;
+}
+
+shared_ptr<TraceSource> openTraceSource(const string fileName, TraceReaderType type){
+	if (type == TRACE_BUFFERED){
+		return make_shared<BufferedTraceReader>(fileName);
+	}
+	return make_shared<MappedTraceReader>(make_shared<const MappedTrace>(fileName));
+}
@@ -0,0 +1,125 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Utilization trace input. A trace is a text file with one utilization per line. Readers hand out one value per call and report the end of 
+the trace through their return value, so no exceptions are involved. Blank lines are skipped. Values are parsed with from_chars, which 
+gives the same double as stod. 
+
+	MappedTrace        the whole file mapped read-only. Several MappedTraceReaders can walk one mapping at their own pace, e.g., the 
+	                   observer and the offline estimator in DO_OFFLINE mode. 
+	BufferedTraceReader reads the file in large chunks with read(2), for files that should not or cannot be mapped (pipes, FIFOs). 
+
+Other sources (e.g., a live feed) only need to implement TraceSource. 
+*/
+
+#ifndef TRACESOURCE_H
+#define TRACESOURCE_H
+
+#include<string>
+#include<vector>
+#include<memory>
+using namespace std;
+
+class TraceSource{
+
+public:
+	virtual ~TraceSource() = default;
+	virtual bool next(double &) = 0; // Next utilization. False at the end of the trace.
+	virtual long getLineNo() const = 0; // Line of the value returned last
+	virtual string getName() const = 0;
+};
+
+class MappedTrace{
+
+private:
+	string fileName;
+	const char *data = nullptr;
+	size_t length = 0;
+
+public:
+	MappedTrace(const string);
+	~MappedTrace();
+	MappedTrace(const MappedTrace &) = delete;
+	MappedTrace &operator=(const MappedTrace &) = delete;
+
+	const char *begin() const;
+	const char *end() const;
+	string getName() const;
+};
+
+class MappedTraceReader : public TraceSource{
+
+private:
+	shared_ptr<const MappedTrace> trace;
+	const char *cur;
+	long lineNo = 0;
+
+public:
+	MappedTraceReader(shared_ptr<const MappedTrace>);
+	bool next(double &) override;
+	long getLineNo() const override;
+	string getName() const override;
+};
+
+class BufferedTraceReader : public TraceSource{
+
+private:
+	static const int CHUNK_SIZE = 1 << 20; // Bytes per read
+
+	string fileName;
+	int fd = -1;
+	vector<char> buffer;
+	size_t head = 0; // First unread byte in buffer
+	size_t tail = 0; // One past the last valid byte in buffer
+	bool endOfFile = false;
+	long lineNo = 0;
+
+	bool fill(); // Read more bytes. False if there are none.
+
+public:
+	BufferedTraceReader(const string);
+	~BufferedTraceReader();
+	bool next(double &) override;
+	long getLineNo() const override;
+	string getName() const override;
+};
+
+enum TraceReaderType { TRACE_MMAP, TRACE_BUFFERED };
+
+shared_ptr<TraceSource> openTraceSource(const string, TraceReaderType); // A reader over its own mapping or file handle
+
+// Parse one trace line [first, last). False for a blank line. Anything that is not a number terminates.
+bool parseTraceLine(const char *, const char *, double &, const string &, long);
+
+#endif
@@ -46,6 +46,10 @@ Configuration file of SleepScale
 #ifdef useImmediatePastHist
 #undef doCUSUM // Then no CUSUM will be performed
 #endif // useImmediatePastHist
+// #define EST_ENSEMBLE // Estimate with the best of NLMS, immediate past, EWMA and a CUSUM-reset mean each minute (Estimator.h)
+#ifdef EST_ENSEMBLE
+#undef useImmediatePastHist // The immediate past is one of the predictors
+#endif // EST_ENSEMBLE
 
 #define DO_OVER_PROV //do overprovisioning
 #ifdef DO_OVER_PROV
@@ -58,10 +62,61 @@ Configuration file of SleepScale
 // #define GEN_MM1 // If this is defined, job log will not be used to simulate SleepScale. Instead, it uses fake jobs drawn from the perfect M/M/1 model.
 #endif // DO_SLEEPSCALE
 
+#ifdef DO_SLEEPSCALE
+#define USE_SIMD_KERNEL // Simulate a block of frequencies per pass over the job log (QueueKernel.h) instead of one policy per pass
+// #define CHECK_SIMD_KERNEL // Cross-check every result of the multi-frequency kernel against simQueue. Slow. 
+// #define SLEEPSCALE_SEARCH // Find the lowest feasible frequency of each idle state by bisection instead of simulating every policy
+// #define SLEEPSCALE_SEARCH_VERIFY // Also run the exhaustive sweep, use its answer, and report minutes where the search disagreed
+// #define SLEEPSCALE_INCREMENTAL // Update cached per-policy simulations of the sliding job log instead of simulating the whole log (IncrementalSweep.h)
+// #define SLEEPSCALE_INCREMENTAL_VERIFY // Also run the full sweep, use its answer, and report how far the incremental results were off
+#endif // DO_SLEEPSCALE
+
+#ifdef SLEEPSCALE_INCREMENTAL_VERIFY
+#define SLEEPSCALE_INCREMENTAL
+#endif // SLEEPSCALE_INCREMENTAL_VERIFY
+
+#if defined(SLEEPSCALE_INCREMENTAL) && (defined(GEN_MM1) || defined(SLEEPSCALE_SEARCH))
+#undef SLEEPSCALE_INCREMENTAL // Needs the job log and the exhaustive sweep
+#undef SLEEPSCALE_INCREMENTAL_VERIFY
+#endif
+
+#define INCREMENTAL_CACHE_SIZE 16 // Utilization estimates SLEEPSCALE_INCREMENTAL keeps simulations for
+
+#ifdef SLEEPSCALE_SEARCH_VERIFY
+#define SLEEPSCALE_SEARCH
+#endif // SLEEPSCALE_SEARCH_VERIFY
+
 #ifndef DO_SLEEPSCALE
 #define DO_SLEEPSCALE_ADV 
 #endif // DO_SLEEPSCALE
 
+#define SLO_PERCENTILE 0 // Percentile of the response times a policy must keep within SLEEPSCALE_SLOWDOWN * SER_TIME, e.g. 99. 0 bounds the mean (LatencyHistogram.h)
+#define RANDOM_SEED 0 // Seed of the workload generators (Philox.h). 0 draws a new seed every run; it is logged with the configuration
+#define PLATFORM "" // Platform power model file (PowerModel.h), e.g. ../platforms/default.platform. Empty uses the power constants of const.h
+#define CORES 1 // Cores of the server. More than one simulates them with a shared package (MultiCore.h)
+#define CORE_QUEUE CORE_QUEUE_CENTRAL // CORE_QUEUE_CENTRAL: the cores share one FCFS queue. CORE_QUEUE_PER_CORE: jobs go round-robin to a queue per core
+#define POLICY_TABLE "" // Policy table compiled by tools/policycompile.cpp (PolicyTable.h). If set, SleepScale looks policies up instead of simulating them
+#define POLICY_TABLE_REFRESH 0 // Minutes between re-deriving the table entry nearest the estimate from the job log. 0 never refreshes
+#define DECISION_BUDGET 0 // ms a decision of the daemon (Daemon.h) may take before it falls back to the policy search. 0 never falls back
+#define ACTUATOR "" // Sysfs root the daemon writes its decisions to through cpufreq and cpuidle (Actuator.h), e.g. "/sys". Empty does not actuate
+#define CHECKPOINT "" // File a replay saves its state to every CHECKPOINT_INTERVAL minutes (Checkpoint.h). Empty never saves
+#define CHECKPOINT_INTERVAL 60
+#define METRICS "" // Per-minute metrics file in columns (MinuteMetrics.h). Export it with tools/metricsexport.cpp. Empty writes none
+#define PARALLEL_SCAN_MIN_JOBS 1000000 // doQueue splits a queue of at least this many jobs over the sweep threads (QueueScan.h)
+#define CDF_SAMPLER EmpiricalDistribution::ALIAS_TABLE // How workloads are sampled from the CDFs: BINARY_SEARCH, GUIDE_TABLE or ALIAS_TABLE
+
+// #define PROFILE_PHASES // Time the phases of every minute and report them (Profiler.h)
+// #define PROFILE_PERF_COUNTERS // Also read cycles, instructions and cache misses around the policy simulations (perf_event_open)
+
+#ifdef PROFILE_PERF_COUNTERS
+#define PROFILE_PHASES
+#endif // PROFILE_PERF_COUNTERS
+
+/* Logging. Levels are LOG_OFF, LOG_SUMMARY (the final report only), LOG_INFO (one block per minute) and LOG_DEBUG (every step). */
+#define LOG_LEVEL LOG_DEBUG // Runtime log level
+#define LOG_COMPILED_LEVEL LOG_DEBUG // Statements above this level are compiled out
+// #define LOG_BINARY // Write compact binary records instead of text. Decode them with tools/logdecode.cpp
+
 /* Select one of the baseline policies. They all run at maximum frequency but different low-power states */
 #define BASE_USE_R2H_C3
 // #define BASE_USE_R2H_C6 
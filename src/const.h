@@ -36,19 +36,24 @@
 
 #define UPDATE_INTERVAL 1 // How often SleepScale updates its policy
 #define EST_LOOKBACK 10 // How much minutes back the estimator uses to predict the next minute
+#define EST_EWMA_ALPHA 0.5 // Weight of the newest minute in the EWMA predictor of EST_ENSEMBLE
+#define EST_ENSEMBLE_DECAY 0.8 // Per-minute decay of the recent error EST_ENSEMBLE ranks its predictors by
 #define SLEEPSCALE_SLOWDOWN 5 // Slow-down in SleepScale. How much slow-down times baseline. 
 #define SER_TIME 194 // Service time of the underlying workload
 #define JOB_LOG_LENGTH 10000 // Log length. SleepScale will only function with this many jobs in logs
 #define MAX_NUM 1000000000
 #define NO_FREQ 100 // Default number of frequencies supported in the server. 
+#define SWEEP_THREADS 0 // Number of threads simulating policies in SleepScale. 0 uses all hardware threads. 
+#define SWEEP_BLOCK 16 // Maximum number of frequencies simulated together by the multi-frequency kernel
+#define SEARCH_WINDOW 8 // Frequencies above the lowest feasible one checked per step of the policy search
 #define OUTPUT "output" // Name of output log
 #define TRACE_FILE "../traces/msgstore1_mar04" // Path of utilization trace file
 #define SERVICE_CDF "../BigHouseCDFs/csedns.service.cdf" // Path of service time CDF 
 #define ARRIVAL_CDF "../BigHouseCDFs/csedns.arrival.cdf" // Path of arrival time CDF
 
 #define CORE_ACT_MAX_PWR 130 // Set core maximum active power
-#define PLAT_IDLE_PWR 60; // Set platform idle power
-#define PLAT_ACT_MAX_PWR 120; // Set platform maximum active power
+#define PLAT_IDLE_PWR 60 // Set platform idle power
+#define PLAT_ACT_MAX_PWR 120 // Set platform maximum active power
 
 #define WAKEUP_C0i 0 // Wake-up latency for C0i
 #define WAKEUP_C1 10E-3
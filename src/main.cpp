@@ -32,11 +32,125 @@
 
 
 #include "Server.h"
-#include "const.h"
-#include "config.h"
+#include "BatchRunner.h"
+#include "ParameterSweep.h"
+#include "Daemon.h"
+#include "Config.h"
+
+/*
+Usage:
+	SleepScale [options]                          one run
+	SleepScale --batch manifest [options]         every experiment in the manifest (see BatchRunner.h)
+	SleepScale --sweep key=v1,v2,... [key=...] [options]
+	                                              one run per combination of values, in lockstep (see ParameterSweep.h)
+	SleepScale --daemon feed [--decisions file] [options]
+	                                              controller fed by a live utilization stream (see Daemon.h)
+Options:
+	--config file                                 configuration file of key = value lines (see Config.h)
+	--key=value                                   override one configuration key, after the configuration file
+	--jobs N                                      experiments or sweep points run at the same time (batch and sweep, 0 = all cores)
+	--results file                                results table (batch and sweep)
+	--decisions file                              where the daemon writes its decisions, - for stdout (the default)
+	--resume                                      continue a replay from its checkpoint, if there is one (same as --resume=1)
+*/
+static void usage(const char *program){
+	cerr << "Usage: " << program << " [--batch manifest | --sweep key=v1,v2,... [key=...] | --daemon feed [--decisions file]] [--config file] [--key=value ...] [--jobs N] [--results file] [--resume]" << endl;
+	exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+	string manifest;
+	vector<string> sweepSpecs;
+	vector<string> configFiles;
+	vector<string> overrides;
+	int noOfWorkers = 0;
+	string resultsFile;
+	string feed;
+	string decisionsFile = "-";
+
+	for (int i = 1; i < argc; i++){
+		string arg = argv[i];
+		if (arg == "--batch" && i + 1 < argc){
+			manifest = argv[++i];
+		}
+		else if (arg == "--sweep"){
+			while (i + 1 < argc && string(argv[i + 1]).compare(0, 2, "--") != 0){
+				sweepSpecs.push_back(argv[++i]);
+			}
+			if (sweepSpecs.empty()){
+				usage(argv[0]);
+			}
+		}
+		else if (arg == "--daemon" && i + 1 < argc){
+			feed = argv[++i];
+		}
+		else if (arg == "--decisions" && i + 1 < argc){
+			decisionsFile = argv[++i];
+		}
+		else if (arg == "--config" && i + 1 < argc){
+			configFiles.push_back(argv[++i]);
+		}
+		else if (arg == "--jobs" && i + 1 < argc){
+			noOfWorkers = stoi(argv[++i]);
+		}
+		else if (arg == "--results" && i + 1 < argc){
+			resultsFile = argv[++i];
+		}
+		else if (arg == "--resume"){
+			overrides.push_back("resume=1");
+		}
+		else if (isConfigOption(arg)){
+			overrides.push_back(arg);
+		}
+		else {
+			cerr << "Unknown option " << arg << endl;
+			usage(argv[0]);
+		}
+	}
+
+	if ((!manifest.empty()) + (!sweepSpecs.empty()) + (!feed.empty()) > 1){
+		usage(argv[0]);
+	}
+
+	// Compile-time defaults, then the configuration files, then the command line
+	Config config;
+	for (auto &file : configFiles){
+		config.loadFile(file);
+	}
+	for (auto &option : overrides){
+		config.setOption(option);
+	}
+	config.resolveSeed(); // Once, so that every experiment of a batch or sweep sees the same workload
+
+	if (!manifest.empty()){
+		resultsFile = resultsFile.empty() ? "batch_results.tsv" : resultsFile;
+		BatchRunner batch(manifest, config, noOfWorkers);
+		batch.run();
+		batch.writeResults(resultsFile);
+
+		cout << "=================" << endl;
+		cout << "Results of " << batch.getSize() << " experiments are in " << resultsFile << endl;
+		return 0;
+	}
+
+	if (!feed.empty()){
+		Daemon daemon(config, feed, decisionsFile);
+		daemon.run();
+		return 0;
+	}
+
+	if (!sweepSpecs.empty()){
+		resultsFile = resultsFile.empty() ? "sweep_results.tsv" : resultsFile;
+		ParameterSweep sweep(config, sweepSpecs, noOfWorkers);
+		sweep.run();
+		sweep.writeResults(resultsFile);
+
+		cout << "=================" << endl;
+		cout << "Results of " << sweep.getSize() << " points are in " << resultsFile << endl;
+		return 0;
+	}
 
-int main(){
-	
 
 	double baselineER = 0;
 	double baselineEP = 0;
@@ -44,8 +158,8 @@ int main(){
 	double runEP = 0;
 
 
-	Server myServer(OUTPUT, RUN_AS);
-	myServer.run(TRACE_FILE, SERVICE_CDF, ARRIVAL_CDF);
+	Server myServer(config);
+	myServer.run(config.trace, config.serviceCdf, config.arrivalCdf);
 
 
 	runEP = runEP + myServer.EP / myServer.totalRunTime;
@@ -56,12 +170,10 @@ int main(){
 
 
 	cout << "=================" << endl;
-	cout << "runER: " << runER / (SLEEPSCALE_SLOWDOWN * SER_TIME) << endl;
-	cout << "baselineER: " << baselineER / (SLEEPSCALE_SLOWDOWN * SER_TIME) << endl;
+	cout << "runER: " << runER / (config.slowdown * config.serTime) << endl;
+	cout << "baselineER: " << baselineER / (config.slowdown * config.serTime) << endl;
 	cout << "runEP: " << runEP << endl;
 	cout << "baselineEP: " << baselineEP << endl;
 	cout << endl;
 
 }
-
-
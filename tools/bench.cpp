@@ -0,0 +1,453 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Benchmarks of the simulator hot paths. Build from this directory with 
+
+	g++ -std=c++17 -O2 -pthread -I../src bench.cpp $(find ../src -name '*.cpp' ! -name main.cpp) -o bench
+
+Usage: bench [--filter text] [--json file] [--label text] [--min-time seconds] [--traces dir] [--service_cdf file] [--arrival_cdf file] 
+             [--seed N] [--threads N] [--no-micro] [--no-macro]
+
+Micro-benchmarks time one operation in a loop: CDF sampling with each lookup method, Philox uniforms, drawing one minute of jobs, an 
+Estimator observe/estimate step, simQueue and the multi-frequency kernel over the job log, doQueue over one minute of jobs, the 
+sequential and the chunked parallel FCFS loop over one long stream (QueueScan.h, on all hardware threads) and a full doSleepScale 
+step. Macro-benchmarks replay every file in the traces directory end to end with logging off and report simulated minutes and jobs per 
+second. 
+
+Each benchmark is timed in 5 repetitions of a calibrated number of iterations. The median and the minimum time per item are printed 
+and written with the build and run parameters to a JSON file (bench_results.json by default), so runs before and after a change can be 
+compared. --label tags the run, e.g., with the commit. --threads sets sweep_threads of doSleepScale and the replays (default 1, which 
+gives the most stable numbers). Workloads are drawn with a fixed seed, so every run simulates the same jobs. 
+*/
+
+#include "Server.h"
+#include "QueueKernel.h"
+#include "QueueScan.h"
+#include<chrono>
+#include<functional>
+#include<algorithm>
+#include<dirent.h>
+#include<ctime>
+#include<iomanip>
+
+struct BenchResult{
+	string name;
+	string kind; // "micro" or "macro"
+	string unit; // What one item is
+	long iterations = 0; // Operations per repetition
+	double itemsPerOp = 1;
+	double nsPerItemMedian = 0;
+	double nsPerItemMin = 0;
+	vector<pair<string, double>> extra; // Benchmark specific numbers
+};
+
+static const int REPETITIONS = 5;
+
+static double secondsSince(const chrono::steady_clock::time_point &start){
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Run op until it is calibrated to about minTime / REPETITIONS per repetition, then time REPETITIONS repetitions
+static BenchResult timeOperation(const string name, const string unit, double itemsPerOp, double minTime, const function<void()> &op){
+
+	BenchResult result;
+	result.name = name;
+	result.kind = "micro";
+	result.unit = unit;
+	result.itemsPerOp = itemsPerOp;
+
+	// Warm up and calibrate
+	long iterations = 1;
+	while (true){
+		auto start = chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++){
+			op();
+		}
+		double elapsed = secondsSince(start);
+		if (elapsed >= minTime / REPETITIONS / 4){
+			iterations = max(1L, static_cast<long>(iterations * (minTime / REPETITIONS) / elapsed));
+			break;
+		}
+		iterations = iterations * 4;
+	}
+
+	vector<double> nsPerItem;
+	for (int rep = 0; rep < REPETITIONS; rep++){
+		auto start = chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++){
+			op();
+		}
+		nsPerItem.push_back(secondsSince(start) * 1e9 / (iterations * itemsPerOp));
+	}
+	sort(nsPerItem.begin(), nsPerItem.end());
+
+	result.iterations = iterations;
+	result.nsPerItemMedian = nsPerItem.at(REPETITIONS / 2);
+	result.nsPerItemMin = nsPerItem.at(0);
+	return result;
+}
+
+// Utilization trace held in memory that starts over at its end, so the estimator can be stepped forever
+class LoopingTrace : public TraceSource{
+
+private:
+	vector<double> values;
+	long next_ = 0;
+
+public:
+	LoopingTrace(const vector<double> &values) : values(values) {}
+	bool next(double &value) override{
+		value = this->values.at(this->next_ % this->values.size());
+		this->next_++;
+		return true;
+	}
+	long getLineNo() const override{ return this->next_; }
+	string getName() const override{ return "loop"; }
+};
+
+static vector<string> listTraces(const string dirName){
+
+	vector<string> files;
+	DIR *dir = opendir(dirName.c_str());
+	if (dir == nullptr){
+		cerr << "Directory " << dirName << " cannot be opened!" << endl;
+		terminate();
+	}
+	while (dirent *entry = readdir(dir)){
+		string name = entry->d_name;
+		if (name[0] != '.'){
+			files.push_back(dirName + "/" + name);
+		}
+	}
+	closedir(dir);
+	sort(files.begin(), files.end());
+	return files;
+}
+
+static string jsonString(const string &text){
+	string quoted = "\"";
+	for (char c : text){
+		if (c == '"' || c == '\\'){
+			quoted += '\\';
+		}
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+static void writeJson(const string fileName, const vector<BenchResult> &results, const vector<pair<string, string>> &context){
+
+	ofstream out(fileName);
+	if (!out.is_open()){
+		cerr << "File " << fileName << " cannot be opened!" << endl;
+		terminate();
+	}
+	out.precision(6);
+
+	out << "{\n  \"context\": {";
+	for (int i = 0; i < context.size(); i++){
+		out << (i == 0 ? "\n" : ",\n") << "    " << jsonString(context.at(i).first) << ": " << jsonString(context.at(i).second);
+	}
+	out << "\n  },\n  \"benchmarks\": [";
+	for (int i = 0; i < results.size(); i++){
+		const BenchResult &r = results.at(i);
+		out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(r.name) << ", \"kind\": " << jsonString(r.kind) << 
+			", \"unit\": " << jsonString(r.unit) << ", \"iterations\": " << r.iterations << ", \"items_per_op\": " << r.itemsPerOp << 
+			", \"ns_per_item_median\": " << r.nsPerItemMedian << ", \"ns_per_item_min\": " << r.nsPerItemMin << 
+			", \"items_per_second\": " << 1e9 / r.nsPerItemMedian;
+		for (auto &field : r.extra){
+			out << ", " << jsonString(field.first) << ": " << field.second;
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+static void printResult(const BenchResult &r){
+	cout << left << setw(40) << r.name << right << setw(14) << fixed << setprecision(2) << r.nsPerItemMedian << " ns/" << r.unit << 
+		" (min " << r.nsPerItemMin << ")";
+	for (auto &field : r.extra){
+		cout << "  " << field.first << " " << field.second;
+	}
+	cout << defaultfloat << setprecision(6) << endl;
+}
+
+// Clear what doQueue accumulates, so it can run the same minute again
+static void resetServerRun(Server &server){
+	server.prevDepart = -1;
+	server.totalNoOfJobs = 0;
+	server.ER = 0;
+	server.EP = 0;
+	server.totalRunTime = 0;
+	server.opLength = 0;
+	server.offLength = 0;
+	server.overProvision = false;
+	server.bestFreqUsed.clear();
+	server.bestLowpowerUsed.clear();
+}
+
+int main(int argc, char **argv){
+
+	string filter;
+	string jsonFile = "bench_results.json";
+	string label;
+	double minTime = 1.0;
+	string traceDir = "../traces";
+	string serviceCdf = "../BigHouseCDFs/csedns.service.cdf";
+	string arrivalCdf = "../BigHouseCDFs/csedns.arrival.cdf";
+	uint64_t seed = 1;
+	int threads = 1;
+	bool doMicro = true;
+	bool doMacro = true;
+
+	for (int i = 1; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--filter" && hasValue) filter = argv[++i];
+		else if (arg == "--json" && hasValue) jsonFile = argv[++i];
+		else if (arg == "--label" && hasValue) label = argv[++i];
+		else if (arg == "--min-time" && hasValue) minTime = stod(argv[++i]);
+		else if (arg == "--traces" && hasValue) traceDir = argv[++i];
+		else if (arg == "--service_cdf" && hasValue) serviceCdf = argv[++i];
+		else if (arg == "--arrival_cdf" && hasValue) arrivalCdf = argv[++i];
+		else if (arg == "--seed" && hasValue) seed = stoull(argv[++i]);
+		else if (arg == "--threads" && hasValue) threads = stoi(argv[++i]);
+		else if (arg == "--no-micro") doMicro = false;
+		else if (arg == "--no-macro") doMacro = false;
+		else {
+			cerr << "Usage: " << argv[0] << " [--filter text] [--json file] [--label text] [--min-time seconds] [--traces dir] " << 
+				"[--service_cdf file] [--arrival_cdf file] [--seed N] [--threads N] [--no-micro] [--no-macro]" << endl;
+			return 1;
+		}
+	}
+
+	auto selected = [&](const string &name){ return filter.empty() || name.find(filter) != string::npos; };
+
+	vector<string> traces = listTraces(traceDir);
+	auto serDist = loadCdfTable(serviceCdf);
+	auto arrDist = loadCdfTable(arrivalCdf);
+
+	Config config;
+	config.output = "/dev/null";
+	config.logLevel = LOG_OFF;
+	config.sweepThreads = threads;
+	config.seed = seed;
+	config.trace = traces.at(0);
+	config.serviceCdf = serviceCdf;
+	config.arrivalCdf = arrivalCdf;
+
+	vector<BenchResult> results;
+	auto record = [&](const BenchResult &result){
+		printResult(result);
+		results.push_back(result);
+	};
+
+	if (doMicro){
+		const double rho = 0.3;
+		const int noOfSamples = 1 << 16;
+		vector<double> samples(noOfSamples);
+
+		// A server with a full job log drawn at utilization rho, as doSleepScale sees it
+		Server server(config);
+		server.start(config.trace);
+		vector<Job> minuteJobs;
+		int minute = 0;
+		while (!server.jobLog.readyForSleepScale()){
+			minuteJobs.clear();
+			drawWorkloadCDF(*serDist, *arrDist, minute, rho, seed, minuteJobs);
+			server.jobLog.insertNewJobVector(minuteJobs, 0, minuteJobs.size());
+			minute++;
+		}
+		server.estimator->est = rho;
+		minuteJobs.clear();
+		drawWorkloadCDF(*serDist, *arrDist, 0, rho, seed, minuteJobs);
+
+		JobStreamView logView;
+		logView.arrival = server.jobLog.getArrivals();
+		logView.service = server.jobLog.getServices();
+		logView.noOfJobs = server.jobLog.getSize();
+
+		const pair<EmpiricalDistribution::Method, string> methods[] = { { EmpiricalDistribution::BINARY_SEARCH, "binary_search" }, 
+			{ EmpiricalDistribution::GUIDE_TABLE, "guide_table" }, { EmpiricalDistribution::ALIAS_TABLE, "alias_table" } };
+		for (auto &method : methods){
+			string name = "cdf_draw_" + method.second;
+			if (selected(name)){
+				RandomStream stream(seed, 0, STREAM_SERVICE);
+				record(timeOperation(name, "sample", noOfSamples, minTime, [&](){
+					serDist->drawBatch(stream, samples.data(), noOfSamples, method.first);
+				}));
+			}
+		}
+
+		if (selected("philox_uniform")){
+			RandomStream stream(seed, 0, STREAM_SERVICE);
+			record(timeOperation("philox_uniform", "uniform", noOfSamples, minTime, [&](){
+				stream.uniform(samples.data(), noOfSamples);
+			}));
+		}
+
+		if (selected("draw_workload_minute")){
+			vector<Job> jobs;
+			int offset = 0;
+			record(timeOperation("draw_workload_minute", "job", minuteJobs.size(), minTime, [&](){
+				jobs.clear();
+				drawWorkloadCDF(*serDist, *arrDist, offset++, rho, seed, jobs);
+			}));
+		}
+
+		if (selected("estimator_step")){
+			vector<double> utilization;
+			auto trace = openTraceSource(config.trace, TRACE_MMAP);
+			double value;
+			while (trace->next(value)){
+				utilization.push_back(value);
+			}
+			LoopingTrace loop(utilization);
+			Estimator estimator(config.estLookback, server.logOut);
+			record(timeOperation("estimator_step", "minute", 1, minTime, [&](){
+				estimator.estimateRho(server.logOut);
+				estimator.observeRho(loop, server.logOut);
+			}));
+		}
+
+		// A C3 policy at half speed, a typical pick
+		shared_ptr<PowerState> policy = server.allPolicy.at(1);
+		for (auto &candidate : server.allPolicy){
+			if (candidate->idle == "C3" && abs(candidate->freq - 0.5) < abs(policy->freq - 0.5)){
+				policy = candidate;
+			}
+		}
+
+		if (selected("sim_queue")){
+			PolicyResult slot;
+			record(timeOperation("sim_queue", "job", logView.noOfJobs, minTime, [&](){
+				server.simQueue(policy, logView, slot);
+			}));
+		}
+
+		if (selected("sim_queue_multi_freq")){
+			int lanes = server.frequency.size();
+			vector<double> ER(lanes), opLength(lanes), offLength(lanes);
+			BenchResult result = timeOperation("sim_queue_multi_freq", "job_x_freq", static_cast<double>(logView.noOfJobs) * lanes, minTime, [&](){
+				simQueueMultiFreq(logView.arrival, logView.service, logView.noOfJobs, server.frequency.data(), lanes, config.wakeUpC3, 
+					ER.data(), opLength.data(), offLength.data(), nullptr);
+			});
+			result.extra.push_back({ "lanes", lanes });
+			record(result);
+		}
+
+		if (selected("do_queue")){
+			record(timeOperation("do_queue", "job", minuteJobs.size(), minTime, [&](){
+				resetServerRun(server);
+				server.doQueue(policy, minuteJobs);
+			}));
+		}
+
+		if (selected("queue_sequential_long") || selected("queue_scan_long")){
+			// One long stream, as a high-rate trace would queue in a minute
+			vector<Job> longStream;
+			for (int offset = 0; longStream.size() < PARALLEL_SCAN_MIN_JOBS; offset++){
+				drawWorkloadCDF(*serDist, *arrDist, offset, rho, seed, longStream);
+			}
+			ThreadPool scanPool(0);
+			if (selected("queue_sequential_long")){
+				record(timeOperation("queue_sequential_long", "job", longStream.size(), minTime, [&](){
+					QueueTotals totals;
+					simQueueSequential(longStream.data(), longStream.size(), policy->freq, policy->wakeUp, totals);
+				}));
+			}
+			if (selected("queue_scan_long")){
+				BenchResult result = timeOperation("queue_scan_long", "job", longStream.size(), minTime, [&](){
+					QueueTotals totals;
+					simQueueScan(longStream.data(), longStream.size(), policy->freq, policy->wakeUp, scanPool, totals);
+				});
+				result.extra.push_back({ "threads", scanPool.getSize() });
+				record(result);
+			}
+		}
+
+		if (selected("do_sleepscale")){
+			double jobsTimesPolicies = static_cast<double>(logView.noOfJobs) * server.allPolicy.size();
+			BenchResult result = timeOperation("do_sleepscale", "step", 1, minTime, [&](){
+				server.doSleepScale();
+			});
+			result.extra.push_back({ "policies", server.allPolicy.size() });
+			result.extra.push_back({ "ns_per_job_x_policy", result.nsPerItemMedian / jobsTimesPolicies });
+			record(result);
+		}
+
+		server.finish();
+	}
+
+	if (doMacro){
+		for (auto &trace : traces){
+			string name = "replay_" + trace.substr(trace.find_last_of('/') + 1);
+			if (!selected(name)){
+				continue;
+			}
+
+			Config replayConfig = config;
+			replayConfig.trace = trace;
+			Server server(replayConfig);
+			auto start = chrono::steady_clock::now();
+			server.run(trace, *serDist, *arrDist);
+			double seconds = secondsSince(start);
+
+			BenchResult result;
+			result.name = name;
+			result.kind = "macro";
+			result.unit = "minute";
+			result.iterations = 1;
+			result.itemsPerOp = server.minute;
+			result.nsPerItemMedian = seconds * 1e9 / server.minute;
+			result.nsPerItemMin = result.nsPerItemMedian;
+			result.extra.push_back({ "seconds", seconds });
+			result.extra.push_back({ "minutes_per_second", server.minute / seconds });
+			result.extra.push_back({ "jobs_per_second", server.totalNoOfJobs / seconds });
+			result.extra.push_back({ "sleepscale_steps", server.noOfSleepScale });
+			record(result);
+		}
+	}
+
+	time_t now = time(nullptr);
+	char date[32];
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	vector<pair<string, string>> context = { { "label", label }, { "date", date }, { "compiler", __VERSION__ }, 
+		{ "queue_kernel", queueKernelName() }, { "min_time", to_string(minTime) }, { "seed", to_string(seed) }, 
+		{ "threads", to_string(threads) }, { "service_cdf", serviceCdf }, { "arrival_cdf", arrivalCdf } };
+	writeJson(jsonFile, results, context);
+	cout << "Results are in " << jsonFile << endl;
+
+	return 0;
+}
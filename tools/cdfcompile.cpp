@@ -0,0 +1,157 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Compile a text BigHouse CDF into the binary format of CompiledCdf.h, which SleepScale maps instead of parsing. Build from this directory with 
+
+	g++ -std=c++17 -O2 -I../src cdfcompile.cpp ../src/CompiledCdf.cpp ../src/EmpiricalDistribution.cpp ../src/Philox.cpp -o cdfcompile
+
+Usage: cdfcompile <text cdf> <compiled cdf> [--scale S] [--unit U]
+Every line of the text CDF is "sample cumulative_probability". Samples are multiplied by S. Without --scale, S follows the rule SleepScale 
+applies to text CDFs (1000 for search.service.cdf, 16000 for search.arrival.cdf, 1 otherwise), and the choice is printed. U defaults to ms. 
+The CDF is rejected unless samples and probabilities are non-decreasing and the probabilities lie in [0, 1]. If the probabilities stop 
+short of 1, the rest of the mass goes to the last bucket when sampling; the converter reports it and records it in the header. 
+*/
+
+#include "CompiledCdf.h"
+#include "EmpiricalDistribution.h"
+#include<iostream>
+#include<fstream>
+#include<cstring>
+#include<charconv>
+
+// Parse the next number of a line. False if there is none.
+static bool parseField(const char *&cur, const char *end, double &value){
+	while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\r')){
+		cur++;
+	}
+	if (cur < end && *cur == '+'){
+		cur++;
+	}
+	auto parsed = from_chars(cur, end, value);
+	if (parsed.ec != errc()){
+		return false;
+	}
+	cur = parsed.ptr;
+	return true;
+}
+
+int main(int argc, char **argv){
+
+	if (argc < 3){
+		cerr << "Usage: " << argv[0] << " <text cdf> <compiled cdf> [--scale S] [--unit U]" << endl;
+		return 1;
+	}
+
+	string input = argv[1];
+	string output = argv[2];
+	double scale = bigHouseCdfScale(input);
+	bool scaleGiven = false;
+	string unit = "ms";
+
+	for (int i = 3; i < argc; i++){
+		string arg = argv[i];
+		if (arg.compare("--scale") == 0 && i + 1 < argc){
+			scale = stod(argv[++i]);
+			scaleGiven = true;
+		}
+		else if (arg.compare("--unit") == 0 && i + 1 < argc){
+			unit = argv[++i];
+		}
+		else {
+			cerr << "Unknown option " << arg << endl;
+			return 1;
+		}
+	}
+
+	if (unit.size() >= sizeof(CompiledCdfHeader::unit)){
+		cerr << "Unit " << unit << " is too long" << endl;
+		return 1;
+	}
+
+	ifstream in(input);
+	if (!in.is_open()){
+		cerr << "File " << input << " cannot be opened!" << endl;
+		return 1;
+	}
+
+	vector<double> sample;
+	vector<double> prob;
+	string line;
+	int lineNo = 0;
+	while (getline(in, line)){
+		lineNo++;
+		const char *cur = line.data();
+		const char *end = line.data() + line.size();
+		double s, p;
+
+		if (line.find_first_not_of(" \t\r") == string::npos){
+			continue;
+		}
+		if (!parseField(cur, end, s) || !parseField(cur, end, p)){
+			cerr << input << ":" << lineNo << ": expected \"sample probability\" but got " << line << endl;
+			return 1;
+		}
+		sample.push_back(scale * s);
+		prob.push_back(p);
+	}
+
+	string error = checkCdf(sample, prob);
+	if (!error.empty()){
+		cerr << input << " is not a valid CDF: " << error << endl;
+		return 1;
+	}
+
+	EmpiricalDistribution dist(sample, prob);
+
+	CompiledCdfHeader header = {};
+	header.scale = scale;
+	header.mean = dist.getMean();
+	header.secondMoment = dist.getSecondMoment();
+	header.minSample = sample.front();
+	header.maxSample = sample.back();
+	header.tailMass = 1 - prob.back();
+	strncpy(header.unit, unit.c_str(), sizeof(header.unit) - 1);
+	string base = input.substr(input.find_last_of('/') + 1);
+	strncpy(header.source, base.c_str(), sizeof(header.source) - 1);
+
+	writeCompiledCdf(output, sample, prob, header);
+
+	cout << input << ": " << sample.size() << " rows, scale " << scale << (scaleGiven ? "" : " (from the file name)") << ", unit " << unit << 
+		", mean " << header.mean << ", second moment " << header.secondMoment << ", range [" << header.minSample << ", " << header.maxSample << "]" << endl;
+	if (header.tailMass > 1e-6){
+		cout << "Warning: the probabilities end at " << prob.back() << ". The remaining " << header.tailMass << " goes to the last bucket." << endl;
+	}
+	cout << "Written to " << output << endl;
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Decode a binary SleepScale log (LOG_BINARY in config.h) into the text log. Build from this directory with 
+
+	g++ -std=c++17 -O2 -pthread -I../src logdecode.cpp ../src/Logger.cpp -o logdecode
+
+Usage: logdecode <binary log> [--time] [--level N]
+--time prefixes every line with the milliseconds since the logger was opened. --level drops records above level N. 
+*/
+
+#include "Logger.h"
+#include<iomanip>
+
+int main(int argc, char **argv){
+
+	if (argc < 2){
+		cerr << "Usage: " << argv[0] << " <binary log> [--time] [--level N]" << endl;
+		return 1;
+	}
+
+	bool showTime = false;
+	int maxLevel = LOG_DEBUG;
+	for (int i = 2; i < argc; i++){
+		string arg = argv[i];
+		if (arg.compare("--time") == 0){
+			showTime = true;
+		}
+		else if (arg.compare("--level") == 0 && i + 1 < argc){
+			maxLevel = stoi(argv[++i]);
+		}
+	}
+
+	ifstream in(argv[1], ios::binary);
+	if (!in.is_open()){
+		cerr << "File " << argv[1] << " cannot be opened!" << endl;
+		return 1;
+	}
+
+	char magic[8];
+	if (!in.read(magic, 8) || memcmp(magic, Logger::BINARY_MAGIC, 8) != 0){
+		cerr << argv[1] << " is not a binary SleepScale log" << endl;
+		return 1;
+	}
+
+	char header[Logger::HEADER_SIZE];
+	string payload;
+	vector<string> dictionary;
+	while (in.read(header, Logger::HEADER_SIZE)){
+		uint32_t length;
+		uint8_t level;
+		uint64_t time;
+		memcpy(&length, header, 4);
+		memcpy(&level, header + 4, 1);
+		memcpy(&time, header + 5, 8);
+
+		payload.resize(length);
+		if (!in.read(&payload[0], length)){
+			cerr << "Truncated record at the end of the log" << endl;
+			return 1;
+		}
+
+		if (level == Logger::DICTIONARY_RECORD){
+			dictionary.push_back(payload);
+			continue;
+		}
+		if (level > maxLevel){
+			continue;
+		}
+		if (showTime){
+			cout << fixed << setprecision(3) << time / 1e6 << defaultfloat << setprecision(6) << " ";
+		}
+		Logger::formatPayload(payload.data(), length, cout, dictionary);
+		cout << '\n';
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Export a SleepScale metrics file (metrics key, MinuteMetrics.h) as CSV with a header line. Build from this directory with 
+
+	g++ -std=c++17 -O2 -I../src metricsexport.cpp ../src/MinuteMetrics.cpp -o metricsexport
+
+Usage: metricsexport <metrics file> [csv file]
+Without a CSV file the rows go to stdout. idle_state is the IdleState enum of PowerState.h: 0 C0i, 1 C1, 2 C3, 3 C6, 4 DVFS_only. 
+*/
+
+#include "MinuteMetrics.h"
+#include<iostream>
+#include<fstream>
+
+int main(int argc, char **argv){
+
+	if (argc < 2 || argc > 3){
+		cerr << "Usage: " << argv[0] << " <metrics file> [csv file]" << endl;
+		return 1;
+	}
+
+	if (argc == 3){
+		ofstream out(argv[2]);
+		if (!out.is_open()){
+			cerr << "File " << argv[2] << " cannot be opened!" << endl;
+			return 1;
+		}
+		exportMetricsCsv(argv[1], out);
+		return 0;
+	}
+
+	exportMetricsCsv(argv[1], cout);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Known-answer check of the workload random numbers (Philox.h). Every reproducible result depends on them, so run it after touching 
+Philox.cpp or the compiler flags. Build and run from this directory with 
+
+	g++ -std=c++17 -O2 -I../src philoxkat.cpp ../src/Philox.cpp -o philoxkat && ./philoxkat
+
+Checks: 
+	Philox4x32::block   against the Philox4x32-10 known-answer vectors of the reference implementation (Random123, kat_vectors)
+	Philox4x32::blocks  against block, over a range of counters that carries from c0 into c1, at every offset within the lanes
+	RandomStream        uniform(double *, int) against as many calls of uniform(), across several buffer refills
+
+Prints every mismatch and exits with 1 if there is any. 
+*/
+
+#include "Philox.h"
+#include<iostream>
+#include<iomanip>
+#include<vector>
+
+struct KnownAnswer{
+	uint32_t counter[4];
+	uint32_t key[2];
+	uint32_t expected[4];
+};
+
+static const KnownAnswer knownAnswers[] = {
+	{ { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+	{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+	{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+};
+
+static void printWords(const uint32_t *words){
+	cout << hex << setfill('0');
+	for (int i = 0; i < 4; i++){
+		cout << " " << setw(8) << words[i];
+	}
+	cout << dec << setfill(' ');
+}
+
+int main(){
+
+	int failures = 0;
+
+	for (auto &kat : knownAnswers){
+		uint32_t out[4];
+		Philox4x32::block(kat.counter, kat.key, out);
+		for (int i = 0; i < 4; i++){
+			if (out[i] != kat.expected[i]){
+				cout << "block: counter";
+				printWords(kat.counter);
+				cout << " gives";
+				printWords(out);
+				cout << ", expected";
+				printWords(kat.expected);
+				cout << endl;
+				failures++;
+				break;
+			}
+		}
+	}
+
+	// Bulk blocks start at any offset and carry from the low into the high counter word
+	const uint32_t key[2] = { 0x9e3779b9, 0x7f4a7c15 };
+	const uint32_t c2 = 17;
+	const uint32_t c3 = 3;
+	const int noOfBlocks = 37; // Not a multiple of the lanes, so the tail is covered
+	for (int offset = 0; offset < 16; offset++){
+		uint64_t first = 0xffffffffULL - 20 + offset;
+		vector<uint32_t> bulk(4 * noOfBlocks);
+		Philox4x32::blocks(first, noOfBlocks, c2, c3, key, bulk.data());
+		for (int b = 0; b < noOfBlocks; b++){
+			uint64_t n = first + b;
+			uint32_t counter[4] = { static_cast<uint32_t>(n), static_cast<uint32_t>(n >> 32), c2, c3 };
+			uint32_t out[4];
+			Philox4x32::block(counter, key, out);
+			for (int i = 0; i < 4; i++){
+				if (bulk[4 * b + i] != out[i]){
+					cout << "blocks: block " << n << " word " << i << " is " << bulk[4 * b + i] << ", block gives " << out[i] << endl;
+					failures++;
+					break;
+				}
+			}
+		}
+	}
+
+	// The bulk uniforms are the same numbers as one at a time
+	const int noOfUniforms = 1000;
+	RandomStream one(12345, 42, STREAM_SERVICE);
+	RandomStream bulk(12345, 42, STREAM_SERVICE);
+	vector<double> uniforms(noOfUniforms);
+	bulk.uniform(uniforms.data(), 7);
+	bulk.uniform(uniforms.data() + 7, noOfUniforms - 7);
+	for (int i = 0; i < noOfUniforms; i++){
+		double u = one.uniform();
+		if (u != uniforms[i] || u < 0 || u >= 1){
+			cout << "RandomStream: uniform " << i << " is " << u << " one at a time and " << uniforms[i] << " in bulk" << endl;
+			failures++;
+			break;
+		}
+	}
+
+	if (failures > 0){
+		cout << failures << " checks failed" << endl;
+		return 1;
+	}
+	cout << "Philox4x32-10 matches the known answers" << endl;
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+
+/*
+Compile a policy table (PolicyTable.h): the best policy at every utilization of a grid, for the CDFs and parameters of a configuration. 
+Build from this directory with 
+
+	g++ -std=c++17 -O2 -pthread -I../src policycompile.cpp $(find ../src -name '*.cpp' ! -name main.cpp) -o policycompile
+
+Usage: policycompile <table> [--rho_min R] [--rho_max R] [--rho_step S] [--log_jobs N] [--config file] [--key=value ...]
+The configuration is read as by SleepScale. At each utilization rho_min, rho_min + S, ..., rho_max (default 0.01 to 0.99 in steps of 
+0.01) a job log of N jobs (default JOB_LOG_LENGTH) is drawn from service_cdf and arrival_cdf with seed, every policy is simulated on it 
+by the same sweep doSleepScale runs, and the winner is recorded. Every utilization uses the same random numbers, so the table changes 
+only where the load does. Run SleepScale with --policy_table=<table> and the same parameters to use it. 
+*/
+
+#include "Server.h"
+#include "PolicyTable.h"
+#include "Config.h"
+#include<iostream>
+#include<cstring>
+#include<cmath>
+
+int main(int argc, char **argv){
+
+	if (argc < 2){
+		cerr << "Usage: " << argv[0] << " <table> [--rho_min R] [--rho_max R] [--rho_step S] [--log_jobs N] [--config file] [--key=value ...]" << endl;
+		return 1;
+	}
+
+	string output = argv[1];
+	double rhoMin = 0.01;
+	double rhoMax = 0.99;
+	double rhoStep = 0.01;
+	int logJobs = JOB_LOG_LENGTH;
+	vector<string> configFiles;
+	vector<string> overrides;
+
+	for (int i = 2; i < argc; i++){
+		string arg = argv[i];
+		if (arg.compare("--rho_min") == 0 && i + 1 < argc){
+			rhoMin = stod(argv[++i]);
+		}
+		else if (arg.compare("--rho_max") == 0 && i + 1 < argc){
+			rhoMax = stod(argv[++i]);
+		}
+		else if (arg.compare("--rho_step") == 0 && i + 1 < argc){
+			rhoStep = stod(argv[++i]);
+		}
+		else if (arg.compare("--log_jobs") == 0 && i + 1 < argc){
+			logJobs = stoi(argv[++i]);
+		}
+		else if (arg.compare("--config") == 0 && i + 1 < argc){
+			configFiles.push_back(argv[++i]);
+		}
+		else if (isConfigOption(arg)){
+			overrides.push_back(arg);
+		}
+		else {
+			cerr << "Unknown option " << arg << endl;
+			return 1;
+		}
+	}
+
+	if (rhoMin <= 0 || rhoMax >= 1 || rhoMax < rhoMin || rhoStep <= 0 || logJobs < 1){
+		cerr << "Need 0 < rho_min <= rho_max < 1, rho_step > 0 and log_jobs >= 1" << endl;
+		return 1;
+	}
+
+	Config config;
+	for (auto &file : configFiles){
+		config.loadFile(file);
+	}
+	for (auto &option : overrides){
+		config.setOption(option);
+	}
+	config.resolveSeed();
+	config.output = "/dev/null";
+	config.logLevel = LOG_OFF;
+	config.policyTable = "";
+
+	auto serDist = loadCdfTable(config.serviceCdf);
+	auto arrDist = loadCdfTable(config.arrivalCdf);
+	Server server(config);
+
+	int noOfEntries = static_cast<int>(round((rhoMax - rhoMin) / rhoStep)) + 1;
+	vector<PolicyTableEntry> entries(noOfEntries);
+	for (int e = 0; e < noOfEntries; e++){
+		double rho = rhoMin + e * rhoStep;
+
+		// Whole minutes until the log is full, of which the last logJobs jobs are kept, as in the job log
+		vector<Job> jobs;
+		for (int minute = 0; jobs.size() < logJobs; minute++){
+			drawWorkloadCDF(*serDist, *arrDist, minute, rho, config.seed, jobs);
+		}
+		int first = jobs.size() - logJobs;
+
+		server.sweepArrival.resize(logJobs);
+		server.sweepService.resize(logJobs);
+		double arrival = 0;
+		for (int job = 0; job < logJobs; job++){
+			arrival = arrival + jobs.at(first + job).gapFromPrevious;
+			server.sweepArrival.at(job) = arrival;
+			server.sweepService.at(job) = jobs.at(first + job).service;
+		}
+		JobStreamView jobStream;
+		jobStream.arrival = server.sweepArrival.data();
+		jobStream.service = server.sweepService.data();
+		jobStream.noOfJobs = logJobs;
+
+		shared_ptr<PowerState> bestPolicy = server.sweepPolicies(jobStream);
+
+		PolicyTableEntry &entry = entries.at(e);
+		entry = {};
+		entry.rho = rho;
+		entry.freq = bestPolicy->freq;
+		entry.EP = bestPolicy->EP;
+		entry.ER = bestPolicy->ER;
+		strncpy(entry.idle, bestPolicy->idle.c_str(), sizeof(entry.idle) - 1);
+		entry.feasible = server.meetsTarget(bestPolicy->ER, bestPolicy->overTarget);
+
+		cout << "rho " << rho << ": f = " << entry.freq << ", " << entry.idle << ", EP " << entry.EP << " Watt, ER " << entry.ER << " ms" << 
+			(entry.feasible ? "" : " (no policy meets the target)") << endl;
+	}
+
+	string serviceBase = config.serviceCdf.substr(config.serviceCdf.find_last_of('/') + 1);
+	string arrivalBase = config.arrivalCdf.substr(config.arrivalCdf.find_last_of('/') + 1);
+
+	PolicyTableHeader header = {};
+	header.rhoMin = rhoMin;
+	header.rhoStep = rhoStep;
+	header.configHash = policyConfigHash(config);
+	header.seed = config.seed;
+	header.jobsPerEntry = logJobs;
+	header.noFreq = config.noFreq;
+	header.slowdown = config.slowdown;
+	header.serTime = config.serTime;
+	strncpy(header.runAs, config.runAs.c_str(), sizeof(header.runAs) - 1);
+	strncpy(header.serviceCdf, serviceBase.c_str(), sizeof(header.serviceCdf) - 1);
+	strncpy(header.arrivalCdf, arrivalBase.c_str(), sizeof(header.arrivalCdf) - 1);
+
+	writePolicyTable(output, header, entries);
+
+	cout << noOfEntries << " utilizations from " << rhoMin << " to " << rhoMin + (noOfEntries - 1) * rhoStep << ", " << logJobs << 
+		" jobs each, seed " << config.seed << ". Written to " << output << endl;
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2014 The Regents of University of Wisconsin Madison
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met: redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer;
+* redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution;
+* neither the name of the copyright holders nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* @author Yanpei Liu (yliu73@wisc.edu)
+*
+*/
+
+
+/*
+Check a parameter sweep against solo runs. Runs the sweep, then every point on its own, and compares the results exactly. Points 
+reuse the policy simulations of a leader (ParameterSweep.h), so a mismatch means the sweep shared simulations it should not have. 
+Build from this directory with 
+
+	g++ -std=c++17 -O2 -pthread -I../src sweepcheck.cpp $(find ../src -name '*.cpp' ! -name main.cpp) -o sweepcheck
+
+Usage: sweepcheck [--config file] [--key=value ...] key=v1,v2,... [key=...]
+e.g., from src/: ../tools/sweepcheck --seed=7 --log_level=off --slowdown=3 slo_percentile=0,99
+Exits with 1 if any point differs from its solo run. Fix the seed; otherwise it is drawn once and logged with the configuration. 
+*/
+
+#include "ParameterSweep.h"
+#include "Server.h"
+#include<iostream>
+
+int main(int argc, char **argv){
+
+	Config config;
+	vector<string> sweepSpecs;
+	for (int i = 1; i < argc; i++){
+		string arg = argv[i];
+		if (arg == "--config" && i + 1 < argc){
+			config.loadFile(argv[++i]);
+		}
+		else if (arg.compare(0, 2, "--") == 0){
+			config.setOption(arg);
+		}
+		else {
+			sweepSpecs.push_back(arg);
+		}
+	}
+
+	if (sweepSpecs.empty()){
+		cerr << "Usage: " << argv[0] << " [--config file] [--key=value ...] key=v1,v2,... [key=...]" << endl;
+		return 1;
+	}
+	config.resolveSeed();
+
+	ParameterSweep sweep(config, sweepSpecs, 0);
+	sweep.run();
+
+	int mismatches = 0;
+	for (int p = 0; p < sweep.getSize(); p++){
+		Config point = sweep.getPoint(p);
+		point.output = point.output + ".solo";
+		if (!point.metrics.empty()){
+			point.metrics = point.metrics + ".solo";
+		}
+
+		Server server(point);
+		server.run(point.trace, point.serviceCdf, point.arrivalCdf);
+		ExperimentResult solo = collectResult(server, 0);
+		const ExperimentResult &swept = sweep.getResult(p);
+
+		bool same = solo.noOfMinutes == swept.noOfMinutes && solo.noOfJobs == swept.noOfJobs && solo.runER == swept.runER && 
+			solo.baselineER == swept.baselineER && solo.runEP == swept.runEP && solo.baselineEP == swept.baselineEP;
+		mismatches = mismatches + !same;
+
+		cout << "Point " << p << " (" << point.output << "): " << (same ? "matches" : "DIFFERS from") << " its solo run" << endl;
+		if (!same){
+			cout << "	sweep: runER " << swept.runER << ", runEP " << swept.runEP << ", baselineER " << swept.baselineER << ", baselineEP " << swept.baselineEP << endl;
+			cout << "	solo:  runER " << solo.runER << ", runEP " << solo.runEP << ", baselineER " << solo.baselineER << ", baselineEP " << solo.baselineEP << endl;
+		}
+	}
+
+	cout << mismatches << " of " << sweep.getSize() << " points differ from their solo runs" << endl;
+	return mismatches > 0 ? 1 : 0;
+}